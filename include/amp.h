@@ -0,0 +1,161 @@
+#ifndef AMP_H
+#define AMP_H
+
+#include <stddef.h>
+#include <effects_dsp.h>
+
+// Tube preamp: a chain of triode stages run at an oversampled rate.
+//
+// A PreampVoicing describes one amp channel as data: per stage the tube, how hard the previous
+// stage drives its grid, its cathode-bypass shelf and the coupling cap after it, plus where the
+// gain knob and the tone stack sit. preamp_set_voicings compiles every channel up front into a
+// fixed stage graph with shared tube tables and its own tone stack, so the per-sample path is the
+// same loop over stages for every channel and switching channels is an index change.
+//
+// Each stage is drive, tube table (build_triode_table, unity small-signal gain, so drive carries
+// the previous stage's gain), cathode shelf, coupling high-pass.
+
+#define PREAMP_MAX_STAGES 5
+#define PREAMP_TABLE_SIZE 2048
+#define PREAMP_CHUNK 256
+
+typedef struct {
+  TubeParams tube;
+  float tableRange;     // the table covers +-tableRange grid volts around the bias
+  float drive;          // grid volts per unit of the previous stage's output (the input's, for stage 0)
+  float cathodeHz;      // bypass cap corner
+  float cathodeDb;      // gain given up below it, <= 0; 0 for a fully bypassed cathode
+  float couplingHz;     // coupling cap into the next stage
+} PreampStageVoicing;
+
+typedef struct {
+  size_t numStages;
+  PreampStageVoicing stages[PREAMP_MAX_STAGES];
+  size_t gainStage;     // the gain knob scales this stage's drive
+  size_t toneStage;     // the tone stack follows this stage
+  float outputLevel;
+  ToneStackType toneStack;
+} PreampVoicing;
+
+typedef struct {
+  const float* table;   // from tube_table_acquire
+  float drive;          // voicing drive / tableRange, gain knob included
+  Biquad cathode;
+  OnePole coupling;
+} PreampStage;
+
+// one compiled voicing
+typedef struct {
+  PreampVoicing voicing;
+  PreampStage stages[PREAMP_MAX_STAGES];
+  ToneStack tone;       // at the oversampled rate
+} PreampChannel;
+
+typedef struct {
+  Oversampler os;
+  size_t factor;
+  float sampleRate;
+  float* scratch;       // PREAMP_CHUNK * factor
+  PreampChannel* channels;
+  size_t numChannels;
+  PreampChannel* channel;   // the selected one, NULL before preamp_set_voicings
+  Biquad presence;      // at the output, base rate
+  float gain;           // knob positions as last applied
+  float bassKnob;
+  float midKnob;
+  float trebleKnob;
+  float presenceKnob;
+} Preamp;
+
+// factor 1, 2, 4 or 8
+int preamp_init(Preamp* p, float sampleRate, size_t factor);
+void preamp_free(Preamp* p);
+void preamp_reset(Preamp* p);
+// Compiles every voicing, taking tube tables and tone stack surfaces from the shared caches, and
+// selects the first. Allocates and may build tables, so call it outside the audio callback.
+// Returns 0 on success, -1 otherwise.
+int preamp_set_voicings(Preamp* p, const PreampVoicing* voicings, size_t count);
+// Switches to a compiled voicing; no locks or allocation, safe in the audio callback
+void preamp_select_voicing(Preamp* p, size_t index);
+// all 0 to 1, like the pots they stand for; presence flat at 0.5
+void preamp_set_controls(Preamp* p, float gain, float bass, float mid, float treble, float presence);
+// any n, in and out may alias
+void preamp_process(Preamp* p, const float* in, float* out, size_t n);
+size_t preamp_latency(const Preamp* p);
+
+// Push-pull power stage: two halves of one tube table driven in antiphase, out = (T(s + v) -
+// T(s - v)) / 2, so even harmonics and DC cancel and a cold bias s shows up as crossover.
+//
+// Sag and bias shift are not solved per sample. A supply envelope follows the mean output
+// magnitude once per control interval; each control point sets a headroom (the stage clips at
+// headroom times its usual level) and a bias (colder as the supply works harder), and both ramp
+// linearly to the next control point. Presence and depth are the bands where the negative
+// feedback loop is backed off, so they are shelves ahead of the tubes: raising them adds level and
+// drive in their band.
+
+#define POWERAMP_TABLE_SIZE 2048
+#define POWERAMP_CHUNK 256
+#define POWERAMP_CONTROL_INTERVAL 32    // base-rate samples between sag/bias updates
+
+typedef struct {
+  TubeStageType stage;
+  TubeParams tube;
+  float tableRange;     // the table covers +-tableRange grid volts around the bias
+  float drive;          // grid volts for a full-scale input at full master volume
+  float biasRange;      // grid volts the bias knob moves either way from the tube's bias
+  float feedbackDb;     // loop gain presence and depth can give back in their bands
+  float sagAttackMs;    // supply droop under load: rectifier and filter caps
+  float sagReleaseMs;
+} PowerAmpVoicing;
+
+// one voicing with its table acquired
+typedef struct {
+  PowerAmpVoicing voicing;
+  const float* table;   // from tube_table_acquire
+  float outputScale;    // full push-pull swing to 1
+} PowerAmpChannel;
+
+typedef struct {
+  Oversampler os;
+  size_t factor;
+  float sampleRate;
+  float* scratch;       // POWERAMP_CHUNK * factor, three runs: signal, push grid, pull grid
+  PowerAmpChannel* channels;
+  size_t numChannels;
+  PowerAmpChannel* channel; // the selected one, NULL before poweramp_set_voicings
+  Biquad presence;      // base rate, ahead of the upsampler
+  Biquad depth;
+  float master;         // knob positions as last applied
+  float sag;
+  float presenceKnob;
+  float depthKnob;
+  float bias;
+  float drive;          // per unit of input, in table units
+  float biasShift;      // knob bias, table units
+  float envelope;       // supply load, about 1 flat out
+  float attackCoeff;
+  float releaseCoeff;
+  float headroom;       // current ramp values and their per-sample steps
+  float headroomStep;
+  float shift;
+  float shiftStep;
+  size_t countdown;     // oversampled samples to the next control point
+  float load;           // output magnitude summed since the last one
+} PowerAmp;
+
+// factor 1, 2, 4 or 8
+int poweramp_init(PowerAmp* p, float sampleRate, size_t factor);
+void poweramp_free(PowerAmp* p);
+void poweramp_reset(PowerAmp* p);
+// Takes every voicing's table from the shared cache, building it on first use, and selects the
+// first. Call it outside the audio callback. Returns 0 on success, -1 otherwise.
+int poweramp_set_voicings(PowerAmp* p, const PowerAmpVoicing* voicings, size_t count);
+// Switches to an acquired voicing; no locks or allocation, safe in the audio callback
+void poweramp_select_voicing(PowerAmp* p, size_t index);
+// all 0 to 1; bias nominal at 0.5, colder below
+void poweramp_set_controls(PowerAmp* p, float master, float sag, float presence, float depth, float bias);
+// any n, in and out may alias
+void poweramp_process(PowerAmp* p, const float* in, float* out, size_t n);
+size_t poweramp_latency(const PowerAmp* p);
+
+#endif
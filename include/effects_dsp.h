@@ -6,6 +6,8 @@
 #include <math.h>
 #include <simde/x86/avx2.h>
 #include <logger.h>
+#include <fast_math.h>
+#include <fft.h>
 
 #ifndef SIMD_WIDTH
 #ifdef __AVX512F__
@@ -23,13 +25,38 @@
 #endif
 #endif
 
+// every vector kernel is written against simde__m256, so this is fixed regardless of SIMD_WIDTH
+#define SIMD_LANES 8
+
+#ifndef DSP_BANK_MAX_CHANNELS
+#define DSP_BANK_MAX_CHANNELS 16
+#endif
+// the SoA banks step through their channels in whole vectors
+_Static_assert(DSP_BANK_MAX_CHANNELS % SIMD_LANES == 0, "DSP_BANK_MAX_CHANNELS must be a multiple of SIMD_LANES");
+
+
+// Build with -DDSP_FAST_MATH_TIER=FAST_MATH_BALANCED (or _FAST / _PRECISE) to route the kernels'
+// per-sample transcendentals through fast_math.h; by default they call libm.
+#ifdef DSP_FAST_MATH_TIER
+#define dsp_expf(x) fast_expf((x), DSP_FAST_MATH_TIER)
+#define dsp_powf(a, b) fast_powf((a), (b), DSP_FAST_MATH_TIER)
+#define dsp_sinf(x) fast_sinf((x), DSP_FAST_MATH_TIER)
+#define dsp_atanf(x) fast_atanf((x), DSP_FAST_MATH_TIER)
+#define dsp_tanhf(x) fast_tanhf((x), DSP_FAST_MATH_TIER)
+#else
+#define dsp_expf(x) expf(x)
+#define dsp_powf(a, b) powf((a), (b))
+#define dsp_sinf(x) sinf(x)
+#define dsp_atanf(x) atanf(x)
+#define dsp_tanhf(x) tanhf(x)
+#endif
 
 static inline float clampf(float x, float lo, float hi) {
   return (x < lo) ? lo : (x > hi) ? hi : x;
 }
 
 static inline float db_to_linear(float db) {
-  return powf(10.0f, (db) / 20.0f);
+  return dsp_powf(10.0f, (db) / 20.0f);
 }
 
 static inline float linear_to_db(float lin) {
@@ -88,17 +115,40 @@ typedef struct {
 void allpass1_init(AllPass1* ap, float feedback);
 void allpass1_process(AllPass1* ap, const float* in, float* out, size_t numSamples);
 
+// samples mirrored past the end of a power-of-two delay line, enough for a 4-tap read to never wrap
+#define DELAYLINE_GUARD 4
+
 typedef struct {
   float* buffer;
   size_t size;
   size_t writeIndex;
   float sampleRate;
+  size_t mask;  // size - 1 in power-of-two mode, 0 otherwise
 } DelayLine;
 
 void delayline_init(DelayLine* dl, float* bufferMemory, size_t size, float sampleRate);
+// Power-of-two mode: size is rounded up to a power of two so indices wrap with a mask, and block
+// reads and writes run as contiguous memcpy / SIMD segments. bufferMemory must hold
+// delayline_pow2_buffer_size(size) floats. The other delayline_* calls work on either mode.
+size_t delayline_pow2_buffer_size(size_t size);
+void delayline_init_pow2(DelayLine* dl, float* bufferMemory, size_t size, float sampleRate);
 void delayline_write(DelayLine* dl, const float* samples, size_t numSamples);
 void delayline_read_linear(DelayLine* dl, float* out, size_t numSamples, float delaySamples);
-void delayline_read_cubic(DelayLine* dl, float* out, size_t numSamples, float delaySamples);;
+void delayline_read_cubic(DelayLine* dl, float* out, size_t numSamples, float delaySamples);
+
+typedef enum {
+  DELAY_INTERP_LINEAR,
+  DELAY_INTERP_CUBIC,     // Catmull-Rom, same kernel as delayline_read_cubic
+  DELAY_INTERP_LAGRANGE,  // 3rd order Lagrange
+  DELAY_INTERP_THIRAN     // 1st order Thiran allpass, flat magnitude, needs allpassState
+} DelayInterpType;
+
+// Reads with a per-sample delay, e.g. straight from lfo_process. Call it after writing the block:
+// out[n] is the n-th sample of that block delayed by delaySamples[n]. Needs a power-of-two line.
+// Delays are clamped to [0, size - 2] (linear), [1, size - 2] (cubic, Lagrange) or
+// [0.5, size - 2] (Thiran); anything longer than size - numSamples reads stale samples.
+// allpassState holds the previous Thiran output and may be NULL for the other types.
+void delayline_read_modulated(const DelayLine* dl, float* out, const float* delaySamples, size_t numSamples, DelayInterpType interp, float* allpassState);
 
 static inline float lerp_scalar(float a, float b, float t);
 void lerp(const float* a, const float* b, const float* t, float* out, size_t numSamples);
@@ -106,6 +156,14 @@ static inline float cubic_interp_scalar(float ym1, float y0, float y1, float y2,
 void cubic_interp(const float* ym1, const float* y0, const float* y1, const float* y2, const float* t, float* out, size_t numSamples);
 void crossfade(const float* a, const float* b, const float* t, float* out, size_t numSamples);
 
+// Per-instance xoshiro128+ generator, one independent stream per SIMD lane so every step yields a
+// full vector. Same seed, same sequence; nothing is shared between instances.
+typedef struct {
+  uint32_t s[4][SIMD_LANES];
+} NoiseGen;
+
+void noise_seed(NoiseGen* gen, uint64_t seed);
+
 typedef enum {
   LFO_SINE,
   LFO_TRI,
@@ -114,7 +172,7 @@ typedef enum {
   LFO_NOISE
 } LFOType;
 
-typedef struct {
+typedef struct LFO {
   float phase;
   float phase_inc;
   float freq;
@@ -122,11 +180,28 @@ typedef struct {
   float amp;
   float dc;
   LFOType type;
+  // picked by lfo_set_type / lfo_set_control_rate so lfo_process never branches on the type
+  void (*kernel)(struct LFO* lfo, float* out, size_t numSamples);
+  float (*eval)(struct LFO* lfo, float phase);
+  // sine rotation by one sample and by SIMD_LANES samples
+  float rotCos, rotSin;
+  float laneCos, laneSin;
+  // control-rate mode: one waveform point every controlInterval samples, linearly interpolated
+  size_t controlInterval;
+  size_t controlLeft;
+  float controlValue;
+  float controlStep;
+  NoiseGen noise;
 } LFO;
 
 void lfo_init(LFO* lfo, LFOType type, float freqHz, float amp, float dc, float sampleRate);
 void lfo_process(LFO* lfo, float* out, size_t numSamples);
 void lfo_set_freq(LFO* lfo, float freqHz);
+void lfo_set_type(LFO* lfo, LFOType type);
+// interval <= 1 switches back to audio rate
+void lfo_set_control_rate(LFO* lfo, size_t interval);
+// LFO_NOISE starts from a fixed seed; give each instance its own to decorrelate them
+void lfo_seed_noise(LFO* lfo, uint64_t seed);
 
 typedef struct {
   float env;
@@ -139,7 +214,87 @@ typedef struct {
 void env_init(EnvelopeDetector* ed, float attackMs, float releaseMs, float sampleRate, int isRMS);
 void env_process(EnvelopeDetector* ed, const float* in, float* out, size_t numSamples);
 
+// Block-parallel single-channel kernels. A block of SIMD_LANES outputs is computed at once as
+// y = H * x + C * state, where H is the lower-triangular Toeplitz matrix of the first SIMD_LANES
+// impulse-response taps and C maps the carried state onto the block; the state for the next block
+// comes from the last inputs/outputs. Results match the scalar kernels to within 1e-4 of full
+// scale for stable coefficients (only summation order differs). The matrix must be re-prepared
+// whenever the filter's coefficients change.
+
+typedef struct {
+  float h[SIMD_LANES][SIMD_LANES];  // h[j] = response of the block to input sample j
+  float c[3][SIMD_LANES];           // response of the block to each carried state variable
+} IIRBlockMatrix;
+
+void biquad_block_prepare(IIRBlockMatrix* m, const Biquad* bq);
+void biquad_process_block(Biquad* bq, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples);
+void onepole_block_prepare(IIRBlockMatrix* m, const OnePole* f);
+void onepole_process_block(OnePole* f, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples);
+void allpass1_block_prepare(IIRBlockMatrix* m, const AllPass1* ap);
+void allpass1_process_block(AllPass1* ap, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples);
+
+// Lane-parallel banks: one independent filter per channel, coefficients and state kept as
+// structure-of-arrays so SIMD_LANES channels advance per instruction. Audio is interleaved
+// (frame-major, numChannels floats per frame), which is what PortAudio hands us.
+
+typedef struct {
+  float b0[DSP_BANK_MAX_CHANNELS];
+  float b1[DSP_BANK_MAX_CHANNELS];
+  float b2[DSP_BANK_MAX_CHANNELS];
+  float a1[DSP_BANK_MAX_CHANNELS];
+  float a2[DSP_BANK_MAX_CHANNELS];
+  float z1[DSP_BANK_MAX_CHANNELS];
+  float z2[DSP_BANK_MAX_CHANNELS];
+  size_t numChannels;
+} BiquadBank;
+
+void biquad_bank_init(BiquadBank* bank, size_t numChannels);
+void biquad_bank_set_channel(BiquadBank* bank, size_t channel, BiquadType type, float freqHz, float Q, float gainDb, float sampleRate);
+void biquad_bank_process(BiquadBank* bank, const float* in, float* out, size_t numFrames);
+
+typedef struct {
+  float a0[DSP_BANK_MAX_CHANNELS];
+  float b0[DSP_BANK_MAX_CHANNELS];
+  float b1[DSP_BANK_MAX_CHANNELS];
+  float z1[DSP_BANK_MAX_CHANNELS];
+  size_t numChannels;
+} OnePoleBank;
+
+void onepole_bank_init(OnePoleBank* bank, size_t numChannels);
+void onepole_bank_set_channel(OnePoleBank* bank, size_t channel, float cutoffHz, float sampleRate, int isHighPass);
+void onepole_bank_process(OnePoleBank* bank, const float* in, float* out, size_t numFrames);
+
+typedef struct {
+  float g[DSP_BANK_MAX_CHANNELS];
+  float x_prev[DSP_BANK_MAX_CHANNELS];
+  float y_prev[DSP_BANK_MAX_CHANNELS];
+  size_t numChannels;
+} AllPassBank;
+
+void allpass_bank_init(AllPassBank* bank, size_t numChannels);
+void allpass_bank_set_channel(AllPassBank* bank, size_t channel, float feedback);
+void allpass_bank_process(AllPassBank* bank, const float* in, float* out, size_t numFrames);
+
+typedef struct {
+  float env[DSP_BANK_MAX_CHANNELS];
+  float attackCoeff[DSP_BANK_MAX_CHANNELS];
+  float releaseCoeff[DSP_BANK_MAX_CHANNELS];
+  float isRMS[DSP_BANK_MAX_CHANNELS]; // 1.0f or 0.0f so the kernel can blend instead of branch
+  size_t numChannels;
+} EnvelopeBank;
+
+void envelope_bank_init(EnvelopeBank* bank, size_t numChannels);
+void envelope_bank_set_channel(EnvelopeBank* bank, size_t channel, float attackMs, float releaseMs, float sampleRate, int isRMS);
+void envelope_bank_process(EnvelopeBank* bank, const float* in, float* out, size_t numFrames);
+
 void compute_gain_reduction_db(const float* inputDb, const float* thresholdDb, float ratio, float* out, size_t numSamples);
+// Quadratic knee kneeDb wide centred on the threshold; kneeDb 0 is the hard knee above
+void compute_gain_reduction_db_soft(const float* inputDb, float thresholdDb, float ratio, float kneeDb, float* out, size_t numSamples);
+
+// Vectorised conversions at FAST_MATH_BALANCED (about 1e-5 dB); zero maps to a very low finite
+// level rather than -inf. in and out may alias.
+void linear_to_db_block(const float* in, float* out, size_t numSamples);
+void db_to_linear_block(const float* in, float* out, size_t numSamples);
 
 void apply_gain_smoothing(float* currentGain, const float* targetGain, float* state, float attackCoeff, float releaseCoeff, size_t numSamples);
 
@@ -162,6 +317,37 @@ void waveshaper_lookup(const float* in, float* out, const float* lookupTable, si
 void waveshaper_lookup_linear(const float* in, float* out, const float* lookupTable, size_t tableSize, size_t numSamples);
 void waveshaper_lookup_cubic(const float* in, float* out, const float* lookupTable, size_t tableSize, size_t numSamples);
 
+// guard entries around a table so the cubic kernel can read i0 - 1 .. i0 + 2 unconditionally;
+// a padded buffer holds WAVESHAPER_PADDED_SIZE(tableSize) floats
+#define WAVESHAPER_PAD_FRONT 1
+#define WAVESHAPER_PAD_BACK 2
+#define WAVESHAPER_PADDED_SIZE(tableSize) ((tableSize) + WAVESHAPER_PAD_FRONT + WAVESHAPER_PAD_BACK)
+
+void waveshaper_pad_table(float* padded, const float* lookupTable, size_t tableSize);
+void waveshaper_lookup_cubic_padded(const float* in, float* out, const float* paddedTable, size_t tableSize, size_t numSamples);
+
+// Antiderivative anti-aliasing for the ClipperType curves. The curve is the same one
+// build_waveshaper_table uses (shape(drive * x)); hard_clip(threshold) is CLIP_HARD with
+// drive = 1 / threshold and the output scaled by threshold. Order 1 adds half a sample of delay,
+// order 2 a full sample. Antiderivatives are closed form (tanh/sigmoid via a dilogarithm) and
+// evaluated in double, since the divided differences cancel heavily; when the input barely moves
+// the kernel falls back to evaluating the curve at the midpoint.
+
+typedef struct {
+  ClipperType type;
+  float drive;
+  int order;
+  double u1;        // previous input, already multiplied by drive
+  double u2;
+  double F1Prev;    // order 1: first antiderivative at u1
+  double F2Prev;    // order 2: second antiderivative at u1
+  double DPrev;     // order 2: divided difference of F2 between u2 and u1
+} ADAAClipper;
+
+void adaa_clipper_init(ADAAClipper* c, ClipperType type, float drive, int order);
+void adaa_clipper_reset(ADAAClipper* c);
+void adaa_clipper_process(ADAAClipper* c, const float* in, float* out, size_t numSamples);
+
 typedef struct {
   float* history;
   size_t historySize;
@@ -174,32 +360,454 @@ void oversample2x_fir(const float* in, float* out, size_t n, const float* fir, R
 void downsample2x(const float* in, float* out, size_t n);
 void downsample2x_fir(const float* in, float* out, size_t n, const float* fir, ResamplerState* state);
 
+// Polyphase half-band resampler. Only the dense phase of the half-band filter is stored (every
+// other tap of a half-band FIR is exactly zero and the centre tap is 0.5), so a 2x step costs one
+// numTaps dot product per input sample. History lives in a doubled (mirrored) ring buffer: each
+// sample is written twice, one capacity apart, so recent history is always contiguous and nothing
+// is ever shifted.
+
+#ifndef HALFBAND_MAX_TAPS
+#define HALFBAND_MAX_TAPS 64
+#endif
+
+typedef struct {
+  float taps[HALFBAND_MAX_TAPS];          // dense phase, reversed to line up with the ring window
+  float ring[2 * (HALFBAND_MAX_TAPS + SIMD_LANES)];
+  float ringCenter[2 * (HALFBAND_MAX_TAPS + SIMD_LANES)]; // downsampler only: phase hitting the centre tap
+  size_t numTaps;
+  size_t pos;
+} HalfbandResampler;
+
+void design_halfband_fir(float* taps, size_t numTaps);
+void halfband_init(HalfbandResampler* hb, size_t numTaps);
+void halfband_reset(HalfbandResampler* hb);
+void halfband_upsample2x(HalfbandResampler* hb, const float* in, float* out, size_t n);
+void halfband_downsample2x(HalfbandResampler* hb, const float* in, float* out, size_t n);
+size_t halfband_latency(const HalfbandResampler* hb);
+
+// Polyphase IIR half-band: two branches of cascaded first-order allpasses running at the low rate,
+// H(z) = 0.5 * (A0(z^2) + z^-1 * A1(z^2)). Every section is an AllPass1 (g = -a), and the two
+// branches advance together in the lanes of one vector. Close to the FIR's stopband for a fraction
+// of the multiplies, at a group delay of only a few samples, but with non-linear phase.
+
+#ifndef IIR_HALFBAND_MAX_COEFFS
+#define IIR_HALFBAND_MAX_COEFFS 12
+#endif
+
+typedef struct {
+  AllPass1 sections[2][IIR_HALFBAND_MAX_COEFFS / 2]; // [branch][section], coefficients alternate branches
+  size_t numSections;                                // per branch
+} IIRHalfband;
+
+void design_iir_halfband(float* coeffs, size_t numCoeffs, float transitionBw);
+void iir_halfband_init(IIRHalfband* hb, size_t numCoeffs, float transitionBw);
+void iir_halfband_reset(IIRHalfband* hb);
+void iir_halfband_upsample2x(IIRHalfband* hb, const float* in, float* out, size_t n);
+void iir_halfband_downsample2x(IIRHalfband* hb, const float* in, float* out, size_t n);
+
+#define OVERSAMPLER_MAX_STAGES 3
+#define OVERSAMPLER_CHUNK 256
+
+// Cascade of half-band stages for 2x/4x/8x. Later stages see a relatively wider transition band,
+// so each one after the first runs half the taps of the one before it (never below SIMD_LANES).
+typedef struct {
+  HalfbandResampler up[OVERSAMPLER_MAX_STAGES];
+  HalfbandResampler down[OVERSAMPLER_MAX_STAGES];
+  float scratch[OVERSAMPLER_CHUNK * ((1 << OVERSAMPLER_MAX_STAGES) - 2)];
+  size_t numStages;
+  size_t factor;
+} Oversampler;
+
+int oversampler_init(Oversampler* os, size_t factor, size_t numTaps);
+void oversampler_reset(Oversampler* os);
+void oversampler_upsample(Oversampler* os, const float* in, float* out, size_t n);
+void oversampler_downsample(Oversampler* os, const float* in, float* out, size_t n);
+size_t oversampler_latency(const Oversampler* os);
+
+// Zero-latency partitioned convolution. The first blockSize taps run direct-form per sample; the
+// rest are split into blockSize-tap partitions convolved in the frequency domain (overlap-save,
+// FFT size 2 * blockSize) against a delay line of past input spectra. A partition k >= 1 only needs
+// input blocks that are already complete, so the frequency-domain part adds no latency.
+//
+// ConvolverIR holds the precomputed partition spectra and is read-only while processing, so one
+// IR can be shared by many Convolvers and swapped in without recomputing anything.
+
+typedef struct {
+  size_t blockSize;
+  size_t numPartitions;  // frequency-domain partitions, not counting the direct head
+  float* head;           // first blockSize taps, reversed
+  float* spectra;        // per partition one packed spectrum (fft.h) of 2 * blockSize floats
+} ConvolverIR;
+
+// blockSize must be a power of two, at least SIMD_LANES; returns 0 on success, -1 otherwise
+int convolver_ir_init(ConvolverIR* ir, const float* taps, size_t numTaps, size_t blockSize);
+void convolver_ir_free(ConvolverIR* ir);
+
+typedef struct {
+  const ConvolverIR* ir;
+  size_t blockSize;
+  size_t maxPartitions;
+  size_t pos;      // samples of the current block received so far
+  size_t fdlHead;  // slot holding the newest input spectrum
+  float* input;    // previous block, then the current one
+  float* tail;     // frequency-domain part of the current block's output
+  float* fdl;      // maxPartitions input spectra, same layout as ConvolverIR.spectra
+  float* accum;    // 2 * blockSize, the summed spectrum and then its inverse transform
+  const FFTPlan* plan;
+} Convolver;
+
+int convolver_init(Convolver* c, size_t blockSize, size_t maxPartitions);
+void convolver_free(Convolver* c);
+void convolver_reset(Convolver* c);
+// ir must use the same blockSize and at most maxPartitions partitions; NULL mutes the output
+void convolver_set_ir(Convolver* c, const ConvolverIR* ir);
+// any n, in and out may alias
+void convolver_process(Convolver* c, const float* in, float* out, size_t n);
+// Frequency-domain part only, one whole block at a time: takes input block j and returns the
+// partitions' output for block j + 1. The direct head is ignored. For callers that run the partitions
+// somewhere other than the audio thread; don't mix with convolver_process on the same Convolver.
+void convolver_process_block(Convolver* c, const float* in, float* tail);
+
+// Feedback delay network with one line per SIMD lane. All lines share one write position in an
+// interleaved ring (frame t holds every line's sample t), so writing is a single vector store and
+// reading is one gather at each line's own delay. The feedback path runs a damping one-pole per
+// line and an in-register 8x8 Hadamard mix, all across the lanes.
+
+#define FDN_LINES SIMD_LANES
+#define FDN_MAX_DELAY 8192   // frames, power of two
+
+typedef struct {
+  float* buffer;                 // FDN_MAX_DELAY * FDN_LINES, allocated by fdn_init
+  size_t writePos;
+  int32_t delay[FDN_LINES];      // per-line delay in frames
+  float feedback[FDN_LINES];     // per-line gain for the target decay time
+  float lowpass[FDN_LINES];      // damping one-pole state
+  float damping;                 // one-pole coefficient, 0 = none
+  float sampleRate;
+} FDNReverb;
+
+int fdn_init(FDNReverb* fdn, float sampleRate);
+void fdn_free(FDNReverb* fdn);
+void fdn_reset(FDNReverb* fdn);
+// roomSize and damping in [0, 1]; only changes delays and gains, never reallocates
+void fdn_set_params(FDNReverb* fdn, float roomSize, float damping);
+// wet signal only, in and out may alias
+void fdn_process(FDNReverb* fdn, const float* in, float* out, size_t n);
+
+// Low-latency granular pitch shifter. Two taps sweep through a short delay window at (1 - ratio)
+// samples per sample, half a grain apart, under sin^2 windows that sum to one. When a tap wraps,
+// its restart point is nudged by up to GRAIN_SHIFTER_SEARCH_MS toward the best match with the
+// other tap's waveform (SOLA-style), which removes most of the beating short grains would
+// otherwise cause. The average delay is about 4 ms.
+
+#define GRAIN_SHIFTER_GRAIN_MS 6.0f
+#define GRAIN_SHIFTER_SEARCH_MS 2.0f
+#define GRAIN_SHIFTER_BLOCK 256
+
+typedef struct {
+  DelayLine line;
+  float* memory;
+  float ratio;
+  float phase;          // tap A's position in its grain, [0, 1); tap B sits half a grain away
+  float offset[2];      // per-tap restart nudge in samples, fixed for the grain
+  size_t grain;         // samples
+  size_t search;        // samples
+  size_t window;        // correlation length, multiple of SIMD_LANES
+  float* scratch;       // per-sample delays, phases and tap outputs for one block, plus search windows
+} GrainShifter;
+
+int grain_shifter_init(GrainShifter* gs, float sampleRate);
+void grain_shifter_free(GrainShifter* gs);
+void grain_shifter_reset(GrainShifter* gs);
+// ratio = output / input frequency, 0.25 to 4
+void grain_shifter_set_ratio(GrainShifter* gs, float ratio);
+// any n, in and out may alias
+void grain_shifter_process(GrainShifter* gs, const float* in, float* out, size_t n);
+
+// Streaming phase vocoder pitch shifter: Hann-windowed STFT at 75% overlap. Each bin's true
+// frequency comes from its phase advance. Spectral peaks are found, and each peak's region moves
+// as a unit to ratio times the peak's frequency (Laroche-Dolson peak locking). The peak's phase
+// continues from the partial's phase in the previous frame. With formant > 0, a cepstrally smoothed
+// spectral envelope is held in place while the partials move, so voices and cabinets keep their
+// character. Latency is one frame.
+
+typedef struct {
+  size_t frameSize;
+  size_t hop;
+  size_t fill;          // samples into the current hop
+  size_t lifter;        // cepstral coefficients kept for the envelope
+  const FFTPlan* plan;
+  float ratio;
+  float formant;
+  float outputScale;    // overlap-add normalisation, folds in the inverse FFT's 1 / frameSize
+  float* window;
+  float* input;         // last frameSize input samples
+  float* output;        // overlap-add accumulator
+  float* ready;         // the hop being played out
+  float* frame;         // time frame / packed spectrum
+  float* cepstrum;
+  float* re;            // frameSize / 2 bins each from here on
+  float* im;
+  float* magnitude;
+  float* frequency;     // in bins
+  float* phase;
+  float* lastPhase;
+  float* envelope;      // natural log
+  float* synthRe;
+  float* synthIm;
+  uint32_t* peaks;      // this frame's peak bins
+  uint32_t* peakTarget; // destination bin and synthesis phase of each peak, this frame and last
+  float* peakPhase;
+  uint32_t* lastPeakTarget;
+  float* lastPeakPhase;
+  size_t numLastPeaks;
+} PhaseVocoder;
+
+// frameSize a power of two, hop = frameSize / 4
+int phase_vocoder_init(PhaseVocoder* pv, size_t frameSize, float sampleRate);
+void phase_vocoder_free(PhaseVocoder* pv);
+void phase_vocoder_reset(PhaseVocoder* pv);
+// ratio 0.25 to 4; formant 0 (shift with the pitch) to 1 (keep in place)
+void phase_vocoder_set_params(PhaseVocoder* pv, float ratio, float formant);
+// any n, in and out may alias
+void phase_vocoder_process(PhaseVocoder* pv, const float* in, float* out, size_t n);
+size_t phase_vocoder_latency(const PhaseVocoder* pv);
+
+#define LIMITER_MAX_LOOKAHEAD_MS 20.0f
+#define LIMITER_TRUE_PEAK_FACTOR 4
+#define LIMITER_CHUNK 256
+
+// Lookahead brickwall limiter. The detector is the max of |x| (or of the 4x oversampled signal,
+// which catches inter-sample peaks) over the last lookahead + 1 samples, kept with a van Herk /
+// Gil-Werman running max: the peak stream is cut into window-long segments, and the max over any
+// window is the larger of a suffix max of the previous segment and the prefix max of the current
+// one, so the cost per sample doesn't depend on the lookahead. The audio is delayed by the
+// lookahead, giving the smoothed gain that long to come down before a peak reaches the output;
+// a clip at the threshold catches what the attack's tail leaves over.
+typedef struct {
+  size_t maxWindow;
+  size_t window;        // lookahead + 1 samples
+  size_t segPos;        // samples into the current segment
+  float prefixMax;
+  float* segment;       // the current segment's peaks
+  float* suffixMax;     // the previous segment's suffix maxima, window + 1 of them
+  DelayLine line;
+  float* memory;
+  size_t latency;       // lookahead plus the true-peak upsampler's delay
+  float sampleRate;
+  float thresholdDb;
+  float ratio;
+  float attackCoeff;
+  float releaseCoeff;
+  float reduction;      // smoothed gain reduction in dB, >= 0
+  int truePeak;
+  Oversampler os;
+} Limiter;
+
+int limiter_init(Limiter* l, float sampleRate);
+void limiter_free(Limiter* l);
+void limiter_reset(Limiter* l);
+// lookahead up to LIMITER_MAX_LOOKAHEAD_MS; changing it or truePeak resets the limiter
+void limiter_set_params(Limiter* l, float thresholdDb, float ratio, float lookaheadMs, float releaseMs, int truePeak);
+// any n, in and out may alias
+void limiter_process(Limiter* l, const float* in, float* out, size_t n);
+size_t limiter_latency(const Limiter* l);
+
+#define COMPRESSOR_CHUNK 256
+// the knee every compressor in the app uses: apply_compressor and the effect chain's modifier
+#define COMPRESSOR_KNEE_DB 6.0f
+
+// Feed-forward compressor. A level detector (EnvelopeDetector: instant-attack peak, or RMS) feeds
+// the soft-knee gain computer, whose gain reduction is smoothed by apply_gain_smoothing with the
+// attack and release times. The gain computer and smoothing can run every interval samples with
+// the linear gain ramped in between, which takes the log/exp work off most samples for a lag of
+// one interval.
+typedef struct {
+  EnvelopeDetector detector;
+  float sampleRate;
+  float thresholdDb;
+  float ratio;
+  float kneeDb;
+  float makeupDb;
+  float attackMs;
+  float releaseMs;
+  float attackCoeff;    // at the control rate
+  float releaseCoeff;
+  float reduction;      // smoothed gain reduction in dB, >= 0
+  size_t interval;      // samples between gain computations
+  size_t countdown;     // samples until the next one
+  float gain;           // linear, makeup included
+  float gainStep;
+} Compressor;
+
+void compressor_init(Compressor* c, float sampleRate, int isRMS);
+void compressor_reset(Compressor* c);
+void compressor_set_params(Compressor* c, float thresholdDb, float ratio, float kneeDb, float attackMs, float releaseMs, float makeupDb);
+// 1 (the default) computes the gain every sample
+void compressor_set_control_rate(Compressor* c, size_t interval);
+// Linear gain for n samples of detector input key, for linking channels or a sidechain
+void compressor_compute_gain(Compressor* c, const float* key, float* gain, size_t n);
+// any n, in and out may alias
+void compressor_process(Compressor* c, const float* in, float* out, size_t n);
+
+#define NOISE_GATE_CHUNK 256
+
+// Noise gate with open/close hysteresis and a hold time, keyed from the input or a sidechain.
+// Detection and the open/hold/close decision run once per SIMD_LANES samples on the block's peak.
+// Within a block the gain follows the one-pole towards the decided target in closed form, so the
+// gain kernel is branch-free vector code. Runs where the gate stays fully open skip it.
+typedef struct {
+  float openLevel;      // linear
+  float closeLevel;
+  float floorGain;      // gain when closed
+  float envDecay;       // detector release per block
+  float env;
+  size_t holdBlocks;
+  size_t hold;          // blocks below closeLevel left before closing
+  int open;
+  float gain;
+  float sampleRate;
+  float attackPow[SIMD_LANES];   // (1 - attackCoeff)^(k + 1)
+  float releasePow[SIMD_LANES];
+} NoiseGate;
+
+void noise_gate_init(NoiseGate* g, float sampleRate);
+void noise_gate_reset(NoiseGate* g);
+// closes hysteresisDb under thresholdDb, after holdMs there; rangeDb is the closed gain
+void noise_gate_set_params(NoiseGate* g, float thresholdDb, float hysteresisDb, float attackMs, float holdMs, float releaseMs, float rangeDb);
+// key NULL keys from in. Any n; in, key and out may alias.
+void noise_gate_process(NoiseGate* g, const float* in, const float* key, float* out, size_t n);
+
 void denormal_fix_inplace(float* buffer, size_t n);
 
 typedef enum {
   TUBE_TRIODE,
   TUBE_PENTODE
-} TubeType;
+} TubeStageType;
 
 typedef struct {
   float mu;
-  float k;
-  float a;
+  float k;       // Koren Kp
+  float a;       // Koren Ex
   float Kg1;
-  float Rp;
-  float biasV;
+  float Rp;      // plate load, ohms
+  float biasV;   // grid bias, volts
 } TubeParams;
 
+// Transfer curves from Koren's plate current equations, with the plate voltage solved against
+// the load line from a fixed supply. Entry i is for grid signal vMin + (vMax - vMin) * i /
+// (tableSize - 1) volts on top of the bias. The plate swing is divided by the stage's small-signal
+// gain and taken non-inverted, so table(v) ~ v around the bias point and the stage gain is
+// applied separately. Evaluated SIMD_LANES entries at a time with fast_math.h.
 void build_triode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax);
 void build_pentode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax);
-void build_tube_table_from_koren(float* table, size_t tableSize, TubeType type, const TubeParams* params, float vMin, float vMax);
+void build_tube_table_from_koren(float* table, size_t tableSize, TubeStageType type, const TubeParams* params, float vMin, float vMax);
+
+// Process-wide cache of those tables keyed by type, params, range and size, so stages with the
+// same tube share one read-only copy and switching back to a preset doesn't rebuild it. Released
+// tables stay cached until their slot is needed. Thread-safe, but builds on a miss, so call it
+// outside the audio callback. Returns NULL if every slot is in use or allocation fails.
+#define TUBE_TABLE_CACHE_SLOTS 64
+const float* tube_table_acquire(TubeStageType type, const TubeParams* params, float vMin, float vMax, size_t tableSize);
+void tube_table_release(const float* table);
+
+// Passive treble/mid/bass tone stack, from Yeh and Smith's analysis of the Fender TMB network:
+// third order, with coefficients that are polynomials in the three pot positions. Each type is
+// that network with one amp family's parts.
+typedef enum {
+  TONE_STACK_FENDER,
+  TONE_STACK_MARSHALL,
+  TONE_STACK_VOX
+} ToneStackType;
+
+// Knob positions per axis of a coefficient surface; knob steps of 0.1
+#define TONE_STACK_GRID 11
+// coefficients per grid point: the first-order section's b0, b1, a0, then the biquad's b0, b1,
+// b2, a1, a2
+#define TONE_STACK_COEFFS 8
+#define TONE_STACK_CACHE_SLOTS 16
+
+// Coefficients on a TONE_STACK_GRID^3 grid of knob positions (treble slowest, bass fastest), so
+// moving a knob is a trilinear blend of eight neighbours rather than a redesign. Each point is
+// the bilinear transform of the network factored into a first-order high-pass on its lowest pole
+// and a biquad on the other two: as one third-order direct form the coefficients lose the low
+// poles to float rounding at oversampled rates. Gain is normalised so the stack peaks at 0 dB
+// with every knob at noon. Cached per type and sample rate like the tube tables, with the same
+// rules: thread-safe, builds on a miss, NULL when the cache is full or allocation fails.
+const float* tone_stack_surface_acquire(ToneStackType type, float sampleRate);
+void tone_stack_surface_release(const float* surface);
+
+typedef struct {
+  const float* surface;  // from tone_stack_surface_acquire
+  OnePole low;           // the sections at the current knobs, in series
+  Biquad body;
+  IIRBlockMatrix block;  // output of a block from its inputs and the three carried states
+  float carry[SIMD_LANES + 3][SIMD_LANES];  // the states after it, the same way, in lanes 0-2
+} ToneStack;
+
+// Returns 0 on success, -1 if the surface can't be had
+int tone_stack_init(ToneStack* ts, ToneStackType type, float sampleRate);
+void tone_stack_free(ToneStack* ts);
+void tone_stack_reset(ToneStack* ts);
+// Knobs 0 to 1, bass on an audio taper as on the amps. Cheap enough to call per buffer from the
+// audio thread: a blend and a block-matrix rebuild, no transcendental functions.
+void tone_stack_set_knobs(ToneStack* ts, float treble, float mid, float bass);
+// block-parallel, SIMD_LANES samples per step; in and out may alias
+void tone_stack_process(ToneStack* ts, const float* in, float* out, size_t numSamples);
+
+// Multi-voice chorus over one shared delay line. Voice v lives in SIMD lane v: its LFO is a
+// rotating phasor in that lane, offset by v / voices of a cycle and slightly detuned, and every
+// sample gathers all voices' cubic taps at once, so up to SIMD_LANES voices cost about the same as
+// one. Voices are panned across the stereo field by the spread and summed at equal power.
+#define CHORUS_MAX_VOICES SIMD_LANES
+#define CHORUS_CHUNK 256
+#define CHORUS_BASE_DELAY_MS 8.0f    // the first voice's centre delay; the others sit further out
+#define CHORUS_VOICE_STAGGER 0.15f   // each voice's centre is this much of the base further out
+#define CHORUS_MAX_SWING_MS 4.0f     // delay swing either way at full depth
+#define CHORUS_RATE_SPREAD 0.08f     // outermost voices' LFO rates differ by this fraction
+
+typedef struct {
+  DelayLine line;
+  float* memory;
+  float sampleRate;
+  size_t voices;
+  float rate;
+  float depth;
+  float mix;
+  float spread;
+  float lfoCos[SIMD_LANES];     // phasor per voice
+  float lfoSin[SIMD_LANES];
+  float stepCos[SIMD_LANES];    // its rotation per sample
+  float stepSin[SIMD_LANES];
+  float centre[SIMD_LANES];     // centre delay per voice, samples
+  float swing;                  // delay swing, samples
+  float gainL[SIMD_LANES];      // pan and level per voice, 0 for unused lanes
+  float gainR[SIMD_LANES];
+  float gainMono[SIMD_LANES];
+  float wetL[CHORUS_CHUNK];
+  float wetR[CHORUS_CHUNK];
+} Chorus;
+
+// Returns 0 on success, -1 if the delay line can't be allocated
+int chorus_init(Chorus* c, float sampleRate);
+void chorus_free(Chorus* c);
+void chorus_reset(Chorus* c);
+// 2 to CHORUS_MAX_VOICES; respreads the LFO phases from the first voice's
+void chorus_set_voices(Chorus* c, size_t voices);
+// rate in Hz; depth, mix and spread 0 to 1
+void chorus_set_params(Chorus* c, float rateHz, float depth, float mix, float spread);
+// Mono in, stereo out; right may be NULL for a mono sum. in may alias either output.
+void chorus_process(Chorus* c, const float* in, float* left, float* right, size_t n);
 
 void normalize_ir(float* ir, size_t n, float targetRMS);
 float blackman_window_scalar(float w, size_t n);
 void build_blackman_window(float* w, size_t n);
 void build_hann_window(float* w, size_t n);
 
-void white_noise(float* out, size_t n);
+// uniform in [-1, 1)
+void white_noise(NoiseGen* gen, float* out, size_t n);
+// zero mean, unit variance (Box-Muller)
+void gaussian_noise(NoiseGen* gen, float* out, size_t n);
 
 void apply_window_inplace(float* buffer, const float* window, size_t n);
 
@@ -2,11 +2,17 @@
 #define EFFECTS_HANDLER_H
 
 #include <effects_dsp.h>
+#include <looper.h>
 #include <math.h>
 #include <logger.h>
 
 // FIXME TO USE STRUCTS FROM effects_dsp.h INSTEAD OF REDEFINING HERE!!!
 
+// The apply_* entry points carry no stream context, so their state assumes this rate
+#ifndef EFFECTS_SAMPLE_RATE
+#define EFFECTS_SAMPLE_RATE 48000.0f
+#endif
+
 typedef enum {
   AMP_CHANNEL_CLEAN,         // Clean channels: Very low gain, high headroom, wide bandwidth
   AMP_CHANNEL_FAT_CLEAN,     // Clean channels: More low mids, slightly earlier breakup
@@ -78,6 +84,19 @@ typedef enum {
  */
 void apply_noise_gate(float threshold, float attackTime, float releaseTime, float* buffer, int bufferSize);
 
+/**
+ * Noise gate keyed from a sidechain instead of the buffer itself, e.g. the signal ahead of the
+ * distortion, whose noise floor is far below the distorted one. Shares its state with
+ * apply_noise_gate. The gate opens at threshold, closes 6 dB under it after a 50 ms hold.
+ * @param threshold Threshold level in dB
+ * @param attackTime Attack time in milliseconds
+ * @param releaseTime Release time in milliseconds
+ * @param key Sidechain, bufferSize samples aligned with buffer; NULL keys from buffer
+ * @param buffer Audio buffer to process
+ * @param bufferSize Size of the audio buffer
+ */
+void apply_noise_gate_keyed(float threshold, float attackTime, float releaseTime, const float* key, float* buffer, int bufferSize);
+
 /**
  * Apply overdrive effect to audio buffer
  * @param gain Gain level
@@ -141,17 +160,38 @@ void apply_high_low_pass_filter(float cutoffFreq, float resonance, int isHighPas
  */
 void apply_compressor(float threshold, float ratio, float attackTime, float releaseTime, float makeupGain, float* buffer, int bufferSize);
 
+/**
+ * Compute the compressor's gain every interval samples and ramp between, instead of every
+ * sample. Cheaper, at the cost of the gain lagging by one interval. Takes effect on the next
+ * apply_compressor call.
+ * @param interval Samples between gain computations, 1 for every sample (the default)
+ */
+void compressor_set_gain_interval(int interval);
+
 /**
  * Apply reverb effect to audio buffer
- * @param roomSize Size of the virtual room
- * @param damping Damping factor
- * @param preDelay Pre-delay time in milliseconds
- * @param mix Wet/Dry mix percentage
+ * @param roomSize Size of the virtual room, 0.0 to 1.0 (clamped)
+ * @param damping High-frequency damping, 0.0 to 1.0 (clamped)
+ * @param preDelay Pre-delay time in milliseconds, 0 to 500
+ * @param mix Wet/Dry mix percentage, 0 to 100 with 100 being fully wet (unlike the 0.0 to 1.0 of
+ *            the chorus and pitch shifter)
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
 void apply_reverb(float roomSize, float damping, float preDelay, float mix, float* buffer, int bufferSize);
 
+/**
+ * Load an impulse response for apply_reverb. While one is loaded, apply_reverb convolves with it
+ * instead of running the algorithmic reverb, and roomSize and damping are ignored.
+ * Allocates and starts worker threads, so call it outside the audio callback. Safe while
+ * apply_reverb is running: the new response is swapped in between blocks, and this waits for the
+ * callback to finish any block still using the old one before freeing it.
+ * @param ir Impulse response, or NULL to go back to the algorithmic reverb
+ * @param length Number of samples in the impulse response
+ * @return 0 on success, -1 on failure
+ */
+int reverb_load_impulse_response(const float* ir, int length);
+
 /**
  * Apply delay effect to audio buffer
  * @param time Delay time in milliseconds
@@ -165,12 +205,13 @@ void apply_reverb(float roomSize, float damping, float preDelay, float mix, floa
 void apply_delay(float time, float feedback, float mix, float lowpassCutoff, float wowFlutter, float* buffer, int bufferSize);
 
 /**
- * Apply preamp simulation effect to audio buffer
- * @param gain Gain level
- * @param bass Bass control
- * @param mid Mid control
- * @param treble Treble control
- * @param presence Presence control
+ * Apply preamp simulation effect to audio buffer. Cascaded triode stages at 4x oversampling;
+ * the audio is delayed by preamp_get_latency() samples.
+ * @param gain Gain level, 0 to 1
+ * @param bass Bass control, 0 to 1, as on the channel's passive tone stack
+ * @param mid Mid control, 0 to 1, as on the channel's passive tone stack
+ * @param treble Treble control, 0 to 1, as on the channel's passive tone stack
+ * @param presence Presence control, 0 to 1, flat at 0.5
  * @param channelType Type of amplifier channel
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
@@ -178,24 +219,37 @@ void apply_delay(float time, float feedback, float mix, float lowpassCutoff, flo
 void apply_preamp_simulation(float gain, float bass, float mid, float treble, float presence, AmpChannelType channelType, float* buffer, int bufferSize);
 
 /**
- * Apply power amp simulation effect to audio buffer
- * @param masterVolume Master volume level
- * @param sag Sag amount
- * @param presence Presence control
- * @param depth Depth control
+ * Delay apply_preamp_simulation adds, for compensation elsewhere in the chain
+ * @return Latency in samples
+ */
+int preamp_get_latency(void);
+
+/**
+ * Apply power amp simulation effect to audio buffer. A push-pull pair at 2x oversampling whose
+ * supply sags under load; the audio is delayed by power_amp_get_latency() samples.
+ * @param masterVolume Master volume level, 0 to 1
+ * @param sag Sag amount, 0 (stiff supply) to 1
+ * @param presence Presence control, 0 (full feedback, flat) to 1
+ * @param depth Depth control, 0 (full feedback, flat) to 1
  * @param tubeType Type of tubes used
- * @param bias Bias level
+ * @param bias Bias level, 0 (cold) to 1 (hot), nominal at 0.5
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
 void apply_power_amp_simulation(float masterVolume, float sag, float presence, float depth, TubeType tubeType, float bias, float* buffer, int bufferSize);
 
+/**
+ * Delay apply_power_amp_simulation adds, for compensation elsewhere in the chain
+ * @return Latency in samples
+ */
+int power_amp_get_latency(void);
+
 /**
  * Apply cabinet simulation effect to audio buffer
- * @param micType Type of microphone used
- * @param micPosition Position of the microphone
- * @param distance Distance from the speaker
- * @param roomAmount Amount of room ambience
+ * @param micType Type of microphone used; an unknown type falls back to the SM57
+ * @param micPosition Position of the microphone; an unknown position falls back to on axis
+ * @param distance Distance from the speaker, 0.0 (on the grille) to 1.0 (clamped)
+ * @param roomAmount Amount of room ambience, 0.0 (none) to 1.0 (clamped)
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
@@ -204,13 +258,34 @@ void apply_cabinet_simulation(MicType micType, MicPosition micPosition, float di
 /**
  * Apply chorus effect to audio buffer
  * @param rate Rate of modulation in Hz
- * @param depth Depth of modulation
+ * @param depth Depth of modulation, 0.0 to 1.0
  * @param mix Wet/Dry mix percentage, represented as 0.0 to 1.0 with 1.0 being fully wet
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
 void apply_chorus(float rate, float depth, float mix, float* buffer, int bufferSize);
 
+/**
+ * Apply chorus effect to a mono signal with the voices panned across a stereo output. Shares its
+ * state with apply_chorus.
+ * @param rate Rate of modulation in Hz
+ * @param depth Depth of modulation, 0.0 to 1.0
+ * @param mix Wet/Dry mix percentage, represented as 0.0 to 1.0 with 1.0 being fully wet
+ * @param spread Stereo width of the voices, 0.0 (all centred) to 1.0 (hard left to hard right)
+ * @param input Mono input, may be the same buffer as left or right
+ * @param left Left output
+ * @param right Right output
+ * @param bufferSize Samples per buffer
+ */
+void apply_chorus_stereo(float rate, float depth, float mix, float spread, const float* input, float* left, float* right, int bufferSize);
+
+/**
+ * Number of chorus voices, 2 to 8. More voices cost next to nothing extra, they share one delay
+ * line and run side by side in SIMD lanes. Takes effect on the next chorus call.
+ * @param voices Voice count, 3 by default
+ */
+void chorus_set_voice_count(int voices);
+
 /**
  * Apply flanger effect to audio buffer
  * @param rate Rate of modulation in Hz
@@ -248,8 +323,8 @@ void apply_tremolo(float rate, float depth, float mix, WaveformType waveform, fl
  * Apply pitch shifter
  * @param interval Pitch shift interval in semitones
  * @param mix Wet/Dry mix percentage, represented as 0.0 to 1.0 with 1.0 being fully wet
- * @param formant Formant preservation amount ranging from 0.0 (none) to 1.0 (full)
- * @param quality Quality setting (0 = low, 1 = high)
+ * @param formant Formant preservation amount ranging from 0.0 (none) to 1.0 (full), high quality only
+ * @param quality Quality setting (0 = low, granular, ~4 ms latency; 1 = high, phase vocoder, ~43 ms latency)
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
@@ -257,7 +332,7 @@ void apply_pitch_shifter(float interval, float mix, float formant, int quality,
 
 /**
  * Apply looper effect to audio buffer
- * @param loopLength Length of the loop in milliseconds
+ * @param loopLength Length of the loop in milliseconds; 0 or less records until the next mode change
  * @param feedback Feedback amount percentage, represented as 0.0 to 1.0
  * @param overdubLevel Overdub level percentage, represented as 0.0 to 1.0
  * @param buffer Audio buffer to process
@@ -265,6 +340,25 @@ void apply_pitch_shifter(float interval, float mix, float formant, int quality,
  */
 void apply_looper(float loopLength, float feedback, float overdubLevel, float* buffer, int bufferSize);
 
+/**
+ * Set up the looper's storage; apply_looper passes audio through until this has succeeded.
+ * Maps memory (and opens the file), so call it outside the audio callback. Safe while apply_looper
+ * is running: the new looper is swapped in between blocks, and this waits for the callback to
+ * finish any block still using the old one before unmapping it. Don't call it concurrently with
+ * looper_request_mode.
+ * @param maxSeconds Longest loop that can be recorded
+ * @param backingFile File to keep the loop in across restarts, or NULL for anonymous memory
+ * @return 0 on success, -1 on failure
+ */
+int looper_prepare(float maxSeconds, const char* backingFile);
+
+/**
+ * Switch the looper between idle, record, play and overdub. Safe from any thread; takes effect
+ * at the start of the next apply_looper call.
+ * @param mode Requested transport mode
+ */
+void looper_request_mode(LooperMode mode);
+
 /**
  * Apply clipper effect to audio buffer
  * @param threshold Clipping threshold level in dB
@@ -274,16 +368,30 @@ void apply_looper(float loopLength, float feedback, float overdubLevel, float* b
 void apply_clipper(float threshold, float* buffer, int bufferSize);
 
 /**
- * Apply limiter effect to audio buffer
+ * Apply limiter effect to audio buffer. Lookahead brickwall: the output never exceeds the
+ * threshold, and the audio is delayed by limiter_get_latency() samples.
  * @param threshold Limiting threshold level in dB
  * @param ratio Ratio of compression, typically very high (e.g., 10:1 or greater), input as a float (e.g., 10.0 for 10:1)
  * @param releaseTime Release time in milliseconds
- * @param attackTime Attack time in milliseconds
+ * @param attackTime Attack time in milliseconds, also the lookahead (at most 20 ms)
  * @param buffer Audio buffer to process
  * @param bufferSize Size of the audio buffer
  */
 void apply_limiter(float threshold, float ratio, float attackTime, float releaseTime, float* buffer, int bufferSize);
 
+/**
+ * Detect peaks on the 4x oversampled signal, catching inter-sample peaks at the cost of a
+ * little more latency. Takes effect on the next apply_limiter call.
+ * @param enabled Non-zero for true-peak detection
+ */
+void limiter_set_true_peak(int enabled);
+
+/**
+ * Delay apply_limiter adds, for compensation elsewhere in the chain
+ * @return Latency in samples at the current settings
+ */
+int limiter_get_latency(void);
+
 /**
  * Apply spectral enhancer effect to audio buffer using FFT
  * @param amount Amount of enhancement
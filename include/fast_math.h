@@ -0,0 +1,197 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stdint.h>
+#include <math.h>
+#include <float.h>
+#include <simde/x86/avx2.h>
+
+// Vector polynomial approximations of the libm calls the DSP kernels make per sample. Every
+// function takes a FastMathTier; callers pass a constant so the unused tiers fold away when the
+// function is inlined. Max errors measured against libm
+// (test_fast_math_error_bounds in tests/tests.c checks them):
+//
+//              FAST        BALANCED    PRECISE
+//   exp (rel)  1.3e-4      6e-6        3e-7
+//   log (abs)  1e-5        1.5e-6      1.5e-6    (1e-6 < x < 1e6, mostly result rounding)
+//   sin (abs)  1.2e-4      1.5e-6      3e-7      (|x| < 1e4)
+//   atan (abs) 2.8e-4      7e-6        4e-7
+//   tanh (abs) 6e-5        2e-6        2e-7
+//   pow (rel)  exp error plus |b * log(a)| times the log error, a > 0
+//
+// The scalar fast_*f wrappers run the same code on one lane, so scalar and vector paths agree.
+
+typedef enum {
+  FAST_MATH_FAST,
+  FAST_MATH_BALANCED,
+  FAST_MATH_PRECISE
+} FastMathTier;
+
+#define FAST_MATH_LN2_HI 0.693359375f
+#define FAST_MATH_LN2_LO -2.12194440e-4f
+#define FAST_MATH_TWO_PI_HI 6.28125f
+#define FAST_MATH_TWO_PI_LO 1.9353071795864769e-3f
+
+static inline simde__m256 fast_poly_ps(simde__m256 x, const float* c, int n) {
+  simde__m256 acc = simde_mm256_set1_ps(c[n - 1]);
+  for (int i = n - 2; i >= 0; i--) {
+    acc = simde_mm256_add_ps(simde_mm256_mul_ps(acc, x), simde_mm256_set1_ps(c[i]));
+  }
+  return acc;
+}
+
+static inline simde__m256 fast_exp_ps(simde__m256 x, FastMathTier tier) {
+  // e^r = 1 + r + r^2 * p(r) on |r| <= ln2 / 2
+  static const float fast[] = {0.50394132f, 0.16662828f};
+  static const float balanced[] = {0.50005117f, 0.16753518f, 0.041277738f};
+  static const float precise[] = {0.49999232f, 0.16667114f, 0.041890124f, 0.0083125288f};
+
+  x = simde_mm256_min_ps(simde_mm256_set1_ps(88.3f), simde_mm256_max_ps(simde_mm256_set1_ps(-87.3f), x));
+  simde__m256 n = simde_mm256_round_ps(simde_mm256_mul_ps(x, simde_mm256_set1_ps(1.44269504f)), SIMDE_MM_FROUND_TO_NEAREST_INT | SIMDE_MM_FROUND_NO_EXC);
+  simde__m256 r = simde_mm256_sub_ps(x, simde_mm256_mul_ps(n, simde_mm256_set1_ps(FAST_MATH_LN2_HI)));
+  r = simde_mm256_sub_ps(r, simde_mm256_mul_ps(n, simde_mm256_set1_ps(FAST_MATH_LN2_LO)));
+
+  simde__m256 p;
+  switch (tier) {
+    case FAST_MATH_FAST: p = fast_poly_ps(r, fast, 2); break;
+    case FAST_MATH_BALANCED: p = fast_poly_ps(r, balanced, 3); break;
+    default: p = fast_poly_ps(r, precise, 4); break;
+  }
+  p = simde_mm256_add_ps(simde_mm256_add_ps(simde_mm256_set1_ps(1.0f), r), simde_mm256_mul_ps(simde_mm256_mul_ps(r, r), p));
+
+  simde__m256i bits = simde_mm256_slli_epi32(simde_mm256_add_epi32(simde_mm256_cvtps_epi32(n), simde_mm256_set1_epi32(127)), 23);
+  return simde_mm256_mul_ps(p, simde_mm256_castsi256_ps(bits));
+}
+
+// natural log for x > 0; non-positive inputs are treated as FLT_MIN
+static inline simde__m256 fast_log_ps(simde__m256 x, FastMathTier tier) {
+  // log(m) = 2s + s^3 * p(s^2) with s = (m - 1) / (m + 1), m in [sqrt(1/2), sqrt(2))
+  static const float fast[] = {0.67710339f};
+  static const float balanced[] = {0.66653427f, 0.41287518f};
+  static const float precise[] = {0.66666817f, 0.39973602f, 0.29961302f};
+
+  x = simde_mm256_max_ps(x, simde_mm256_set1_ps(FLT_MIN));
+  simde__m256i bits = simde_mm256_castps_si256(x);
+  simde__m256i e = simde_mm256_sub_epi32(simde_mm256_srli_epi32(bits, 23), simde_mm256_set1_epi32(127));
+  simde__m256 m = simde_mm256_castsi256_ps(simde_mm256_or_si256(simde_mm256_and_si256(bits, simde_mm256_set1_epi32(0x007fffff)), simde_mm256_set1_epi32(0x3f800000)));
+
+  simde__m256 big = simde_mm256_cmp_ps(m, simde_mm256_set1_ps(1.41421356f), SIMDE_CMP_GT_OQ);
+  m = simde_mm256_blendv_ps(m, simde_mm256_mul_ps(m, simde_mm256_set1_ps(0.5f)), big);
+  simde__m256 ef = simde_mm256_add_ps(simde_mm256_cvtepi32_ps(e), simde_mm256_and_ps(big, simde_mm256_set1_ps(1.0f)));
+
+  simde__m256 s = simde_mm256_div_ps(simde_mm256_sub_ps(m, simde_mm256_set1_ps(1.0f)), simde_mm256_add_ps(m, simde_mm256_set1_ps(1.0f)));
+  simde__m256 z = simde_mm256_mul_ps(s, s);
+  simde__m256 p;
+  switch (tier) {
+    case FAST_MATH_FAST: p = fast_poly_ps(z, fast, 1); break;
+    case FAST_MATH_BALANCED: p = fast_poly_ps(z, balanced, 2); break;
+    default: p = fast_poly_ps(z, precise, 3); break;
+  }
+  simde__m256 logm = simde_mm256_add_ps(simde_mm256_add_ps(s, s), simde_mm256_mul_ps(simde_mm256_mul_ps(s, z), p));
+  return simde_mm256_add_ps(simde_mm256_mul_ps(ef, simde_mm256_set1_ps(0.69314718f)), logm);
+}
+
+// a^b for a > 0
+static inline simde__m256 fast_pow_ps(simde__m256 a, simde__m256 b, FastMathTier tier) {
+  return fast_exp_ps(simde_mm256_mul_ps(b, fast_log_ps(a, tier)), tier);
+}
+
+static inline simde__m256 fast_sin_ps(simde__m256 x, FastMathTier tier) {
+  // sin(x) = x + x^3 * p(x^2) on |x| <= pi / 2
+  static const float fast[] = {-0.16607860f, 0.0076337575f};
+  static const float balanced[] = {-0.16665681f, 0.0083123655f, -0.00018492160f};
+  static const float precise[] = {-0.16666657f, 0.0083330173f, -0.00019806614f, 2.6000529e-06f};
+
+  // wrap to [-pi, pi], then fold the outer quarters back onto [-pi/2, pi/2]
+  simde__m256 k = simde_mm256_round_ps(simde_mm256_mul_ps(x, simde_mm256_set1_ps(0.15915494f)), SIMDE_MM_FROUND_TO_NEAREST_INT | SIMDE_MM_FROUND_NO_EXC);
+  x = simde_mm256_sub_ps(x, simde_mm256_mul_ps(k, simde_mm256_set1_ps(FAST_MATH_TWO_PI_HI)));
+  x = simde_mm256_sub_ps(x, simde_mm256_mul_ps(k, simde_mm256_set1_ps(FAST_MATH_TWO_PI_LO)));
+  const simde__m256 pi = simde_mm256_set1_ps(3.14159265f);
+  x = simde_mm256_min_ps(x, simde_mm256_sub_ps(pi, x));
+  x = simde_mm256_max_ps(x, simde_mm256_sub_ps(simde_mm256_sub_ps(simde_mm256_setzero_ps(), pi), x));
+
+  simde__m256 z = simde_mm256_mul_ps(x, x);
+  simde__m256 p;
+  switch (tier) {
+    case FAST_MATH_FAST: p = fast_poly_ps(z, fast, 2); break;
+    case FAST_MATH_BALANCED: p = fast_poly_ps(z, balanced, 3); break;
+    default: p = fast_poly_ps(z, precise, 4); break;
+  }
+  return simde_mm256_add_ps(x, simde_mm256_mul_ps(simde_mm256_mul_ps(x, z), p));
+}
+
+static inline simde__m256 fast_atan_ps(simde__m256 x, FastMathTier tier) {
+  // atan(x) = x + x^3 * p(x^2) on |x| <= tan(pi / 8), reached with the usual two-step reduction
+  static const float fast[] = {-0.30650198f};
+  static const float balanced[] = {-0.33156817f, 0.16856585f};
+  static const float precise[] = {-0.33322892f, 0.19670231f, -0.11053642f};
+
+  const simde__m256 signMask = simde_mm256_set1_ps(-0.0f);
+  simde__m256 sign = simde_mm256_and_ps(x, signMask);
+  simde__m256 ax = simde_mm256_andnot_ps(signMask, x);
+  const simde__m256 one = simde_mm256_set1_ps(1.0f);
+
+  simde__m256 big = simde_mm256_cmp_ps(ax, simde_mm256_set1_ps(2.41421356f), SIMDE_CMP_GT_OQ);
+  simde__m256 mid = simde_mm256_andnot_ps(big, simde_mm256_cmp_ps(ax, simde_mm256_set1_ps(0.41421356f), SIMDE_CMP_GT_OQ));
+  // big: -1 / ax, mid: (ax - 1) / (ax + 1), otherwise ax / 1; one divide either way
+  simde__m256 num = simde_mm256_blendv_ps(simde_mm256_blendv_ps(ax, simde_mm256_sub_ps(ax, one), mid), simde_mm256_set1_ps(-1.0f), big);
+  simde__m256 den = simde_mm256_blendv_ps(simde_mm256_blendv_ps(one, simde_mm256_add_ps(ax, one), mid), ax, big);
+  simde__m256 offset = simde_mm256_or_ps(simde_mm256_and_ps(big, simde_mm256_set1_ps(1.57079633f)), simde_mm256_and_ps(mid, simde_mm256_set1_ps(0.78539816f)));
+  simde__m256 r = simde_mm256_div_ps(num, den);
+
+  simde__m256 z = simde_mm256_mul_ps(r, r);
+  simde__m256 p;
+  switch (tier) {
+    case FAST_MATH_FAST: p = fast_poly_ps(z, fast, 1); break;
+    case FAST_MATH_BALANCED: p = fast_poly_ps(z, balanced, 2); break;
+    default: p = fast_poly_ps(z, precise, 3); break;
+  }
+  simde__m256 y = simde_mm256_add_ps(offset, simde_mm256_add_ps(r, simde_mm256_mul_ps(simde_mm256_mul_ps(r, z), p)));
+  return simde_mm256_or_ps(y, sign);
+}
+
+static inline simde__m256 fast_tanh_ps(simde__m256 x, FastMathTier tier) {
+  // tanh(x) = x + x^3 * p(x^2) near zero, where 1 - 2 / (e^2x + 1) would cancel
+  static const float balanced[] = {-0.33309981f, 0.13007705f, -0.039821097f};
+  static const float precise[] = {-0.33331875f, 0.13302008f, -0.051701679f, 0.014889241f};
+
+  const simde__m256 signMask = simde_mm256_set1_ps(-0.0f);
+  simde__m256 sign = simde_mm256_and_ps(x, signMask);
+  simde__m256 ax = simde_mm256_min_ps(simde_mm256_andnot_ps(signMask, x), simde_mm256_set1_ps(9.0f));
+  simde__m256 e = fast_exp_ps(simde_mm256_add_ps(ax, ax), tier);
+  simde__m256 y = simde_mm256_sub_ps(simde_mm256_set1_ps(1.0f), simde_mm256_div_ps(simde_mm256_set1_ps(2.0f), simde_mm256_add_ps(e, simde_mm256_set1_ps(1.0f))));
+
+  if (tier != FAST_MATH_FAST) {
+    simde__m256 z = simde_mm256_mul_ps(ax, ax);
+    simde__m256 p = (tier == FAST_MATH_BALANCED) ? fast_poly_ps(z, balanced, 3) : fast_poly_ps(z, precise, 4);
+    simde__m256 small = simde_mm256_add_ps(ax, simde_mm256_mul_ps(simde_mm256_mul_ps(ax, z), p));
+    y = simde_mm256_blendv_ps(y, small, simde_mm256_cmp_ps(ax, simde_mm256_set1_ps(0.625f), SIMDE_CMP_LT_OQ));
+  }
+  return simde_mm256_or_ps(y, sign);
+}
+
+static inline float fast_expf(float x, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_exp_ps(simde_mm256_set1_ps(x), tier));
+}
+
+static inline float fast_logf(float x, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_log_ps(simde_mm256_set1_ps(x), tier));
+}
+
+static inline float fast_powf(float a, float b, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_pow_ps(simde_mm256_set1_ps(a), simde_mm256_set1_ps(b), tier));
+}
+
+static inline float fast_sinf(float x, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_sin_ps(simde_mm256_set1_ps(x), tier));
+}
+
+static inline float fast_atanf(float x, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_atan_ps(simde_mm256_set1_ps(x), tier));
+}
+
+static inline float fast_tanhf(float x, FastMathTier tier) {
+  return simde_mm256_cvtss_f32(fast_tanh_ps(simde_mm256_set1_ps(x), tier));
+}
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <simde/x86/avx2.h>
+#include <logger.h>
+
+// Real FFT for power-of-two sizes. A length-n real transform runs as an n/2-point complex FFT on
+// the samples taken as interleaved (even, odd) pairs, followed by a split pass that separates the
+// two halves, so it needs no scratch and works in place.
+//
+// Spectra are "packed": n floats holding bins 0..n/2-1 as interleaved (re, im), except that
+// bin 0's imaginary slot carries the real Nyquist bin n/2 (DC and Nyquist are both real).
+// Forward and inverse are unscaled, fft_inverse(fft_forward(x)) == n * x.
+
+#define FFT_MIN_SIZE 16
+#define FFT_MAX_SIZE 65536
+
+typedef struct {
+  size_t n;           // real length
+  uint32_t* bitrev;   // bit-reversed index for each of the n/2 complex points
+  float* twiddle;     // butterfly twiddles for the stages of half-size 4 and up, interleaved
+  float* split;       // e^(-2 pi i k / n) for k <= n/4, interleaved
+} FFTPlan;
+
+// Plans are built once per size and shared process-wide; they are read-only afterwards, so any
+// number of threads may run transforms on the same plan. Getting a plan can allocate, so do it
+// during setup. Returns NULL for unsupported sizes.
+const FFTPlan* fft_plan_get(size_t n);
+// frees every cached plan; nothing may be using them
+void fft_plan_cache_clear(void);
+
+void fft_forward(const FFTPlan* plan, const float* in, float* out);
+void fft_forward_inplace(const FFTPlan* plan, float* data);
+void fft_inverse(const FFTPlan* plan, const float* in, float* out);
+void fft_inverse_inplace(const FFTPlan* plan, float* data);
+
+// acc += a * b, bin by bin, for packed spectra of real length n
+void fft_spectrum_mac(float* acc, const float* a, const float* b, size_t n);
+
+#endif
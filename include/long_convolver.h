@@ -0,0 +1,66 @@
+#ifndef LONG_CONVOLVER_H
+#define LONG_CONVOLVER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <effects_dsp.h>
+
+// Non-uniform partitioned convolution for reverb-length IRs (seconds, hundreds of thousands of
+// taps) with no added latency.
+//
+// The IR is cut into stages of growing block size. The first stage is a plain Convolver run in
+// the audio callback: a direct-form head plus small partitions. Every later stage starts at least
+// two of its own blocks into the IR, so once one of its input blocks is complete, the output that
+// block contributes isn't due for another (offset - blockSize) samples. Those stages run on worker
+// threads inside that slack.
+//
+// Callback and workers only share single-producer single-consumer rings plus two counters per
+// stage (blocks submitted, blocks done). The callback never blocks. If a worker misses its
+// deadline, that block's contribution is dropped and counted in misses.
+
+#define LONG_CONV_MAX_STAGES 3
+#define LONG_CONV_MAX_WORKERS (LONG_CONV_MAX_STAGES - 1)
+
+typedef struct {
+  Convolver conv;       // owned by the worker running this stage
+  ConvolverIR ir;
+  size_t blockSize;
+  size_t offset;        // first IR tap this stage covers, a multiple of blockSize
+  size_t ringBlocks;    // power of two >= offset / blockSize
+  float* inRing;        // written by the callback
+  float* outRing;       // written by the workers
+  float* scratch;
+  atomic_size_t submitted;  // input blocks complete
+  atomic_size_t done;       // input blocks convolved
+  atomic_int busy;          // a worker holds this stage
+} LongConvolverStage;
+
+typedef struct {
+  Convolver head;
+  ConvolverIR headIR;
+  LongConvolverStage stages[LONG_CONV_MAX_STAGES - 1];
+  size_t numStages;     // worker stages
+  uint64_t time;        // samples processed
+  pthread_t workers[LONG_CONV_MAX_WORKERS];
+  size_t numWorkers;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  atomic_int running;
+  atomic_size_t misses;
+} LongConvolver;
+
+// Allocates everything and starts the workers; returns 0 on success, -1 otherwise
+int long_convolver_init(LongConvolver* lc, const float* taps, size_t numTaps);
+// Stops the workers and frees; the callback must not be running
+void long_convolver_free(LongConvolver* lc);
+// any n, in and out may alias
+void long_convolver_process(LongConvolver* lc, const float* in, float* out, size_t n);
+// Blocks until the workers have caught up with every submitted block. For offline rendering,
+// never from the audio thread.
+void long_convolver_sync(LongConvolver* lc);
+// worker blocks that were late and dropped since init
+size_t long_convolver_misses(LongConvolver* lc);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef LOOPER_H
+#define LOOPER_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <effects_dsp.h>
+
+// Looper with its loop storage in one arena mapped at init. Anonymous by default, so untouched
+// pages cost nothing. It can also be a file mapping, so minutes of loop at 96 kHz can page out to
+// disk and the last loop is still there after a restart. Nothing is allocated after init.
+//
+// Transport changes are requested from any thread through an atomic and picked up at the start
+// of the next looper_process call, so the UI never takes a lock the callback could wait on.
+
+typedef enum {
+  LOOPER_MODE_IDLE,      // input passes through, the loop is kept
+  LOOPER_MODE_RECORD,    // a new loop, replacing the old one
+  LOOPER_MODE_PLAY,      // input plus the loop
+  LOOPER_MODE_OVERDUB    // as play, and the input is layered onto the loop
+} LooperMode;
+
+// first page of a backing file
+typedef struct {
+  char magic[8];
+  uint64_t capacity;     // samples
+  uint64_t length;       // samples in the recorded loop, 0 for none
+  float sampleRate;
+} LooperFileHeader;
+
+typedef struct {
+  float* loop;           // capacity samples
+  size_t capacity;
+  size_t length;         // 0 until a recording is closed
+  size_t pos;
+  LooperMode mode;       // owned by the callback
+  void* mapping;
+  size_t mappingBytes;
+  int fd;                // -1 when anonymous
+  LooperFileHeader* header;  // NULL when anonymous
+  atomic_int request;        // next LooperMode, or -1
+  atomic_int publishedMode;  // mode as of the last process call, for display
+} Looper;
+
+// path NULL for anonymous memory. A file holding a loop recorded at the same sample rate that
+// still fits is reopened with that loop ready to play. Returns 0 on success, -1 otherwise.
+int looper_init(Looper* lp, size_t capacity, float sampleRate, const char* path);
+void looper_free(Looper* lp);
+// any thread; the latest request wins
+void looper_request(Looper* lp, LooperMode mode);
+LooperMode looper_get_mode(Looper* lp);
+// Callback side. fixedLength > 0 closes a recording after that many samples and starts playing it;
+// otherwise a recording runs until the next request or until the arena is full. Any n, in and
+// out may alias.
+void looper_process(Looper* lp, const float* in, float* out, size_t n, size_t fixedLength, float feedback, float overdubLevel);
+
+#endif
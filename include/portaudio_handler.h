@@ -9,6 +9,7 @@
 #include <math.h>
 #include <logger.h>
 #include <string.h>
+#include <effects_interface.h>
 
 /* Forward declaration */
 typedef struct SoundModifier SoundModifier;
@@ -34,6 +35,7 @@ typedef struct AdvancedSoundModifier {
   float attackTime;   /* Attack time in milliseconds */
   float releaseTime;  /* Release time in milliseconds */
   float gain;       /* Make-up gain in dB */
+  Compressor compressor;  /* Envelope and gain state, kept across buffers */
 } AdvancedSoundModifier;
 
 /* Sound modifier with type tag and linked list support */
@@ -140,10 +142,11 @@ SoundModifier* create_simple_modifier(float gain, float bass, float mid, float t
 
 /**
  * Create an advanced sound modifier
+ * @param sampleRate Rate of the stream it will run in, as in AudioStreamConfig
  * @return Pointer to new modifier, or NULL on failure
  */
 SoundModifier* create_advanced_modifier(float threshold, float ratio, float attackTime, 
-                    float releaseTime, float gain);
+                    float releaseTime, float gain, double sampleRate);
 
 /**
  * Add a modifier to the effect chain
@@ -0,0 +1,468 @@
+#include <amp.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define AMP_HALFBAND_TAPS 32
+#define PREAMP_PRESENCE_RANGE_DB 8.0f
+#define POWERAMP_PRESENCE_HZ 3500.0f
+#define POWERAMP_DEPTH_HZ 90.0f
+// headroom is 1 / (1 + depth * load) at full sag, so flat out it clips 6 dB early
+#define POWERAMP_SAG_DEPTH 1.0f
+// how far full sag and full load pull the bias colder, table units
+#define POWERAMP_SAG_BIAS 0.15f
+
+static float preamp_tone_db(float knob, float range) {
+  return (clampf(knob, 0.0f, 1.0f) - 0.5f) * 2.0f * range;
+}
+
+// the gain knob's share of the gain stage's drive, audio taper
+static void preamp_apply_gain(Preamp* p) {
+  PreampChannel* ch = p->channel;
+  if (ch == NULL) {
+    return;
+  }
+  const PreampVoicing* v = &ch->voicing;
+  const size_t s = v->gainStage < v->numStages ? v->gainStage : 0;
+  const float g = clampf(p->gain, 0.0f, 1.0f);
+  ch->stages[s].drive = v->stages[s].drive / v->stages[s].tableRange * (0.01f + 0.99f * g * g);
+}
+
+int preamp_init(Preamp* p, float sampleRate, size_t factor) {
+  memset(p, 0, sizeof(*p));
+  p->sampleRate = sampleRate;
+  p->factor = factor;
+  if (factor != 1 && oversampler_init(&p->os, factor, AMP_HALFBAND_TAPS) != 0) {
+    return -1;
+  }
+  p->scratch = malloc(PREAMP_CHUNK * factor * sizeof(float));
+  if (p->scratch == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate preamp buffers");
+    return -1;
+  }
+  p->gain = 0.5f;
+  p->bassKnob = p->midKnob = p->trebleKnob = p->presenceKnob = 0.5f;
+  biquad_init(&p->presence, BQ_HIGHSHELF, 4000.0f, 0.707f, 0.0f, sampleRate);
+  return 0;
+}
+
+static void preamp_channel_free(PreampChannel* ch) {
+  for (size_t s = 0; s < ch->voicing.numStages; s++) {
+    tube_table_release(ch->stages[s].table);
+    ch->stages[s].table = NULL;
+  }
+  tone_stack_free(&ch->tone);
+}
+
+static void preamp_free_channels(Preamp* p) {
+  for (size_t c = 0; c < p->numChannels; c++) {
+    preamp_channel_free(&p->channels[c]);
+  }
+  free(p->channels);
+  p->channels = NULL;
+  p->numChannels = 0;
+  p->channel = NULL;
+}
+
+void preamp_free(Preamp* p) {
+  preamp_free_channels(p);
+  free(p->scratch);
+  p->scratch = NULL;
+}
+
+static void preamp_channel_reset(PreampChannel* ch) {
+  for (size_t s = 0; s < ch->voicing.numStages; s++) {
+    ch->stages[s].cathode.z1 = ch->stages[s].cathode.z2 = 0.0f;
+    ch->stages[s].coupling.z1 = 0.0f;
+  }
+  tone_stack_reset(&ch->tone);
+}
+
+void preamp_reset(Preamp* p) {
+  if (p->factor != 1) {
+    oversampler_reset(&p->os);
+  }
+  if (p->channel != NULL) {
+    preamp_channel_reset(p->channel);
+  }
+  p->presence.z1 = p->presence.z2 = 0.0f;
+}
+
+static int preamp_channel_init(PreampChannel* ch, const PreampVoicing* voicing, float rate) {
+  if (voicing->numStages == 0 || voicing->numStages > PREAMP_MAX_STAGES) {
+    log_message(LOG_LEVEL_ERROR, "Preamp voicing needs 1 to %d stages, got %zu", PREAMP_MAX_STAGES, voicing->numStages);
+    return -1;
+  }
+  memset(ch, 0, sizeof(*ch));
+  if (tone_stack_init(&ch->tone, voicing->toneStack, rate) != 0) {
+    return -1;
+  }
+  ch->voicing = *voicing;
+  for (size_t s = 0; s < voicing->numStages; s++) {
+    const PreampStageVoicing* v = &voicing->stages[s];
+    PreampStage* st = &ch->stages[s];
+    st->table = tube_table_acquire(TUBE_TRIODE, &v->tube, -v->tableRange, v->tableRange, PREAMP_TABLE_SIZE);
+    if (st->table == NULL) {
+      // only the stages before this one hold tables
+      ch->voicing.numStages = s;
+      preamp_channel_free(ch);
+      return -1;
+    }
+    st->drive = v->drive / v->tableRange;
+    biquad_init(&st->cathode, BQ_LOWSHELF, v->cathodeHz, 0.707f, fminf(v->cathodeDb, 0.0f), rate);
+    onepole_init(&st->coupling, v->couplingHz, rate, 1);
+  }
+  return 0;
+}
+
+int preamp_set_voicings(Preamp* p, const PreampVoicing* voicings, size_t count) {
+  if (count == 0) {
+    log_message(LOG_LEVEL_ERROR, "Preamp needs at least one voicing");
+    return -1;
+  }
+  PreampChannel* channels = malloc(count * sizeof(PreampChannel));
+  if (channels == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate preamp voicings");
+    return -1;
+  }
+  const float rate = p->sampleRate * (float)p->factor;
+  for (size_t c = 0; c < count; c++) {
+    if (preamp_channel_init(&channels[c], &voicings[c], rate) != 0) {
+      for (size_t k = 0; k < c; k++) {
+        preamp_channel_free(&channels[k]);
+      }
+      free(channels);
+      return -1;
+    }
+  }
+
+  preamp_free_channels(p);
+  p->channels = channels;
+  p->numChannels = count;
+  preamp_select_voicing(p, 0);
+  return 0;
+}
+
+void preamp_select_voicing(Preamp* p, size_t index) {
+  if (index >= p->numChannels || &p->channels[index] == p->channel) {
+    return;
+  }
+  // the filters start from rest, as a freshly voiced amp would
+  p->channel = &p->channels[index];
+  preamp_channel_reset(p->channel);
+  tone_stack_set_knobs(&p->channel->tone, p->trebleKnob, p->midKnob, p->bassKnob);
+  preamp_apply_gain(p);
+}
+
+void preamp_set_controls(Preamp* p, float gain, float bass, float mid, float treble, float presence) {
+  if (gain != p->gain) {
+    p->gain = gain;
+    preamp_apply_gain(p);
+  }
+  if (bass != p->bassKnob || mid != p->midKnob || treble != p->trebleKnob) {
+    p->bassKnob = bass;
+    p->midKnob = mid;
+    p->trebleKnob = treble;
+    if (p->channel != NULL) {
+      tone_stack_set_knobs(&p->channel->tone, treble, mid, bass);
+    }
+  }
+  if (presence != p->presenceKnob) {
+    p->presenceKnob = presence;
+    biquad_set_params(&p->presence, BQ_HIGHSHELF, 4000.0f, 0.707f, preamp_tone_db(presence, PREAMP_PRESENCE_RANGE_DB), p->sampleRate);
+  }
+}
+
+static void preamp_scale(float* x, float gain, size_t n) {
+  const simde__m256 g = simde_mm256_set1_ps(gain);
+  size_t i = 0;
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde_mm256_storeu_ps(&x[i], simde_mm256_mul_ps(simde_mm256_loadu_ps(&x[i]), g));
+  }
+  for (; i < n; i++) {
+    x[i] *= gain;
+  }
+}
+
+void preamp_process(Preamp* p, const float* in, float* out, size_t n) {
+  PreampChannel* ch = p->channel;
+  if (ch == NULL) {
+    if (in != out) {
+      memmove(out, in, n * sizeof(float));
+    }
+    return;
+  }
+  const size_t factor = p->factor;
+  const size_t toneStage = ch->voicing.toneStage;
+  float* x = p->scratch;
+  for (size_t done = 0; done < n; done += PREAMP_CHUNK) {
+    const size_t run = n - done < PREAMP_CHUNK ? n - done : PREAMP_CHUNK;
+    const size_t len = run * factor;
+    if (factor == 1) {
+      memcpy(x, in + done, run * sizeof(float));
+    } else {
+      oversampler_upsample(&p->os, in + done, x, run);
+    }
+
+    for (size_t s = 0; s < ch->voicing.numStages; s++) {
+      PreampStage* st = &ch->stages[s];
+      preamp_scale(x, st->drive, len);
+      waveshaper_lookup_linear(x, x, st->table, PREAMP_TABLE_SIZE, len);
+      biquad_process_inplace(&st->cathode, x, len);
+      onepole_process(&st->coupling, x, x, len);
+      if (s == toneStage) {
+        tone_stack_process(&ch->tone, x, x, len);
+      }
+    }
+
+    if (factor == 1) {
+      memcpy(out + done, x, run * sizeof(float));
+    } else {
+      oversampler_downsample(&p->os, x, out + done, run);
+    }
+    preamp_scale(out + done, ch->voicing.outputLevel, run);
+    biquad_process_inplace(&p->presence, out + done, run);
+  }
+}
+
+size_t preamp_latency(const Preamp* p) {
+  return p->factor == 1 ? 0 : oversampler_latency(&p->os);
+}
+
+int poweramp_init(PowerAmp* p, float sampleRate, size_t factor) {
+  memset(p, 0, sizeof(*p));
+  p->sampleRate = sampleRate;
+  p->factor = factor;
+  if (factor != 1 && oversampler_init(&p->os, factor, AMP_HALFBAND_TAPS) != 0) {
+    return -1;
+  }
+  p->scratch = malloc(3 * POWERAMP_CHUNK * factor * sizeof(float));
+  if (p->scratch == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate power amp buffers");
+    return -1;
+  }
+  p->master = 0.5f;
+  p->sag = 0.5f;
+  p->bias = 0.5f;
+  p->headroom = 1.0f;
+  biquad_init(&p->presence, BQ_HIGHSHELF, POWERAMP_PRESENCE_HZ, 0.707f, 0.0f, sampleRate);
+  biquad_init(&p->depth, BQ_LOWSHELF, POWERAMP_DEPTH_HZ, 0.707f, 0.0f, sampleRate);
+  return 0;
+}
+
+static void poweramp_free_channels(PowerAmp* p) {
+  for (size_t c = 0; c < p->numChannels; c++) {
+    tube_table_release(p->channels[c].table);
+  }
+  free(p->channels);
+  p->channels = NULL;
+  p->numChannels = 0;
+  p->channel = NULL;
+}
+
+void poweramp_free(PowerAmp* p) {
+  poweramp_free_channels(p);
+  free(p->scratch);
+  p->scratch = NULL;
+}
+
+void poweramp_reset(PowerAmp* p) {
+  if (p->factor != 1) {
+    oversampler_reset(&p->os);
+  }
+  p->presence.z1 = p->presence.z2 = 0.0f;
+  p->depth.z1 = p->depth.z2 = 0.0f;
+  p->envelope = 0.0f;
+  p->load = 0.0f;
+  p->headroom = 1.0f;
+  p->headroomStep = 0.0f;
+  p->shift = p->biasShift;
+  p->shiftStep = 0.0f;
+  p->countdown = 0;
+}
+
+// everything the knobs and the voicing decide between them
+static void poweramp_apply_controls(PowerAmp* p) {
+  if (p->channel == NULL) {
+    return;
+  }
+  const PowerAmpVoicing* v = &p->channel->voicing;
+  const float master = clampf(p->master, 0.0f, 1.0f);
+  p->drive = v->drive / v->tableRange * (0.01f + 0.99f * master * master);
+  p->biasShift = (clampf(p->bias, 0.0f, 1.0f) - 0.5f) * 2.0f * v->biasRange / v->tableRange;
+  biquad_set_params(&p->presence, BQ_HIGHSHELF, POWERAMP_PRESENCE_HZ, 0.707f, clampf(p->presenceKnob, 0.0f, 1.0f) * v->feedbackDb, p->sampleRate);
+  biquad_set_params(&p->depth, BQ_LOWSHELF, POWERAMP_DEPTH_HZ, 0.707f, clampf(p->depthKnob, 0.0f, 1.0f) * v->feedbackDb, p->sampleRate);
+}
+
+int poweramp_set_voicings(PowerAmp* p, const PowerAmpVoicing* voicings, size_t count) {
+  if (count == 0) {
+    log_message(LOG_LEVEL_ERROR, "Power amp needs at least one voicing");
+    return -1;
+  }
+  PowerAmpChannel* channels = malloc(count * sizeof(PowerAmpChannel));
+  if (channels == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate power amp voicings");
+    return -1;
+  }
+  for (size_t c = 0; c < count; c++) {
+    const PowerAmpVoicing* v = &voicings[c];
+    const float* table = tube_table_acquire(v->stage, &v->tube, -v->tableRange, v->tableRange, POWERAMP_TABLE_SIZE);
+    if (table == NULL) {
+      for (size_t k = 0; k < c; k++) {
+        tube_table_release(channels[k].table);
+      }
+      free(channels);
+      return -1;
+    }
+    const float swing = 0.5f * (table[POWERAMP_TABLE_SIZE - 1] - table[0]);
+    channels[c].voicing = *v;
+    channels[c].table = table;
+    channels[c].outputScale = swing > 0.0f ? 1.0f / swing : 1.0f;
+  }
+
+  poweramp_free_channels(p);
+  p->channels = channels;
+  p->numChannels = count;
+  poweramp_select_voicing(p, 0);
+  return 0;
+}
+
+void poweramp_select_voicing(PowerAmp* p, size_t index) {
+  if (index >= p->numChannels || &p->channels[index] == p->channel) {
+    return;
+  }
+  p->channel = &p->channels[index];
+  const float controlRate = p->sampleRate / (float)POWERAMP_CONTROL_INTERVAL;
+  p->attackCoeff = ms_to_coeff(p->channel->voicing.sagAttackMs, controlRate);
+  p->releaseCoeff = ms_to_coeff(p->channel->voicing.sagReleaseMs, controlRate);
+  poweramp_apply_controls(p);
+}
+
+void poweramp_set_controls(PowerAmp* p, float master, float sag, float presence, float depth, float bias) {
+  if (master == p->master && sag == p->sag && presence == p->presenceKnob && depth == p->depthKnob && bias == p->bias) {
+    return;
+  }
+  p->master = master;
+  p->sag = clampf(sag, 0.0f, 1.0f);
+  p->presenceKnob = presence;
+  p->depthKnob = depth;
+  p->bias = bias;
+  poweramp_apply_controls(p);
+}
+
+// Supply envelope from the last interval's load, and the headroom and bias it implies as ramp
+// targets for the next one.
+static void poweramp_control_point(PowerAmp* p, size_t interval) {
+  const float level = p->load / (float)interval;
+  const float coeff = level > p->envelope ? p->attackCoeff : p->releaseCoeff;
+  p->envelope += coeff * (level - p->envelope);
+  p->load = 0.0f;
+
+  const float sagged = p->sag * p->envelope;
+  const float headroom = 1.0f / (1.0f + POWERAMP_SAG_DEPTH * sagged);
+  const float shift = p->biasShift - POWERAMP_SAG_BIAS * sagged;
+  p->headroomStep = (headroom - p->headroom) / (float)interval;
+  p->shiftStep = (shift - p->shift) / (float)interval;
+  p->countdown = interval;
+}
+
+// n samples along the current ramps, in place
+static void poweramp_segment(PowerAmp* p, float* x, float* push, float* pull, size_t n) {
+  const simde__m256 lane = simde_mm256_setr_ps(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f);
+  const simde__m256 h0 = simde_mm256_set1_ps(p->headroom);
+  const simde__m256 hStep = simde_mm256_set1_ps(p->headroomStep);
+  const simde__m256 s0 = simde_mm256_set1_ps(p->shift);
+  const simde__m256 sStep = simde_mm256_set1_ps(p->shiftStep);
+  const simde__m256 drive = simde_mm256_set1_ps(p->drive);
+  size_t i = 0;
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde__m256 k = simde_mm256_add_ps(simde_mm256_set1_ps((float)i), lane);
+    simde__m256 h = simde_mm256_add_ps(h0, simde_mm256_mul_ps(k, hStep));
+    simde__m256 s = simde_mm256_add_ps(s0, simde_mm256_mul_ps(k, sStep));
+    simde__m256 g = simde_mm256_div_ps(simde_mm256_mul_ps(simde_mm256_loadu_ps(&x[i]), drive), h);
+    simde_mm256_storeu_ps(&push[i], simde_mm256_add_ps(s, g));
+    simde_mm256_storeu_ps(&pull[i], simde_mm256_sub_ps(s, g));
+  }
+  for (; i < n; i++) {
+    float k = (float)(i + 1);
+    float g = x[i] * p->drive / (p->headroom + k * p->headroomStep);
+    float s = p->shift + k * p->shiftStep;
+    push[i] = s + g;
+    pull[i] = s - g;
+  }
+
+  waveshaper_lookup_linear(push, push, p->channel->table, POWERAMP_TABLE_SIZE, n);
+  waveshaper_lookup_linear(pull, pull, p->channel->table, POWERAMP_TABLE_SIZE, n);
+
+  const float scale = 0.5f * p->channel->outputScale;
+  const simde__m256 vScale = simde_mm256_set1_ps(scale);
+  const simde__m256 signMask = simde_mm256_set1_ps(-0.0f);
+  simde__m256 acc = simde_mm256_setzero_ps();
+  float load = 0.0f;
+  for (i = 0; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde__m256 k = simde_mm256_add_ps(simde_mm256_set1_ps((float)i), lane);
+    simde__m256 h = simde_mm256_add_ps(h0, simde_mm256_mul_ps(k, hStep));
+    simde__m256 d = simde_mm256_sub_ps(simde_mm256_loadu_ps(&push[i]), simde_mm256_loadu_ps(&pull[i]));
+    simde__m256 y = simde_mm256_mul_ps(d, simde_mm256_mul_ps(h, vScale));
+    simde_mm256_storeu_ps(&x[i], y);
+    acc = simde_mm256_add_ps(acc, simde_mm256_andnot_ps(signMask, y));
+  }
+  for (; i < n; i++) {
+    x[i] = (push[i] - pull[i]) * (p->headroom + (float)(i + 1) * p->headroomStep) * scale;
+    load += fabsf(x[i]);
+  }
+  float lanes[SIMD_LANES];
+  simde_mm256_storeu_ps(lanes, acc);
+  for (size_t l = 0; l < SIMD_LANES; l++) {
+    load += lanes[l];
+  }
+
+  p->load += load;
+  p->headroom += (float)n * p->headroomStep;
+  p->shift += (float)n * p->shiftStep;
+  p->countdown -= n;
+}
+
+void poweramp_process(PowerAmp* p, const float* in, float* out, size_t n) {
+  if (p->channel == NULL) {
+    if (in != out) {
+      memmove(out, in, n * sizeof(float));
+    }
+    return;
+  }
+  const size_t factor = p->factor;
+  const size_t interval = POWERAMP_CONTROL_INTERVAL * factor;
+  float* x = p->scratch;
+  float* push = x + POWERAMP_CHUNK * factor;
+  float* pull = push + POWERAMP_CHUNK * factor;
+  for (size_t done = 0; done < n; done += POWERAMP_CHUNK) {
+    const size_t run = n - done < POWERAMP_CHUNK ? n - done : POWERAMP_CHUNK;
+    const size_t len = run * factor;
+    // the feedback shelves run at the base rate, staged where the upsampler can read them
+    float* base = factor == 1 ? x : pull;
+    memcpy(base, in + done, run * sizeof(float));
+    biquad_process_inplace(&p->presence, base, run);
+    biquad_process_inplace(&p->depth, base, run);
+    if (factor != 1) {
+      oversampler_upsample(&p->os, base, x, run);
+    }
+
+    for (size_t i = 0; i < len;) {
+      if (p->countdown == 0) {
+        poweramp_control_point(p, interval);
+      }
+      const size_t seg = len - i < p->countdown ? len - i : p->countdown;
+      poweramp_segment(p, x + i, push, pull, seg);
+      i += seg;
+    }
+
+    if (factor == 1) {
+      memcpy(out + done, x, run * sizeof(float));
+    } else {
+      oversampler_downsample(&p->os, x, out + done, run);
+    }
+  }
+}
+
+size_t poweramp_latency(const PowerAmp* p) {
+  return p->factor == 1 ? 0 : oversampler_latency(&p->os);
+}
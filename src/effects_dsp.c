@@ -1,6 +1,9 @@
 #include <effects_dsp.h>
+#include <pthread.h>
+#include <string.h>
+#include <stdlib.h>
 
-// implementations assumes 1 channel input and output, can be fixed upto 8 using simd
+// scalar implementations assume 1 channel input and output, the *_bank variants run SIMD_LANES channels at once
 
 // Stateless:
 
@@ -42,21 +45,124 @@ void hard_clip(const float* in, float threshold, float* out, size_t numSamples)
 }
 
 void tanh_clip(const float* in, float drive, float* out, size_t numSamples) {
-  for (size_t n = 0; n < numSamples; n++) {
-    out[n] = tanhf(in[n] * drive);
+  size_t n = 0;
+#ifdef DSP_FAST_MATH_TIER
+  const simde__m256 d = simde_mm256_set1_ps(drive);
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde_mm256_storeu_ps(&out[n], fast_tanh_ps(simde_mm256_mul_ps(simde_mm256_loadu_ps(&in[n]), d), DSP_FAST_MATH_TIER));
+  }
+#endif
+  for (; n < numSamples; n++) {
+    out[n] = dsp_tanhf(in[n] * drive);
   }
 }
 
 void arctan_clip(const float* in, float drive, float* out, size_t numSamples) {
-  for (size_t n = 0; n < numSamples; n++) {
-    out[n] = (2.0f / M_PI) * atanf(in[n] * drive);
+  size_t n = 0;
+#ifdef DSP_FAST_MATH_TIER
+  const simde__m256 d = simde_mm256_set1_ps(drive);
+  const simde__m256 scale = simde_mm256_set1_ps(2.0f / M_PI);
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 y = fast_atan_ps(simde_mm256_mul_ps(simde_mm256_loadu_ps(&in[n]), d), DSP_FAST_MATH_TIER);
+    simde_mm256_storeu_ps(&out[n], simde_mm256_mul_ps(scale, y));
+  }
+#endif
+  for (; n < numSamples; n++) {
+    out[n] = (2.0f / M_PI) * dsp_atanf(in[n] * drive);
   }
 }
 
-void white_noise(float* out, size_t n) {
-  for (size_t i = 0; i < n; i++) {
-    out[i] = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+static uint64_t splitmix64(uint64_t* x) {
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+void noise_seed(NoiseGen* gen, uint64_t seed) {
+  for (size_t k = 0; k < SIMD_LANES; k++) {
+    for (size_t w = 0; w < 4; w += 2) {
+      uint64_t r = splitmix64(&seed);
+      gen->s[w][k] = (uint32_t)r;
+      gen->s[w + 1][k] = (uint32_t)(r >> 32);
+    }
+  }
+}
+
+static inline simde__m256i noise_rotl(simde__m256i x, int k) {
+  return simde_mm256_or_si256(simde_mm256_slli_epi32(x, k), simde_mm256_srli_epi32(x, 32 - k));
+}
+
+// one xoshiro128+ step on all lanes
+static inline simde__m256i noise_next(simde__m256i s[4]) {
+  simde__m256i result = simde_mm256_add_epi32(s[0], s[3]);
+  simde__m256i t = simde_mm256_slli_epi32(s[1], 9);
+  s[2] = simde_mm256_xor_si256(s[2], s[0]);
+  s[3] = simde_mm256_xor_si256(s[3], s[1]);
+  s[1] = simde_mm256_xor_si256(s[1], s[2]);
+  s[0] = simde_mm256_xor_si256(s[0], s[3]);
+  s[2] = simde_mm256_xor_si256(s[2], t);
+  s[3] = noise_rotl(s[3], 11);
+  return result;
+}
+
+// the top 24 bits (the low bits of xoshiro+ are weak) scaled to [0, 1)
+static inline simde__m256 noise_unit(simde__m256i r) {
+  return simde_mm256_mul_ps(simde_mm256_cvtepi32_ps(simde_mm256_srli_epi32(r, 8)), simde_mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+static inline void noise_load(const NoiseGen* gen, simde__m256i s[4]) {
+  for (size_t w = 0; w < 4; w++) {
+    s[w] = simde_mm256_loadu_si256((const simde__m256i*)gen->s[w]);
+  }
+}
+
+static inline void noise_store(NoiseGen* gen, const simde__m256i s[4]) {
+  for (size_t w = 0; w < 4; w++) {
+    simde_mm256_storeu_si256((simde__m256i*)gen->s[w], s[w]);
+  }
+}
+
+void white_noise(NoiseGen* gen, float* out, size_t n) {
+  const simde__m256 two = simde_mm256_set1_ps(2.0f);
+  const simde__m256 one = simde_mm256_set1_ps(1.0f);
+  simde__m256i s[4];
+  noise_load(gen, s);
+  size_t i = 0;
+  for (; i < n; i += SIMD_LANES) {
+    simde__m256 v = simde_mm256_sub_ps(simde_mm256_mul_ps(noise_unit(noise_next(s)), two), one);
+    if (i + SIMD_LANES <= n) {
+      simde_mm256_storeu_ps(&out[i], v);
+    } else {
+      float tail[SIMD_LANES];
+      simde_mm256_storeu_ps(tail, v);
+      memcpy(&out[i], tail, (n - i) * sizeof(float));
+    }
+  }
+  noise_store(gen, s);
+}
+
+// Box-Muller gives two normals per pair of uniforms, so each step fills two vectors
+void gaussian_noise(NoiseGen* gen, float* out, size_t n) {
+  const simde__m256 half = simde_mm256_set1_ps(0.5f / 16777216.0f);
+  const simde__m256 minusTwo = simde_mm256_set1_ps(-2.0f);
+  const simde__m256 twoPi = simde_mm256_set1_ps(2.0f * M_PI);
+  const simde__m256 quarter = simde_mm256_set1_ps(0.25f);
+  simde__m256i s[4];
+  noise_load(gen, s);
+  size_t i = 0;
+  for (; i < n; i += 2 * SIMD_LANES) {
+    // shifted half a step so u1 is never 0
+    simde__m256 u1 = simde_mm256_add_ps(noise_unit(noise_next(s)), half);
+    simde__m256 u2 = noise_unit(noise_next(s));
+    simde__m256 r = simde_mm256_sqrt_ps(simde_mm256_mul_ps(minusTwo, fast_log_ps(u1, FAST_MATH_PRECISE)));
+    float z[2 * SIMD_LANES];
+    simde_mm256_storeu_ps(z, simde_mm256_mul_ps(r, fast_sin_ps(simde_mm256_mul_ps(twoPi, u2), FAST_MATH_PRECISE)));
+    simde_mm256_storeu_ps(z + SIMD_LANES, simde_mm256_mul_ps(r, fast_sin_ps(simde_mm256_mul_ps(twoPi, simde_mm256_add_ps(u2, quarter)), FAST_MATH_PRECISE)));
+    size_t count = n - i < 2 * SIMD_LANES ? n - i : 2 * SIMD_LANES;
+    memcpy(&out[i], z, count * sizeof(float));
   }
+  noise_store(gen, s);
 }
 
 float hz_to_omega(float hz, float sampleRate) {
@@ -78,6 +184,59 @@ void compute_gain_reduction_db(const float* inputDb, const float* thresholdDb, f
   }
 }
 
+// With d the level over the threshold and W the knee, the reduction is slope * (c^2 / 2W + max(0,
+// d - W/2)) where c = clamp(d + W/2, 0, W): zero below the knee, quadratic across it, and the hard
+// knee's slope * d above it
+void compute_gain_reduction_db_soft(const float* inputDb, float thresholdDb, float ratio, float kneeDb, float* out, size_t numSamples) {
+  const float slope = 1.0f - (1.0f / ratio);
+  const float knee = fmaxf(kneeDb, 1e-3f);
+  const float half = 0.5f * knee;
+  const float curve = slope / (2.0f * knee);
+  const simde__m256 vThreshold = simde_mm256_set1_ps(thresholdDb);
+  const simde__m256 vHalf = simde_mm256_set1_ps(half);
+  const simde__m256 vKnee = simde_mm256_set1_ps(knee);
+  const simde__m256 vCurve = simde_mm256_set1_ps(curve);
+  const simde__m256 vSlope = simde_mm256_set1_ps(slope);
+  const simde__m256 zero = simde_mm256_setzero_ps();
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 d = simde_mm256_sub_ps(simde_mm256_loadu_ps(&inputDb[n]), vThreshold);
+    simde__m256 c = simde_mm256_min_ps(vKnee, simde_mm256_max_ps(zero, simde_mm256_add_ps(d, vHalf)));
+    simde__m256 above = simde_mm256_max_ps(zero, simde_mm256_sub_ps(d, vHalf));
+    simde__m256 r = simde_mm256_add_ps(simde_mm256_mul_ps(vCurve, simde_mm256_mul_ps(c, c)), simde_mm256_mul_ps(vSlope, above));
+    simde_mm256_storeu_ps(&out[n], simde_mm256_sub_ps(zero, r));
+  }
+  for (; n < numSamples; n++) {
+    float d = inputDb[n] - thresholdDb;
+    float c = clampf(d + half, 0.0f, knee);
+    out[n] = -(curve * c * c + slope * fmaxf(0.0f, d - half));
+  }
+}
+
+void linear_to_db_block(const float* in, float* out, size_t numSamples) {
+  const simde__m256 scale = simde_mm256_set1_ps(8.68588964f);  // 20 / ln(10)
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 x = fast_log_ps(simde_mm256_loadu_ps(&in[n]), FAST_MATH_BALANCED);
+    simde_mm256_storeu_ps(&out[n], simde_mm256_mul_ps(scale, x));
+  }
+  for (; n < numSamples; n++) {
+    out[n] = 8.68588964f * fast_logf(in[n], FAST_MATH_BALANCED);
+  }
+}
+
+void db_to_linear_block(const float* in, float* out, size_t numSamples) {
+  const simde__m256 scale = simde_mm256_set1_ps(0.115129255f);  // ln(10) / 20
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 x = simde_mm256_mul_ps(scale, simde_mm256_loadu_ps(&in[n]));
+    simde_mm256_storeu_ps(&out[n], fast_exp_ps(x, FAST_MATH_BALANCED));
+  }
+  for (; n < numSamples; n++) {
+    out[n] = fast_expf(0.115129255f * in[n], FAST_MATH_BALANCED);
+  }
+}
+
 void build_waveshaper_table(float *lookupTable, size_t tableSize, ClipperType type, float drive) {
   if (tableSize < 2) {
     return;
@@ -111,11 +270,42 @@ void build_waveshaper_table(float *lookupTable, size_t tableSize, ClipperType ty
   }
 }
 
+// Table lookups run SIMD_LANES samples per step: clamp, index and fraction are computed with
+// min/max instead of branches, and the table taps are fetched with gathers (native on AVX2,
+// emulated lane by lane by simde elsewhere). The scalar loops only handle the tail.
+
+// max/min return their second operand when either is NaN, so x goes first: NaN clamps to -1 the
+// way fmaxf does instead of reaching the gathers as a garbage index
+static inline simde__m256 waveshaper_index(simde__m256 x, simde__m256 scale) {
+  x = simde_mm256_min_ps(simde_mm256_max_ps(x, simde_mm256_set1_ps(-1.0f)), simde_mm256_set1_ps(1.0f));
+  return simde_mm256_mul_ps(simde_mm256_add_ps(x, simde_mm256_set1_ps(1.0f)), scale);
+}
+
+// i0 is capped at tableSize - 2 so i0 + 1 is always in range; at the top edge frac becomes 1.0,
+// which lands on the last entry exactly like the scalar clamp did
+static size_t waveshaper_lookup_linear_simd(const float* in, float* out, const float* table, size_t tableSize, size_t numSamples) {
+  const simde__m256 scale = simde_mm256_set1_ps((float)(tableSize - 1) * 0.5f);
+  const simde__m256i maxI0 = simde_mm256_set1_epi32((int32_t)tableSize - 2);
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 idx = waveshaper_index(simde_mm256_loadu_ps(&in[n]), scale);
+    simde__m256i i0 = simde_mm256_min_epi32(simde_mm256_cvttps_epi32(idx), maxI0);
+    simde__m256 frac = simde_mm256_sub_ps(idx, simde_mm256_cvtepi32_ps(i0));
+    simde__m256 y0 = simde_mm256_i32gather_ps(table, i0, 4);
+    simde__m256 y1 = simde_mm256_i32gather_ps(table + 1, i0, 4);
+    simde_mm256_storeu_ps(&out[n], simde_mm256_add_ps(y0, simde_mm256_mul_ps(frac, simde_mm256_sub_ps(y1, y0))));
+  }
+  return n;
+}
+
 void waveshaper_lookup(const float* in, float* out, const float* lookupTable, size_t tableSize, size_t numSamples) {
+  if (tableSize < 2 || lookupTable == NULL) {
+    return;
+  }
   const float half = 0.5f;
   const float scale = (float)(tableSize - 1) * half;
 
-  for (size_t n = 0; n < numSamples; n++) {
+  for (size_t n = waveshaper_lookup_linear_simd(in, out, lookupTable, tableSize, numSamples); n < numSamples; n++) {
     float x = fminf(1.0f, fmaxf(-1.0f, in[n]));
     float idx = (x + 1.0f) * scale;
     size_t i0 = (size_t)idx;
@@ -129,10 +319,12 @@ void waveshaper_lookup(const float* in, float* out, const float* lookupTable, si
 }
 
 void waveshaper_lookup_linear(const float* in, float* out, const float* table, size_t N, size_t nSamples) {
+  if (N < 2 || table == NULL) {
+    return;
+  }
   const float scale = (float)(N - 1) * 0.5f;
-  for (size_t i = 0; i < nSamples; i++) {
-    float x = in[i] * scale + scale;
-    x = (x < 0.0f) ? 0.0f : (x > (float)(N - 1) ? (float)(N - 1) : x);
+  for (size_t i = waveshaper_lookup_linear_simd(in, out, table, N, nSamples); i < nSamples; i++) {
+    float x = fminf(fmaxf(in[i] * scale + scale, 0.0f), (float)(N - 1));
     size_t idx = (size_t)x;
     float frac = x - (float)idx;
     float y0 = table[idx];
@@ -141,16 +333,44 @@ void waveshaper_lookup_linear(const float* in, float* out, const float* table, s
   }
 }
 
+static inline simde__m256 cubic_interp_simd(simde__m256 ym1, simde__m256 y0, simde__m256 y1, simde__m256 y2, simde__m256 t) {
+  const simde__m256 half = simde_mm256_set1_ps(0.5f);
+  const simde__m256 oneHalf = simde_mm256_set1_ps(1.5f);
+  simde__m256 a = simde_mm256_add_ps(simde_mm256_mul_ps(oneHalf, simde_mm256_sub_ps(y0, y1)), simde_mm256_mul_ps(half, simde_mm256_sub_ps(y2, ym1)));
+  simde__m256 b = simde_mm256_sub_ps(simde_mm256_add_ps(ym1, simde_mm256_add_ps(y1, y1)), simde_mm256_add_ps(simde_mm256_mul_ps(simde_mm256_set1_ps(2.5f), y0), simde_mm256_mul_ps(half, y2)));
+  simde__m256 c = simde_mm256_mul_ps(half, simde_mm256_sub_ps(y1, ym1));
+  return simde_mm256_add_ps(simde_mm256_mul_ps(simde_mm256_add_ps(simde_mm256_mul_ps(simde_mm256_add_ps(simde_mm256_mul_ps(a, t), b), t), c), t), y0);
+}
+
 void waveshaper_lookup_cubic(const float* in, float* out, const float* lookupTable, size_t tableSize, size_t numSamples) {
   if (tableSize < 4 || lookupTable == NULL) {
     return; 
   }
   const float half_scale = (float)(tableSize - 1) * 0.5f;
   const size_t max_idx = tableSize - 1;
-  for (size_t n = 0; n < numSamples; n++) {
-    float x = in[n];
-    if (x > 1.0f) x = 1.0f;
-    else if (x < -1.0f) x = -1.0f;
+  const simde__m256 scale = simde_mm256_set1_ps(half_scale);
+  const simde__m256i zero = simde_mm256_setzero_si256();
+  const simde__m256i one = simde_mm256_set1_epi32(1);
+  const simde__m256i maxIdx = simde_mm256_set1_epi32((int32_t)max_idx);
+  size_t n = 0;
+
+  // edge taps are clamped into the table with min/max, waveshaper_lookup_cubic_padded skips even that
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 idx = waveshaper_index(simde_mm256_loadu_ps(&in[n]), scale);
+    simde__m256i i0 = simde_mm256_cvttps_epi32(idx);
+    simde__m256 t = simde_mm256_sub_ps(idx, simde_mm256_cvtepi32_ps(i0));
+    simde__m256i im1 = simde_mm256_max_epi32(simde_mm256_sub_epi32(i0, one), zero);
+    simde__m256i i1 = simde_mm256_min_epi32(simde_mm256_add_epi32(i0, one), maxIdx);
+    simde__m256i i2 = simde_mm256_min_epi32(simde_mm256_add_epi32(i1, one), maxIdx);
+    simde__m256 ym1 = simde_mm256_i32gather_ps(lookupTable, im1, 4);
+    simde__m256 y0 = simde_mm256_i32gather_ps(lookupTable, i0, 4);
+    simde__m256 y1 = simde_mm256_i32gather_ps(lookupTable, i1, 4);
+    simde__m256 y2 = simde_mm256_i32gather_ps(lookupTable, i2, 4);
+    simde_mm256_storeu_ps(&out[n], cubic_interp_simd(ym1, y0, y1, y2, t));
+  }
+
+  for (; n < numSamples; n++) {
+    float x = fminf(1.0f, fmaxf(-1.0f, in[n]));
     float idx_float = (x + 1.0f) * half_scale;
     size_t i0 = (size_t)idx_float;
     float frac = idx_float - (float)i0;
@@ -165,6 +385,245 @@ void waveshaper_lookup_cubic(const float* in, float* out, const float* lookupTab
   }
 }
 
+void waveshaper_pad_table(float* padded, const float* lookupTable, size_t tableSize) {
+  if (tableSize == 0) {
+    return;
+  }
+  memcpy(&padded[WAVESHAPER_PAD_FRONT], lookupTable, tableSize * sizeof(float));
+  for (size_t i = 0; i < WAVESHAPER_PAD_FRONT; i++) {
+    padded[i] = lookupTable[0];
+  }
+  for (size_t i = 0; i < WAVESHAPER_PAD_BACK; i++) {
+    padded[WAVESHAPER_PAD_FRONT + tableSize + i] = lookupTable[tableSize - 1];
+  }
+}
+
+// paddedTable is the start of a waveshaper_pad_table buffer, so the four taps around any clamped
+// input are in bounds without edge checks; results match waveshaper_lookup_cubic
+void waveshaper_lookup_cubic_padded(const float* in, float* out, const float* paddedTable, size_t tableSize, size_t numSamples) {
+  if (tableSize < 4 || paddedTable == NULL) {
+    return;
+  }
+  const float half_scale = (float)(tableSize - 1) * 0.5f;
+  const simde__m256 scale = simde_mm256_set1_ps(half_scale);
+  // base points one entry before table[0], so tap k of sample i sits at base[i0 + k]
+  const float* base = paddedTable + WAVESHAPER_PAD_FRONT - 1;
+  size_t n = 0;
+
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 idx = waveshaper_index(simde_mm256_loadu_ps(&in[n]), scale);
+    simde__m256i i0 = simde_mm256_cvttps_epi32(idx);
+    simde__m256 t = simde_mm256_sub_ps(idx, simde_mm256_cvtepi32_ps(i0));
+    simde__m256 ym1 = simde_mm256_i32gather_ps(base, i0, 4);
+    simde__m256 y0 = simde_mm256_i32gather_ps(base + 1, i0, 4);
+    simde__m256 y1 = simde_mm256_i32gather_ps(base + 2, i0, 4);
+    simde__m256 y2 = simde_mm256_i32gather_ps(base + 3, i0, 4);
+    simde_mm256_storeu_ps(&out[n], cubic_interp_simd(ym1, y0, y1, y2, t));
+  }
+
+  for (; n < numSamples; n++) {
+    float idx = (fminf(1.0f, fmaxf(-1.0f, in[n])) + 1.0f) * half_scale;
+    size_t i0 = (size_t)idx;
+    out[n] = cubic_interp_scalar(base[i0], base[i0 + 1], base[i0 + 2], base[i0 + 3], idx - (float)i0);
+  }
+}
+
+// ADAA clippers. Everything below works on u = drive * x: divided differences are invariant
+// under that scaling, so the unit-drive antiderivatives serve every drive setting.
+
+#define ADAA_TOLERANCE 1.0e-5
+
+#ifndef M_LN2
+#define M_LN2 0.69314718055994530942
+#endif
+
+static inline double adaa_sign(double u) {
+  return (u < 0.0) ? -1.0 : 1.0;
+}
+
+static inline double adaa_hard_f0(double u) {
+  return (u > 1.0) ? 1.0 : (u < -1.0) ? -1.0 : u;
+}
+
+static inline double adaa_hard_f1(double u) {
+  double a = fabs(u);
+  return (a <= 1.0) ? 0.5 * u * u : a - 0.5;
+}
+
+static inline double adaa_hard_f2(double u) {
+  double a = fabs(u);
+  return (a <= 1.0) ? u * u * u / 6.0 : adaa_sign(u) * (0.5 * u * u - 0.5 * a + 1.0 / 6.0);
+}
+
+static inline double adaa_tanh_f0(double u) {
+  return tanh(u);
+}
+
+// log(cosh(u)) without overflowing cosh for large |u|
+static inline double adaa_tanh_f1(double u) {
+  double a = fabs(u);
+  return a + log1p(exp(-2.0 * a)) - M_LN2;
+}
+
+// Li2(-z) for z in (0, 1] via the Landen identity, which keeps the series argument <= 0.5
+static inline double adaa_dilog_neg(double z) {
+  double w = z / (1.0 + z);
+  double term = w;
+  double sum = 0.0;
+  for (int k = 1; k < 40 && term > 1e-17; k++) {
+    sum += term / (double)(k * k);
+    term *= w;
+  }
+  double l = log1p(z);
+  return -sum - 0.5 * l * l;
+}
+
+// integral of log(cosh(t)) from 0 to u; odd in u
+static inline double adaa_tanh_f2(double u) {
+  double a = fabs(u);
+  double g = 0.5 * a * a - a * M_LN2 + M_PI * M_PI / 24.0 + 0.5 * adaa_dilog_neg(exp(-2.0 * a));
+  return adaa_sign(u) * g;
+}
+
+static inline double adaa_arctan_f0(double u) {
+  return (2.0 / M_PI) * atan(u);
+}
+
+static inline double adaa_arctan_f1(double u) {
+  return (2.0 / M_PI) * (u * atan(u) - 0.5 * log1p(u * u));
+}
+
+static inline double adaa_arctan_f2(double u) {
+  double at = atan(u);
+  return (2.0 / M_PI) * (0.5 * u * u * at - 0.5 * at + 0.5 * u - 0.5 * u * log1p(u * u));
+}
+
+// the sigmoid curve 2 / (1 + e^-u) - 1 is tanh(u / 2)
+static inline double adaa_sigmoid_f0(double u) {
+  return tanh(0.5 * u);
+}
+
+static inline double adaa_sigmoid_f1(double u) {
+  return 2.0 * adaa_tanh_f1(0.5 * u);
+}
+
+static inline double adaa_sigmoid_f2(double u) {
+  return 4.0 * adaa_tanh_f2(0.5 * u);
+}
+
+static inline double adaa_cubic_f0(double u) {
+  if (fabs(u) > 1.0) return adaa_sign(u);
+  return 1.5 * (u - u * u * u / 3.0);
+}
+
+static inline double adaa_cubic_f1(double u) {
+  double a = fabs(u);
+  if (a > 1.0) return a - 0.375;
+  double u2 = u * u;
+  return 0.75 * u2 - 0.125 * u2 * u2;
+}
+
+static inline double adaa_cubic_f2(double u) {
+  double a = fabs(u);
+  if (a > 1.0) return adaa_sign(u) * (0.5 * u * u - 0.375 * a + 0.1);
+  double u3 = u * u * u;
+  return 0.25 * u3 - 0.025 * u3 * u * u;
+}
+
+typedef double (*ADAACurve)(double u);
+
+// always inlined with constant curve pointers below, so each ClipperType gets its own loop
+static inline void adaa_run_order1(ADAAClipper* c, const float* in, float* out, size_t numSamples, ADAACurve f0, ADAACurve f1) {
+  const double drive = c->drive;
+  double u1 = c->u1;
+  double F1Prev = c->F1Prev;
+  for (size_t n = 0; n < numSamples; n++) {
+    double u = drive * in[n];
+    double F1 = f1(u);
+    double du = u - u1;
+    out[n] = (float)((fabs(du) > ADAA_TOLERANCE) ? (F1 - F1Prev) / du : f0(0.5 * (u + u1)));
+    u1 = u;
+    F1Prev = F1;
+  }
+  c->u1 = u1;
+  c->F1Prev = F1Prev;
+}
+
+static inline void adaa_run_order2(ADAAClipper* c, const float* in, float* out, size_t numSamples, ADAACurve f0, ADAACurve f1, ADAACurve f2) {
+  const double drive = c->drive;
+  double u1 = c->u1;
+  double u2 = c->u2;
+  double F2Prev = c->F2Prev;
+  double DPrev = c->DPrev;
+  for (size_t n = 0; n < numSamples; n++) {
+    double u = drive * in[n];
+    double F2 = f2(u);
+    double du = u - u1;
+    double D = (fabs(du) > ADAA_TOLERANCE) ? (F2 - F2Prev) / du : f1(0.5 * (u + u1));
+    double span = u - u2;
+    double y;
+    if (fabs(span) > ADAA_TOLERANCE) {
+      y = 2.0 * (D - DPrev) / span;
+    } else {
+      // u and u2 coincide: expand around their midpoint instead of dividing by ~0
+      double mid = 0.5 * (u + u2);
+      double delta = mid - u1;
+      if (fabs(delta) > ADAA_TOLERANCE) {
+        y = (2.0 / delta) * (f1(mid) + (F2Prev - f2(mid)) / delta);
+      } else {
+        y = f0(0.5 * (mid + u1));
+      }
+    }
+    out[n] = (float)y;
+    u2 = u1;
+    u1 = u;
+    F2Prev = F2;
+    DPrev = D;
+  }
+  c->u1 = u1;
+  c->u2 = u2;
+  c->F2Prev = F2Prev;
+  c->DPrev = DPrev;
+}
+
+void adaa_clipper_init(ADAAClipper* c, ClipperType type, float drive, int order) {
+  c->type = type;
+  c->drive = drive;
+  c->order = (order >= 2) ? 2 : 1;
+  adaa_clipper_reset(c);
+}
+
+void adaa_clipper_reset(ADAAClipper* c) {
+  c->u1 = 0.0;
+  c->u2 = 0.0;
+  // every curve's antiderivatives are zero at u = 0, so silence is a consistent starting state
+  c->F1Prev = 0.0;
+  c->F2Prev = 0.0;
+  c->DPrev = 0.0;
+}
+
+void adaa_clipper_process(ADAAClipper* c, const float* in, float* out, size_t numSamples) {
+  if (c->order == 1) {
+    switch (c->type) {
+      case CLIP_HARD: adaa_run_order1(c, in, out, numSamples, adaa_hard_f0, adaa_hard_f1); break;
+      case CLIP_SOFT_TANH: adaa_run_order1(c, in, out, numSamples, adaa_tanh_f0, adaa_tanh_f1); break;
+      case CLIP_ARCTAN: adaa_run_order1(c, in, out, numSamples, adaa_arctan_f0, adaa_arctan_f1); break;
+      case CLIP_SIGMOID: adaa_run_order1(c, in, out, numSamples, adaa_sigmoid_f0, adaa_sigmoid_f1); break;
+      case CLIP_CUBIC_SOFT: adaa_run_order1(c, in, out, numSamples, adaa_cubic_f0, adaa_cubic_f1); break;
+      default: memmove(out, in, numSamples * sizeof(float)); break;
+    }
+    return;
+  }
+  switch (c->type) {
+    case CLIP_HARD: adaa_run_order2(c, in, out, numSamples, adaa_hard_f0, adaa_hard_f1, adaa_hard_f2); break;
+    case CLIP_SOFT_TANH: adaa_run_order2(c, in, out, numSamples, adaa_tanh_f0, adaa_tanh_f1, adaa_tanh_f2); break;
+    case CLIP_ARCTAN: adaa_run_order2(c, in, out, numSamples, adaa_arctan_f0, adaa_arctan_f1, adaa_arctan_f2); break;
+    case CLIP_SIGMOID: adaa_run_order2(c, in, out, numSamples, adaa_sigmoid_f0, adaa_sigmoid_f1, adaa_sigmoid_f2); break;
+    case CLIP_CUBIC_SOFT: adaa_run_order2(c, in, out, numSamples, adaa_cubic_f0, adaa_cubic_f1, adaa_cubic_f2); break;
+    default: memmove(out, in, numSamples * sizeof(float)); break;
+  }
+}
+
 void build_hann_window(float* w, size_t n) {
   for (size_t i = 0; i < n; i++) {
     w[i] = 0.5f * (1.0f - cosf((2.0f * M_PI * i)/(n - 1)));
@@ -263,7 +722,7 @@ void biquad_process_inplace(Biquad* bq, float* buffer, size_t numSamples) {
 }
 
 void biquad_set_params(Biquad* bq, BiquadType type, float freqHz, float Q, float gainDb, float sampleRate){
-  float A = powf(10.0f, gainDb / 40.0f);
+  float A = dsp_powf(10.0f, gainDb / 40.0f);
   float omega = hz_to_omega(freqHz, sampleRate);
   float sinOmega = sinf(omega);
   float cosOmega = cosf(omega);
@@ -365,64 +824,224 @@ void apply_gain_smoothing(float* currentGain, const float* targetGain, float* st
   *state = curr;
 }
 
-void lfo_init(LFO* lfo, LFOType type, float freqHz, float amp, float dc, float sampleRate) {
-  lfo->amp = amp;
-  lfo->dc = dc;
-  lfo->freq = freqHz;
-  lfo->phase = 0.0f;
-  lfo->phase_inc = freqHz/sampleRate;
-  lfo->sampleRate = sampleRate;
-  lfo->type = type;
+static inline simde__m256 lfo_wrap_simd(simde__m256 p) {
+  return simde_mm256_sub_ps(p, simde_mm256_floor_ps(p));
 }
 
-void lfo_process(LFO* lfo, float* out, size_t numSamples) {
+static inline float lfo_wrap(float p) {
+  return p - floorf(p);
+}
+
+static float lfo_eval_sine(LFO* lfo, float phase) {
+  (void)lfo;
+  return dsp_sinf(phase * 2.0f * M_PI);
+}
+
+static float lfo_eval_tri(LFO* lfo, float phase) {
+  (void)lfo;
+  return 1.0f - 4.0f * fabsf(phase - 0.5f);
+}
+
+static float lfo_eval_saw(LFO* lfo, float phase) {
+  (void)lfo;
+  return 2.0f * phase - 1.0f;
+}
+
+static float lfo_eval_square(LFO* lfo, float phase) {
+  (void)lfo;
+  return (phase < 0.5f) ? 1.0f : -1.0f;
+}
+
+static float lfo_eval_noise(LFO* lfo, float phase) {
+  (void)phase;
+  float v;
+  white_noise(&lfo->noise, &v, 1);
+  return v;
+}
+
+// Quadrature oscillator: each lane holds (sin, cos) of its own sample and all lanes rotate by
+// SIMD_LANES samples per step. It is reseeded from the phase every call, so rounding drift never
+// outlives a block and frequency changes take effect immediately.
+static void lfo_kernel_sine(LFO* lfo, float* out, size_t numSamples) {
   float phase = lfo->phase;
-  float phase_inc = lfo->phase_inc;
-  float amp = lfo->amp;
-  float dc = lfo->dc;
-  LFOType type = lfo->type;
+  float s[SIMD_LANES];
+  float c[SIMD_LANES];
+  s[0] = dsp_sinf(phase * 2.0f * M_PI);
+  c[0] = dsp_sinf((phase + 0.25f) * 2.0f * M_PI);
+  for (size_t k = 1; k < SIMD_LANES; k++) {
+    s[k] = s[k - 1] * lfo->rotCos + c[k - 1] * lfo->rotSin;
+    c[k] = c[k - 1] * lfo->rotCos - s[k - 1] * lfo->rotSin;
+  }
 
-  for (size_t i = 0; i < numSamples; i++)
-  {
-    float sample;
+  const simde__m256 amp = simde_mm256_set1_ps(lfo->amp);
+  const simde__m256 dc = simde_mm256_set1_ps(lfo->dc);
+  const simde__m256 rc = simde_mm256_set1_ps(lfo->laneCos);
+  const simde__m256 rs = simde_mm256_set1_ps(lfo->laneSin);
+  simde__m256 vs = simde_mm256_loadu_ps(s);
+  simde__m256 vc = simde_mm256_loadu_ps(c);
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde_mm256_storeu_ps(&out[n], simde_mm256_add_ps(simde_mm256_mul_ps(vs, amp), dc));
+    simde__m256 ns = simde_mm256_add_ps(simde_mm256_mul_ps(vs, rc), simde_mm256_mul_ps(vc, rs));
+    vc = simde_mm256_sub_ps(simde_mm256_mul_ps(vc, rc), simde_mm256_mul_ps(vs, rs));
+    vs = ns;
+  }
+  simde_mm256_storeu_ps(s, vs);
+  for (size_t k = 0; n < numSamples; n++, k++) {
+    out[n] = s[k] * lfo->amp + lfo->dc;
+  }
 
-    switch (type) {
-      case (LFO_SINE):
-        sample = sinf(phase * 2.0f * M_PI);
-        break;
-      case (LFO_TRI):
-        sample = 1.0f - 4.0f * fabsf(phase - 0.5f);
-        break;
-      case (LFO_SAW):
-        sample = 2.0f * phase - 1.0f;
-        break;
-      case (LFO_SQUARE):
-        sample = (phase < 0.5f) ? 1.0f : -1.0f;
-        break;
-      case (LFO_NOISE):
-        sample = ((float)rand() / (float)RAND_MAX) * 2.0f - 1.0f;
-        break;
-      default:
-        sample = 0.0f;
-        break;
-    }
+  lfo->phase = lfo_wrap(phase + (float)numSamples * lfo->phase_inc);
+}
+
+static inline simde__m256 lfo_shape_tri_simd(simde__m256 p) {
+  simde__m256 d = simde_mm256_andnot_ps(simde_mm256_set1_ps(-0.0f), simde_mm256_sub_ps(p, simde_mm256_set1_ps(0.5f)));
+  return simde_mm256_sub_ps(simde_mm256_set1_ps(1.0f), simde_mm256_mul_ps(simde_mm256_set1_ps(4.0f), d));
+}
+
+static inline simde__m256 lfo_shape_saw_simd(simde__m256 p) {
+  return simde_mm256_sub_ps(simde_mm256_add_ps(p, p), simde_mm256_set1_ps(1.0f));
+}
+
+static inline simde__m256 lfo_shape_square_simd(simde__m256 p) {
+  simde__m256 lower = simde_mm256_cmp_ps(p, simde_mm256_set1_ps(0.5f), SIMDE_CMP_LT_OQ);
+  return simde_mm256_blendv_ps(simde_mm256_set1_ps(-1.0f), simde_mm256_set1_ps(1.0f), lower);
+}
+
+typedef simde__m256 (*LFOShape)(simde__m256 phase);
+
+// The piecewise-linear shapes evaluate every lane's phase directly, so they carry no state beyond
+// the phase. Always inlined with constant shape pointers below, so each type gets its own loop.
+static inline void lfo_run_phase_kernel(LFO* lfo, float* out, size_t numSamples, LFOShape shape, float (*eval)(LFO*, float)) {
+  const float inc = lfo->phase_inc;
+  const simde__m256 amp = simde_mm256_set1_ps(lfo->amp);
+  const simde__m256 dc = simde_mm256_set1_ps(lfo->dc);
+  const simde__m256 ramp = simde_mm256_mul_ps(simde_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f), simde_mm256_set1_ps(inc));
+  float phase = lfo->phase;
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 p = lfo_wrap_simd(simde_mm256_add_ps(simde_mm256_set1_ps(phase), ramp));
+    simde_mm256_storeu_ps(&out[n], simde_mm256_add_ps(simde_mm256_mul_ps(shape(p), amp), dc));
+    phase = lfo_wrap(phase + (float)SIMD_LANES * inc);
+  }
+  for (; n < numSamples; n++) {
+    out[n] = eval(lfo, phase) * lfo->amp + lfo->dc;
+    phase = lfo_wrap(phase + inc);
+  }
+  lfo->phase = phase;
+}
+
+static void lfo_kernel_tri(LFO* lfo, float* out, size_t numSamples) {
+  lfo_run_phase_kernel(lfo, out, numSamples, lfo_shape_tri_simd, lfo_eval_tri);
+}
+
+static void lfo_kernel_saw(LFO* lfo, float* out, size_t numSamples) {
+  lfo_run_phase_kernel(lfo, out, numSamples, lfo_shape_saw_simd, lfo_eval_saw);
+}
 
-    out[i] = (sample * amp) + dc;
+static void lfo_kernel_square(LFO* lfo, float* out, size_t numSamples) {
+  lfo_run_phase_kernel(lfo, out, numSamples, lfo_shape_square_simd, lfo_eval_square);
+}
+
+static void lfo_kernel_noise(LFO* lfo, float* out, size_t numSamples) {
+  const float amp = lfo->amp;
+  const float dc = lfo->dc;
+  white_noise(&lfo->noise, out, numSamples);
+  for (size_t n = 0; n < numSamples; n++) {
+    out[n] = out[n] * amp + dc;
+  }
+}
 
-    // updating phase is unimportant in case of noise, if this conditional branching outweighs phase update, then phase update should happen anyway
-    if (type != LFO_NOISE) {
-      phase += phase_inc;
-      if (phase >= 1.0f) phase -= 1.0f;
+// lfo->phase is the phase of the point the current segment ramps towards
+static void lfo_kernel_control(LFO* lfo, float* out, size_t numSamples) {
+  const size_t interval = lfo->controlInterval;
+  const float amp = lfo->amp;
+  const float dc = lfo->dc;
+  float value = lfo->controlValue;
+  float step = lfo->controlStep;
+  size_t left = lfo->controlLeft;
+  size_t n = 0;
+  while (n < numSamples) {
+    if (left == 0) {
+      lfo->phase = lfo_wrap(lfo->phase + (float)interval * lfo->phase_inc);
+      step = (lfo->eval(lfo, lfo->phase) - value) / (float)interval;
+      left = interval;
+    }
+    size_t run = numSamples - n < left ? numSamples - n : left;
+    for (size_t k = 0; k < run; k++, n++) {
+      out[n] = value * amp + dc;
+      value += step;
     }
+    left -= run;
   }
+  lfo->controlValue = value;
+  lfo->controlStep = step;
+  lfo->controlLeft = left;
+}
 
-  lfo->phase = phase;
+static void lfo_select_kernel(LFO* lfo) {
+  if (lfo->controlInterval > 1) {
+    lfo->kernel = lfo_kernel_control;
+    lfo->controlValue = lfo->eval(lfo, lfo->phase);
+    lfo->controlStep = 0.0f;
+    lfo->controlLeft = 0;
+    return;
+  }
+  switch (lfo->type) {
+    case LFO_SINE: lfo->kernel = lfo_kernel_sine; break;
+    case LFO_TRI: lfo->kernel = lfo_kernel_tri; break;
+    case LFO_SAW: lfo->kernel = lfo_kernel_saw; break;
+    case LFO_SQUARE: lfo->kernel = lfo_kernel_square; break;
+    default: lfo->kernel = lfo_kernel_noise; break;
+  }
+}
+
+void lfo_init(LFO* lfo, LFOType type, float freqHz, float amp, float dc, float sampleRate) {
+  lfo->amp = amp;
+  lfo->dc = dc;
+  lfo->phase = 0.0f;
+  lfo->sampleRate = sampleRate;
+  lfo->controlInterval = 0;
+  noise_seed(&lfo->noise, 0);
+  lfo_set_freq(lfo, freqHz);
+  lfo_set_type(lfo, type);
+}
+
+void lfo_process(LFO* lfo, float* out, size_t numSamples) {
+  lfo->kernel(lfo, out, numSamples);
 }
 
 void lfo_set_freq(LFO* lfo, float freqHz) {
   lfo->freq = freqHz;
   float sampleRate = lfo->sampleRate;
   lfo->phase_inc = freqHz / sampleRate;
+  float w = 2.0f * M_PI * lfo->phase_inc;
+  lfo->rotCos = cosf(w);
+  lfo->rotSin = sinf(w);
+  lfo->laneCos = cosf(w * SIMD_LANES);
+  lfo->laneSin = sinf(w * SIMD_LANES);
+}
+
+void lfo_set_type(LFO* lfo, LFOType type) {
+  static float (*const evals[])(LFO*, float) = {
+    [LFO_SINE] = lfo_eval_sine,
+    [LFO_TRI] = lfo_eval_tri,
+    [LFO_SAW] = lfo_eval_saw,
+    [LFO_SQUARE] = lfo_eval_square,
+    [LFO_NOISE] = lfo_eval_noise,
+  };
+  lfo->type = type;
+  lfo->eval = ((unsigned)type <= LFO_NOISE) ? evals[type] : lfo_eval_noise;
+  lfo_select_kernel(lfo);
+}
+
+void lfo_set_control_rate(LFO* lfo, size_t interval) {
+  lfo->controlInterval = interval;
+  lfo_select_kernel(lfo);
+}
+
+void lfo_seed_noise(LFO* lfo, uint64_t seed) {
+  noise_seed(&lfo->noise, seed);
 }
 
 void env_init(EnvelopeDetector* ed, float attackMs, float releaseMs, float sampleRate, int isRMS) {
@@ -486,44 +1105,500 @@ void allpass1_process(AllPass1* ap, const float* in, float* out, size_t numSampl
   ap->y_prev = y_prev;
 }
 
-void delayline_init(DelayLine* dl, float* bufferMemory, size_t size, float sampleRate) {
-  dl->buffer = bufferMemory;
-  dl->size = size;
-
-  dl->writeIndex = 0;
-
-  dl->sampleRate = sampleRate;
+// Block-parallel kernels. The matrices are built by running the scalar kernels on unit impulses
+// and unit states, so the two paths cannot drift apart when a kernel changes.
 
-  if (dl->buffer != NULL && dl->size > 0) {
-    memset(dl->buffer, 0, dl->size * sizeof(float));
+static void iir_block_fill_toeplitz(IIRBlockMatrix* m, const float* impulse) {
+  for (size_t j = 0; j < SIMD_LANES; j++) {
+    for (size_t i = 0; i < SIMD_LANES; i++) {
+      m->h[j][i] = (i >= j) ? impulse[i - j] : 0.0f;
+    }
   }
 }
 
-void delayline_write(DelayLine* dl, const float* samples, size_t numSamples) {
-  float* buffer = dl->buffer;
-  const size_t size = dl->size;
-  size_t writeIndex = dl->writeIndex;
-  if (size == 0 || buffer == NULL) {
-    return;
-  }
-  for (size_t n = 0; n < numSamples; n++) {
-    buffer[writeIndex] = samples[n];
-    writeIndex = (writeIndex + 1) % size;
+static inline simde__m256 iir_block_response(const IIRBlockMatrix* m, const float* x, float s0, float s1) {
+  simde__m256 acc = simde_mm256_add_ps(
+    simde_mm256_mul_ps(simde_mm256_set1_ps(s0), simde_mm256_loadu_ps(m->c[0])),
+    simde_mm256_mul_ps(simde_mm256_set1_ps(s1), simde_mm256_loadu_ps(m->c[1])));
+  for (size_t j = 0; j < SIMD_LANES; j++) {
+    acc = simde_mm256_add_ps(acc, simde_mm256_mul_ps(simde_mm256_set1_ps(x[j]), simde_mm256_loadu_ps(m->h[j])));
   }
-  dl->writeIndex = writeIndex;
+  return acc;
 }
 
-void delayline_read_linear(DelayLine* dl, float* out, size_t numSamples, float delaySamples) {
-  const float* buffer = dl->buffer;
-  const size_t size = dl->size;
-  const size_t writeIndex = dl->writeIndex;
-  if (size == 0 || buffer == NULL || numSamples == 0) {
-    return;
+void biquad_block_prepare(IIRBlockMatrix* m, const Biquad* bq) {
+  float impulse[SIMD_LANES] = {1.0f};
+  float zeros[SIMD_LANES] = {0};
+  Biquad probe = *bq;
+
+  probe.z1 = 0.0f;
+  probe.z2 = 0.0f;
+  biquad_process(&probe, impulse, impulse, SIMD_LANES);
+  iir_block_fill_toeplitz(m, impulse);
+
+  probe.z1 = 1.0f;
+  probe.z2 = 0.0f;
+  biquad_process(&probe, zeros, m->c[0], SIMD_LANES);
+  probe.z1 = 0.0f;
+  probe.z2 = 1.0f;
+  biquad_process(&probe, zeros, m->c[1], SIMD_LANES);
+}
+
+void biquad_process_block(Biquad* bq, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples) {
+  const float b1 = bq->b1;
+  const float b2 = bq->b2;
+  const float a1 = bq->a1;
+  const float a2 = bq->a2;
+  float z1 = bq->z1;
+  float z2 = bq->z2;
+  size_t n = 0;
+
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    // read the block edge inputs first, in and out may alias
+    const size_t last = n + SIMD_LANES - 1;
+    const float xPrev = in[last - 1];
+    const float xLast = in[last];
+    simde_mm256_storeu_ps(&out[n], iir_block_response(m, &in[n], z1, z2));
+    // replay the last two TDF-II state updates from the block edges
+    float z2Prev = xPrev * b2 - out[last - 1] * a2;
+    z1 = xLast * b1 - out[last] * a1 + z2Prev;
+    z2 = xLast * b2 - out[last] * a2;
   }
-  delaySamples = clampf(delaySamples, 0.0f, (float)size - 1.0f);
-  float readFIndex = (float)writeIndex - delaySamples;
-  while (readFIndex < 0.0f) {
-    readFIndex += (float)size;
+
+  bq->z1 = z1;
+  bq->z2 = z2;
+  if (n < numSamples) {
+    biquad_process(bq, &in[n], &out[n], numSamples - n);
+  } else {
+    if (fabsf(bq->z1) < 1.0e-15f) bq->z1 = 0.0f;
+    if (fabsf(bq->z2) < 1.0e-15f) bq->z2 = 0.0f;
+  }
+}
+
+void onepole_block_prepare(IIRBlockMatrix* m, const OnePole* f) {
+  float impulse[SIMD_LANES] = {1.0f};
+  float zeros[SIMD_LANES] = {0};
+  OnePole probe = *f;
+
+  probe.z1 = 0.0f;
+  onepole_process(&probe, impulse, impulse, SIMD_LANES);
+  iir_block_fill_toeplitz(m, impulse);
+
+  probe.z1 = 1.0f;
+  onepole_process(&probe, zeros, m->c[0], SIMD_LANES);
+  memset(m->c[1], 0, sizeof(m->c[1]));
+}
+
+void onepole_process_block(OnePole* f, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples) {
+  const float b1 = f->b1;
+  const float a0 = f->a0;
+  float z1 = f->z1;
+  size_t n = 0;
+
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    const size_t last = n + SIMD_LANES - 1;
+    const float xLast = in[last];
+    simde_mm256_storeu_ps(&out[n], iir_block_response(m, &in[n], z1, 0.0f));
+    z1 = xLast * b1 - out[last] * a0;
+  }
+
+  f->z1 = z1;
+  if (n < numSamples) {
+    onepole_process(f, &in[n], &out[n], numSamples - n);
+  } else if (fabsf(f->z1) < 1.0e-15f) {
+    f->z1 = 0.0f;
+  }
+}
+
+void allpass1_block_prepare(IIRBlockMatrix* m, const AllPass1* ap) {
+  float impulse[SIMD_LANES] = {1.0f};
+  float zeros[SIMD_LANES] = {0};
+  AllPass1 probe = *ap;
+
+  probe.x_prev = 0.0f;
+  probe.y_prev = 0.0f;
+  allpass1_process(&probe, impulse, impulse, SIMD_LANES);
+  iir_block_fill_toeplitz(m, impulse);
+
+  probe.x_prev = 1.0f;
+  probe.y_prev = 0.0f;
+  allpass1_process(&probe, zeros, m->c[0], SIMD_LANES);
+  probe.x_prev = 0.0f;
+  probe.y_prev = 1.0f;
+  allpass1_process(&probe, zeros, m->c[1], SIMD_LANES);
+}
+
+void allpass1_process_block(AllPass1* ap, const IIRBlockMatrix* m, const float* in, float* out, size_t numSamples) {
+  float x_prev = ap->x_prev;
+  float y_prev = ap->y_prev;
+  size_t n = 0;
+
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    const float xLast = in[n + SIMD_LANES - 1];
+    simde_mm256_storeu_ps(&out[n], iir_block_response(m, &in[n], x_prev, y_prev));
+    x_prev = xLast;
+    y_prev = out[n + SIMD_LANES - 1];
+  }
+
+  ap->x_prev = x_prev;
+  ap->y_prev = y_prev;
+  if (n < numSamples) {
+    allpass1_process(ap, &in[n], &out[n], numSamples - n);
+  }
+}
+
+// Lane-parallel banks. Each group of SIMD_LANES channels keeps its state in registers for the
+// whole block; a trailing group narrower than SIMD_LANES goes through a zero-padded frame copy.
+
+static inline size_t bank_clamp_channels(size_t numChannels) {
+  if (numChannels > DSP_BANK_MAX_CHANNELS) {
+    log_message(LOG_LEVEL_WARN, "Bank supports at most %d channels, clamping %zu", DSP_BANK_MAX_CHANNELS, numChannels);
+    return DSP_BANK_MAX_CHANNELS;
+  }
+  return numChannels;
+}
+
+static inline simde__m256 bank_load_frame(const float* frame, size_t lanes) {
+  if (lanes == SIMD_LANES) {
+    return simde_mm256_loadu_ps(frame);
+  }
+  float tmp[SIMD_LANES] = {0};
+  memcpy(tmp, frame, lanes * sizeof(float));
+  return simde_mm256_loadu_ps(tmp);
+}
+
+static inline void bank_store_frame(float* frame, simde__m256 v, size_t lanes) {
+  if (lanes == SIMD_LANES) {
+    simde_mm256_storeu_ps(frame, v);
+    return;
+  }
+  float tmp[SIMD_LANES];
+  simde_mm256_storeu_ps(tmp, v);
+  memcpy(frame, tmp, lanes * sizeof(float));
+}
+
+// same 1e-15 flush the scalar kernels apply to their state at the end of a block
+static inline simde__m256 bank_flush_denormal(simde__m256 v) {
+  const simde__m256 absMask = simde_mm256_castsi256_ps(simde_mm256_set1_epi32(0x7fffffff));
+  simde__m256 keep = simde_mm256_cmp_ps(simde_mm256_and_ps(v, absMask), simde_mm256_set1_ps(1.0e-15f), SIMDE_CMP_GE_OQ);
+  return simde_mm256_and_ps(v, keep);
+}
+
+void biquad_bank_init(BiquadBank* bank, size_t numChannels) {
+  memset(bank, 0, sizeof(*bank));
+  bank->numChannels = bank_clamp_channels(numChannels);
+  for (size_t ch = 0; ch < DSP_BANK_MAX_CHANNELS; ch++) {
+    bank->b0[ch] = 1.0f;
+  }
+}
+
+void biquad_bank_set_channel(BiquadBank* bank, size_t channel, BiquadType type, float freqHz, float Q, float gainDb, float sampleRate) {
+  if (channel >= bank->numChannels) {
+    return;
+  }
+  Biquad bq;
+  biquad_set_params(&bq, type, freqHz, Q, gainDb, sampleRate);
+  bank->b0[channel] = bq.b0;
+  bank->b1[channel] = bq.b1;
+  bank->b2[channel] = bq.b2;
+  bank->a1[channel] = bq.a1;
+  bank->a2[channel] = bq.a2;
+}
+
+void biquad_bank_process(BiquadBank* bank, const float* in, float* out, size_t numFrames) {
+  const size_t numChannels = bank->numChannels;
+  for (size_t base = 0; base < numChannels; base += SIMD_LANES) {
+    const size_t lanes = (numChannels - base < SIMD_LANES) ? numChannels - base : SIMD_LANES;
+    const simde__m256 b0 = simde_mm256_loadu_ps(&bank->b0[base]);
+    const simde__m256 b1 = simde_mm256_loadu_ps(&bank->b1[base]);
+    const simde__m256 b2 = simde_mm256_loadu_ps(&bank->b2[base]);
+    const simde__m256 a1 = simde_mm256_loadu_ps(&bank->a1[base]);
+    const simde__m256 a2 = simde_mm256_loadu_ps(&bank->a2[base]);
+    simde__m256 z1 = simde_mm256_loadu_ps(&bank->z1[base]);
+    simde__m256 z2 = simde_mm256_loadu_ps(&bank->z2[base]);
+
+    for (size_t n = 0; n < numFrames; n++) {
+      simde__m256 x = bank_load_frame(&in[n * numChannels + base], lanes);
+      simde__m256 y = simde_mm256_add_ps(simde_mm256_mul_ps(x, b0), z1);
+      z1 = simde_mm256_add_ps(simde_mm256_sub_ps(simde_mm256_mul_ps(x, b1), simde_mm256_mul_ps(y, a1)), z2);
+      z2 = simde_mm256_sub_ps(simde_mm256_mul_ps(x, b2), simde_mm256_mul_ps(y, a2));
+      bank_store_frame(&out[n * numChannels + base], y, lanes);
+    }
+
+    simde_mm256_storeu_ps(&bank->z1[base], bank_flush_denormal(z1));
+    simde_mm256_storeu_ps(&bank->z2[base], bank_flush_denormal(z2));
+  }
+}
+
+void onepole_bank_init(OnePoleBank* bank, size_t numChannels) {
+  memset(bank, 0, sizeof(*bank));
+  bank->numChannels = bank_clamp_channels(numChannels);
+  for (size_t ch = 0; ch < DSP_BANK_MAX_CHANNELS; ch++) {
+    bank->b0[ch] = 1.0f;
+  }
+}
+
+void onepole_bank_set_channel(OnePoleBank* bank, size_t channel, float cutoffHz, float sampleRate, int isHighPass) {
+  if (channel >= bank->numChannels) {
+    return;
+  }
+  OnePole f;
+  onepole_init(&f, cutoffHz, sampleRate, isHighPass);
+  bank->a0[channel] = f.a0;
+  bank->b0[channel] = f.b0;
+  bank->b1[channel] = f.b1;
+}
+
+void onepole_bank_process(OnePoleBank* bank, const float* in, float* out, size_t numFrames) {
+  const size_t numChannels = bank->numChannels;
+  for (size_t base = 0; base < numChannels; base += SIMD_LANES) {
+    const size_t lanes = (numChannels - base < SIMD_LANES) ? numChannels - base : SIMD_LANES;
+    const simde__m256 a0 = simde_mm256_loadu_ps(&bank->a0[base]);
+    const simde__m256 b0 = simde_mm256_loadu_ps(&bank->b0[base]);
+    const simde__m256 b1 = simde_mm256_loadu_ps(&bank->b1[base]);
+    simde__m256 z1 = simde_mm256_loadu_ps(&bank->z1[base]);
+
+    for (size_t n = 0; n < numFrames; n++) {
+      simde__m256 x = bank_load_frame(&in[n * numChannels + base], lanes);
+      simde__m256 y = simde_mm256_add_ps(simde_mm256_mul_ps(x, b0), z1);
+      z1 = simde_mm256_sub_ps(simde_mm256_mul_ps(x, b1), simde_mm256_mul_ps(y, a0));
+      bank_store_frame(&out[n * numChannels + base], y, lanes);
+    }
+
+    simde_mm256_storeu_ps(&bank->z1[base], bank_flush_denormal(z1));
+  }
+}
+
+void allpass_bank_init(AllPassBank* bank, size_t numChannels) {
+  memset(bank, 0, sizeof(*bank));
+  bank->numChannels = bank_clamp_channels(numChannels);
+}
+
+void allpass_bank_set_channel(AllPassBank* bank, size_t channel, float feedback) {
+  if (channel >= bank->numChannels) {
+    return;
+  }
+  bank->g[channel] = clampf(feedback, -0.9999f, 0.9999f);
+}
+
+void allpass_bank_process(AllPassBank* bank, const float* in, float* out, size_t numFrames) {
+  const size_t numChannels = bank->numChannels;
+  for (size_t base = 0; base < numChannels; base += SIMD_LANES) {
+    const size_t lanes = (numChannels - base < SIMD_LANES) ? numChannels - base : SIMD_LANES;
+    const simde__m256 g = simde_mm256_loadu_ps(&bank->g[base]);
+    simde__m256 x_prev = simde_mm256_loadu_ps(&bank->x_prev[base]);
+    simde__m256 y_prev = simde_mm256_loadu_ps(&bank->y_prev[base]);
+
+    for (size_t n = 0; n < numFrames; n++) {
+      simde__m256 x = bank_load_frame(&in[n * numChannels + base], lanes);
+      simde__m256 y = simde_mm256_add_ps(simde_mm256_sub_ps(x_prev, simde_mm256_mul_ps(g, x)), simde_mm256_mul_ps(g, y_prev));
+      x_prev = x;
+      y_prev = y;
+      bank_store_frame(&out[n * numChannels + base], y, lanes);
+    }
+
+    simde_mm256_storeu_ps(&bank->x_prev[base], x_prev);
+    simde_mm256_storeu_ps(&bank->y_prev[base], y_prev);
+  }
+}
+
+void envelope_bank_init(EnvelopeBank* bank, size_t numChannels) {
+  memset(bank, 0, sizeof(*bank));
+  bank->numChannels = bank_clamp_channels(numChannels);
+}
+
+void envelope_bank_set_channel(EnvelopeBank* bank, size_t channel, float attackMs, float releaseMs, float sampleRate, int isRMS) {
+  if (channel >= bank->numChannels) {
+    return;
+  }
+  bank->attackCoeff[channel] = ms_to_coeff(attackMs, sampleRate);
+  bank->releaseCoeff[channel] = ms_to_coeff(releaseMs, sampleRate);
+  bank->isRMS[channel] = isRMS ? 1.0f : 0.0f;
+}
+
+void envelope_bank_process(EnvelopeBank* bank, const float* in, float* out, size_t numFrames) {
+  const size_t numChannels = bank->numChannels;
+  const simde__m256 absMask = simde_mm256_castsi256_ps(simde_mm256_set1_epi32(0x7fffffff));
+  const simde__m256 zero = simde_mm256_setzero_ps();
+  for (size_t base = 0; base < numChannels; base += SIMD_LANES) {
+    const size_t lanes = (numChannels - base < SIMD_LANES) ? numChannels - base : SIMD_LANES;
+    const simde__m256 attack = simde_mm256_loadu_ps(&bank->attackCoeff[base]);
+    const simde__m256 release = simde_mm256_loadu_ps(&bank->releaseCoeff[base]);
+    const simde__m256 rmsMask = simde_mm256_cmp_ps(simde_mm256_loadu_ps(&bank->isRMS[base]), zero, SIMDE_CMP_NEQ_OQ);
+    simde__m256 env = simde_mm256_loadu_ps(&bank->env[base]);
+
+    for (size_t n = 0; n < numFrames; n++) {
+      simde__m256 x = bank_load_frame(&in[n * numChannels + base], lanes);
+      simde__m256 target = simde_mm256_blendv_ps(simde_mm256_and_ps(x, absMask), simde_mm256_mul_ps(x, x), rmsMask);
+      simde__m256 diff = simde_mm256_sub_ps(target, env);
+      simde__m256 coeff = simde_mm256_blendv_ps(release, attack, simde_mm256_cmp_ps(diff, zero, SIMDE_CMP_GT_OQ));
+      env = simde_mm256_add_ps(env, simde_mm256_mul_ps(diff, coeff));
+      simde__m256 y = simde_mm256_blendv_ps(env, simde_mm256_sqrt_ps(env), rmsMask);
+      bank_store_frame(&out[n * numChannels + base], y, lanes);
+    }
+
+    simde_mm256_storeu_ps(&bank->env[base], env);
+  }
+}
+
+void delayline_init(DelayLine* dl, float* bufferMemory, size_t size, float sampleRate) {
+  dl->buffer = bufferMemory;
+  dl->size = size;
+
+  dl->writeIndex = 0;
+
+  dl->sampleRate = sampleRate;
+  dl->mask = 0;
+
+  if (dl->buffer != NULL && dl->size > 0) {
+    memset(dl->buffer, 0, dl->size * sizeof(float));
+  }
+}
+
+static size_t delayline_pow2_size(size_t size) {
+  size_t p = DELAYLINE_GUARD;
+  while (p < size) {
+    p <<= 1;
+  }
+  return p;
+}
+
+size_t delayline_pow2_buffer_size(size_t size) {
+  return delayline_pow2_size(size) + DELAYLINE_GUARD;
+}
+
+void delayline_init_pow2(DelayLine* dl, float* bufferMemory, size_t size, float sampleRate) {
+  delayline_init(dl, bufferMemory, delayline_pow2_buffer_size(size), sampleRate);
+  dl->size = delayline_pow2_size(size);
+  dl->mask = dl->size - 1;
+}
+
+static void delayline_write_pow2(DelayLine* dl, const float* samples, size_t numSamples) {
+  float* buffer = dl->buffer;
+  const size_t size = dl->size;
+  size_t writeIndex = dl->writeIndex;
+  // only the newest size samples survive a long write
+  if (numSamples > size) {
+    writeIndex = (writeIndex + numSamples - size) & dl->mask;
+    samples += numSamples - size;
+    numSamples = size;
+  }
+  size_t first = size - writeIndex;
+  if (first > numSamples) first = numSamples;
+  memcpy(buffer + writeIndex, samples, first * sizeof(float));
+  memcpy(buffer, samples + first, (numSamples - first) * sizeof(float));
+  memcpy(buffer + size, buffer, DELAYLINE_GUARD * sizeof(float));
+  dl->writeIndex = (writeIndex + numSamples) & dl->mask;
+}
+
+// Splits a constant delay into the integer index of the sample before the read point and the
+// fraction past it; writeIndex - delay == base + t, with base already wrapped to the buffer.
+static inline size_t delayline_pow2_split(const DelayLine* dl, float delaySamples, float* t) {
+  size_t whole = (size_t)delaySamples;
+  float frac = delaySamples - (float)whole;
+  if (frac > 0.0f) {
+    whole++;
+    *t = 1.0f - frac;
+  } else {
+    *t = 0.0f;
+  }
+  return (dl->writeIndex - whole) & dl->mask;
+}
+
+static void delayline_read_linear_pow2(const DelayLine* dl, float* out, size_t numSamples, float delaySamples) {
+  const float* buffer = dl->buffer;
+  const size_t size = dl->size;
+  float frac;
+  size_t idx = delayline_pow2_split(dl, clampf(delaySamples, 0.0f, (float)size - 1.0f), &frac);
+  const simde__m256 t = simde_mm256_set1_ps(frac);
+
+  // taps idx and idx + 1 stay contiguous up to the end of the buffer thanks to the guard
+  while (numSamples > 0) {
+    size_t run = size - idx;
+    if (run > numSamples) run = numSamples;
+    if (frac == 0.0f) {
+      memcpy(out, buffer + idx, run * sizeof(float));
+    } else {
+      const float* y = buffer + idx;
+      size_t n = 0;
+      for (; n + SIMD_LANES <= run; n += SIMD_LANES) {
+        simde__m256 y0 = simde_mm256_loadu_ps(&y[n]);
+        simde__m256 y1 = simde_mm256_loadu_ps(&y[n + 1]);
+        simde_mm256_storeu_ps(&out[n], simde_mm256_add_ps(y0, simde_mm256_mul_ps(t, simde_mm256_sub_ps(y1, y0))));
+      }
+      for (; n < run; n++) {
+        out[n] = lerp_scalar(y[n], y[n + 1], frac);
+      }
+    }
+    out += run;
+    numSamples -= run;
+    idx = 0;
+  }
+}
+
+static void delayline_read_cubic_pow2(const DelayLine* dl, float* out, size_t numSamples, float delaySamples) {
+  const float* buffer = dl->buffer;
+  const size_t size = dl->size;
+  float frac;
+  size_t idx = delayline_pow2_split(dl, clampf(delaySamples, 0.0f, (float)size - 3.0f), &frac);
+  const simde__m256 t = simde_mm256_set1_ps(frac);
+  // the kernel starts one sample before the read point
+  idx = (idx - 1) & dl->mask;
+
+  while (numSamples > 0) {
+    size_t run = size - idx;
+    if (run > numSamples) run = numSamples;
+    const float* y = buffer + idx;
+    size_t n = 0;
+    for (; n + SIMD_LANES <= run; n += SIMD_LANES) {
+      simde__m256 ym1 = simde_mm256_loadu_ps(&y[n]);
+      simde__m256 y0 = simde_mm256_loadu_ps(&y[n + 1]);
+      simde__m256 y1 = simde_mm256_loadu_ps(&y[n + 2]);
+      simde__m256 y2 = simde_mm256_loadu_ps(&y[n + 3]);
+      simde_mm256_storeu_ps(&out[n], cubic_interp_simd(ym1, y0, y1, y2, t));
+    }
+    for (; n < run; n++) {
+      out[n] = cubic_interp_scalar(y[n], y[n + 1], y[n + 2], y[n + 3], frac);
+    }
+    out += run;
+    numSamples -= run;
+    idx = 0;
+  }
+}
+
+void delayline_write(DelayLine* dl, const float* samples, size_t numSamples) {
+  float* buffer = dl->buffer;
+  const size_t size = dl->size;
+  size_t writeIndex = dl->writeIndex;
+  if (size == 0 || buffer == NULL) {
+    return;
+  }
+  if (dl->mask) {
+    delayline_write_pow2(dl, samples, numSamples);
+    return;
+  }
+  for (size_t n = 0; n < numSamples; n++) {
+    buffer[writeIndex] = samples[n];
+    writeIndex = (writeIndex + 1) % size;
+  }
+  dl->writeIndex = writeIndex;
+}
+
+void delayline_read_linear(DelayLine* dl, float* out, size_t numSamples, float delaySamples) {
+  const float* buffer = dl->buffer;
+  const size_t size = dl->size;
+  const size_t writeIndex = dl->writeIndex;
+  if (size == 0 || buffer == NULL || numSamples == 0) {
+    return;
+  }
+  if (dl->mask) {
+    delayline_read_linear_pow2(dl, out, numSamples, delaySamples);
+    return;
+  }
+  delaySamples = clampf(delaySamples, 0.0f, (float)size - 1.0f);
+  float readFIndex = (float)writeIndex - delaySamples;
+  while (readFIndex < 0.0f) {
+    readFIndex += (float)size;
   }
 
   for (size_t n = 0; n < numSamples; n++) {
@@ -546,6 +1621,10 @@ void delayline_read_cubic(DelayLine* dl, float* out, size_t numSamples, float de
   const size_t size = dl->size;
   const float fsize = (float)size;
   if (size == 0 || buffer == NULL || numSamples == 0) return;
+  if (dl->mask) {
+    delayline_read_cubic_pow2(dl, out, numSamples, delaySamples);
+    return;
+  }
   delaySamples = clampf(delaySamples, 0.0f, fsize - 3.0f);
   float readFIndex = (float)dl->writeIndex - delaySamples;
   while (readFIndex < 0.0f) {
@@ -572,6 +1651,123 @@ void delayline_read_cubic(DelayLine* dl, float* out, size_t numSamples, float de
   }
 }
 
+// Lagrange weights for taps at -1, 0, 1, 2 around the read point
+static inline void lagrange3_weights_simd(simde__m256 t, simde__m256* hm1, simde__m256* h0, simde__m256* h1, simde__m256* h2) {
+  const simde__m256 one = simde_mm256_set1_ps(1.0f);
+  simde__m256 tp1 = simde_mm256_add_ps(t, one);
+  simde__m256 tm1 = simde_mm256_sub_ps(t, one);
+  simde__m256 tm2 = simde_mm256_sub_ps(t, simde_mm256_set1_ps(2.0f));
+  simde__m256 ttm1 = simde_mm256_mul_ps(t, tm1);
+  simde__m256 tp1tm2 = simde_mm256_mul_ps(tp1, tm2);
+  *hm1 = simde_mm256_mul_ps(simde_mm256_set1_ps(-1.0f / 6.0f), simde_mm256_mul_ps(ttm1, tm2));
+  *h0 = simde_mm256_mul_ps(simde_mm256_set1_ps(0.5f), simde_mm256_mul_ps(tp1tm2, tm1));
+  *h1 = simde_mm256_mul_ps(simde_mm256_set1_ps(-0.5f), simde_mm256_mul_ps(tp1tm2, t));
+  *h2 = simde_mm256_mul_ps(simde_mm256_set1_ps(1.0f / 6.0f), simde_mm256_mul_ps(ttm1, tp1));
+}
+
+static inline float lagrange3_scalar(float ym1, float y0, float y1, float y2, float t) {
+  float ttm1 = t * (t - 1.0f);
+  float tp1tm2 = (t + 1.0f) * (t - 2.0f);
+  return (-1.0f / 6.0f) * ttm1 * (t - 2.0f) * ym1 + 0.5f * tp1tm2 * (t - 1.0f) * y0 - 0.5f * tp1tm2 * t * y1 + (1.0f / 6.0f) * ttm1 * (t + 1.0f) * y2;
+}
+
+// Thiran is recursive in time, so it stays scalar; it picks the integer part so the fractional
+// delay sits in [0.5, 1.5), where the first order allpass is stable and well behaved
+static void delayline_read_thiran(const DelayLine* dl, float* out, const float* delaySamples, size_t numSamples, float* allpassState) {
+  const float* buffer = dl->buffer;
+  const size_t mask = dl->mask;
+  const float maxDelay = (float)dl->size - 2.0f;
+  const size_t newest = dl->writeIndex - numSamples;
+  float yPrev = allpassState ? *allpassState : 0.0f;
+
+  for (size_t n = 0; n < numSamples; n++) {
+    float d = clampf(delaySamples[n], 0.5f, maxDelay);
+    size_t whole = (size_t)(d - 0.5f);
+    float frac = d - (float)whole;
+    float eta = (1.0f - frac) / (1.0f + frac);
+    size_t i = (newest + n - whole) & mask;
+    float x0 = buffer[i];
+    float x1 = buffer[(i - 1) & mask];
+    yPrev = eta * (x0 - yPrev) + x1;
+    out[n] = yPrev;
+  }
+  if (allpassState) {
+    *allpassState = yPrev;
+  }
+}
+
+void delayline_read_modulated(const DelayLine* dl, float* out, const float* delaySamples, size_t numSamples, DelayInterpType interp, float* allpassState) {
+  if (dl->buffer == NULL || numSamples == 0) {
+    return;
+  }
+  if (dl->mask == 0) {
+    log_message(LOG_LEVEL_ERROR, "delayline_read_modulated needs a delay line from delayline_init_pow2");
+    return;
+  }
+  if (interp == DELAY_INTERP_THIRAN) {
+    delayline_read_thiran(dl, out, delaySamples, numSamples, allpassState);
+    return;
+  }
+
+  const float* buffer = dl->buffer;
+  const int32_t mask = (int32_t)dl->mask;
+  // the position of out[n] is newest + n - delaySamples[n]; only the offset n - delay is done in
+  // float, so precision does not depend on where the write index happens to be
+  const int32_t newest = (int32_t)((dl->writeIndex - numSamples) & dl->mask);
+  const int taps = interp == DELAY_INTERP_LINEAR ? 2 : 4;
+  const float minDelay = taps == 2 ? 0.0f : 1.0f;
+  const float maxDelay = (float)dl->size - 2.0f;
+  // 4-tap kernels start one sample before the read point; the guard covers the rest
+  const int32_t first = taps == 2 ? 0 : 1;
+
+  const simde__m256 vMin = simde_mm256_set1_ps(minDelay);
+  const simde__m256 vMax = simde_mm256_set1_ps(maxDelay);
+  const simde__m256 ramp = simde_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  const simde__m256i vMask = simde_mm256_set1_epi32(mask);
+  const simde__m256i vBase = simde_mm256_set1_epi32(newest - first);
+  size_t n = 0;
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 d = simde_mm256_min_ps(vMax, simde_mm256_max_ps(vMin, simde_mm256_loadu_ps(&delaySamples[n])));
+    simde__m256 pos = simde_mm256_sub_ps(simde_mm256_add_ps(ramp, simde_mm256_set1_ps((float)n)), d);
+    simde__m256 whole = simde_mm256_floor_ps(pos);
+    simde__m256 t = simde_mm256_sub_ps(pos, whole);
+    simde__m256i idx = simde_mm256_and_si256(simde_mm256_add_epi32(vBase, simde_mm256_cvtps_epi32(whole)), vMask);
+    simde__m256 y;
+    if (taps == 2) {
+      simde__m256 y0 = simde_mm256_i32gather_ps(buffer, idx, 4);
+      simde__m256 y1 = simde_mm256_i32gather_ps(buffer + 1, idx, 4);
+      y = simde_mm256_add_ps(y0, simde_mm256_mul_ps(t, simde_mm256_sub_ps(y1, y0)));
+    } else {
+      simde__m256 ym1 = simde_mm256_i32gather_ps(buffer, idx, 4);
+      simde__m256 y0 = simde_mm256_i32gather_ps(buffer + 1, idx, 4);
+      simde__m256 y1 = simde_mm256_i32gather_ps(buffer + 2, idx, 4);
+      simde__m256 y2 = simde_mm256_i32gather_ps(buffer + 3, idx, 4);
+      if (interp == DELAY_INTERP_CUBIC) {
+        y = cubic_interp_simd(ym1, y0, y1, y2, t);
+      } else {
+        simde__m256 hm1, h0, h1, h2;
+        lagrange3_weights_simd(t, &hm1, &h0, &h1, &h2);
+        y = simde_mm256_add_ps(simde_mm256_add_ps(simde_mm256_mul_ps(hm1, ym1), simde_mm256_mul_ps(h0, y0)),
+                               simde_mm256_add_ps(simde_mm256_mul_ps(h1, y1), simde_mm256_mul_ps(h2, y2)));
+      }
+    }
+    simde_mm256_storeu_ps(&out[n], y);
+  }
+
+  for (; n < numSamples; n++) {
+    float pos = (float)n - clampf(delaySamples[n], minDelay, maxDelay);
+    float whole = floorf(pos);
+    float t = pos - whole;
+    const float* y = buffer + ((newest - first + (int32_t)whole) & mask);
+    if (interp == DELAY_INTERP_LINEAR) {
+      out[n] = lerp_scalar(y[0], y[1], t);
+    } else if (interp == DELAY_INTERP_CUBIC) {
+      out[n] = cubic_interp_scalar(y[0], y[1], y[2], y[3], t);
+    } else {
+      out[n] = lagrange3_scalar(y[0], y[1], y[2], y[3], t);
+    }
+  }
+}
 
 // Idk if these are SIMD friendly, I didn't pay attention too much, check again, they're probably not:
 
@@ -671,30 +1867,2084 @@ void downsample2x_fir(const float* in, float* out, size_t n, const float* fir, R
   }
 }
 
-void denormal_fix_inplace(float* buffer, size_t n) {
-  const float DENORMAL_THRESHOLD = 1.0e-24f;
-  for (size_t i = 0; i < n; i++) {
-    buffer[i] *= (fabsf(buffer[i]) >= DENORMAL_THRESHOLD);
+static inline float simd_hsum(simde__m256 v) {
+  simde__m128 lo = simde_mm256_castps256_ps128(v);
+  simde__m128 hi = simde_mm256_extractf128_ps(v, 1);
+  lo = simde_mm_add_ps(lo, hi);
+  lo = simde_mm_add_ps(lo, simde_mm_movehl_ps(lo, lo));
+  lo = simde_mm_add_ss(lo, simde_mm_shuffle_ps(lo, lo, 0x1));
+  return simde_mm_cvtss_f32(lo);
+}
+
+static inline float simd_hmax(simde__m256 v) {
+  simde__m128 lo = simde_mm256_castps256_ps128(v);
+  simde__m128 hi = simde_mm256_extractf128_ps(v, 1);
+  lo = simde_mm_max_ps(lo, hi);
+  lo = simde_mm_max_ps(lo, simde_mm_movehl_ps(lo, lo));
+  lo = simde_mm_max_ss(lo, simde_mm_shuffle_ps(lo, lo, 0x1));
+  return simde_mm_cvtss_f32(lo);
+}
+
+// n must be a multiple of SIMD_LANES
+static inline float simd_dot(const float* a, const float* b, size_t n) {
+  simde__m256 acc0 = simde_mm256_setzero_ps();
+  simde__m256 acc1 = simde_mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 2 * SIMD_LANES <= n; i += 2 * SIMD_LANES) {
+    acc0 = simde_mm256_add_ps(acc0, simde_mm256_mul_ps(simde_mm256_loadu_ps(&a[i]), simde_mm256_loadu_ps(&b[i])));
+    acc1 = simde_mm256_add_ps(acc1, simde_mm256_mul_ps(simde_mm256_loadu_ps(&a[i + SIMD_LANES]), simde_mm256_loadu_ps(&b[i + SIMD_LANES])));
+  }
+  if (i < n) {
+    acc0 = simde_mm256_add_ps(acc0, simde_mm256_mul_ps(simde_mm256_loadu_ps(&a[i]), simde_mm256_loadu_ps(&b[i])));
   }
+  return simd_hsum(simde_mm256_add_ps(acc0, acc1));
 }
 
-float blackman_window_scalar(float w, size_t n) {
-  float N = (float)n;
-  const float alpha = 0.16f;
-  const float a0 = (1.0f - alpha) / 2.0f;
-  const float a1 = 0.5f;
-  const float a2 = alpha / 2.0f;
-  return a0 - a1 * cosf((2.0f * M_PI * w) / (N - 1)) + a2 * cosf((4.0f * M_PI * w) / (N - 1));
+// taps receives the numTaps non-zero phase of a (4 * numTaps / 2 - 1)-tap Blackman half-band,
+// reversed (oldest sample first) and scaled to sum to 1, i.e. the gain an upsampler needs
+void design_halfband_fir(float* taps, size_t numTaps) {
+  if (taps == NULL || numTaps == 0) return;
+  const size_t fullLen = 2 * numTaps - 1;
+  const float center = (float)(fullLen - 1) * 0.5f;
+  float sum = 0.0f;
+  for (size_t j = 0; j < numTaps; j++) {
+    float n = (float)(2 * j) - center;
+    float sinc = sinf(0.5f * M_PI * n) / (M_PI * n);
+    float v = sinc * blackman_window_scalar((float)(2 * j), fullLen);
+    taps[numTaps - 1 - j] = v;
+    sum += v;
+  }
+  if (fabsf(sum) > 1e-9f) {
+    for (size_t j = 0; j < numTaps; j++) {
+      taps[j] /= sum;
+    }
+  }
 }
 
-void build_blackman_window(float* w, size_t n) {
-  for (size_t i = 0; i < n; i++)
-  {
-    w[i] = blackman_window_scalar((float)i, n);
+void halfband_init(HalfbandResampler* hb, size_t numTaps) {
+  numTaps = (numTaps + SIMD_LANES - 1) / SIMD_LANES * SIMD_LANES;
+  if (numTaps < SIMD_LANES) numTaps = SIMD_LANES;
+  if (numTaps > HALFBAND_MAX_TAPS) {
+    log_message(LOG_LEVEL_WARN, "Half-band resampler supports at most %d taps, clamping %zu", HALFBAND_MAX_TAPS, numTaps);
+    numTaps = HALFBAND_MAX_TAPS;
+  }
+  hb->numTaps = numTaps;
+  design_halfband_fir(hb->taps, numTaps);
+  halfband_reset(hb);
+}
+
+void halfband_reset(HalfbandResampler* hb) {
+  memset(hb->ring, 0, sizeof(hb->ring));
+  memset(hb->ringCenter, 0, sizeof(hb->ringCenter));
+  hb->pos = 0;
+}
+
+// The ring holds numTaps + SIMD_LANES samples, mirrored: sample q sits at q and q + capacity, so
+// from the next write position p the newest `capacity` samples are ring[p .. p + capacity - 1],
+// oldest first. That is enough history to compute SIMD_LANES consecutive outputs as one vector:
+// out[k] = sum_t taps[t] * window[k + t], one broadcast multiply-add per tap and no horizontal sums.
+
+static inline void halfband_push(float* ring, size_t capacity, size_t* pos, float x) {
+  ring[*pos] = x;
+  ring[*pos + capacity] = x;
+  *pos = (*pos + 1 == capacity) ? 0 : *pos + 1;
+}
+
+static inline simde__m256 halfband_block_dot(const float* window, const float* taps, size_t numTaps) {
+  simde__m256 acc0 = simde_mm256_setzero_ps();
+  simde__m256 acc1 = simde_mm256_setzero_ps();
+  for (size_t t = 0; t < numTaps; t += 2) {
+    acc0 = simde_mm256_add_ps(acc0, simde_mm256_mul_ps(simde_mm256_set1_ps(taps[t]), simde_mm256_loadu_ps(&window[t])));
+    acc1 = simde_mm256_add_ps(acc1, simde_mm256_mul_ps(simde_mm256_set1_ps(taps[t + 1]), simde_mm256_loadu_ps(&window[t + 1])));
+  }
+  return simde_mm256_add_ps(acc0, acc1);
+}
+
+void halfband_upsample2x(HalfbandResampler* hb, const float* in, float* out, size_t n) {
+  const size_t numTaps = hb->numTaps;
+  const size_t capacity = numTaps + SIMD_LANES;
+  const size_t centerOffset = numTaps / 2;
+  float* ring = hb->ring;
+  size_t pos = hb->pos;
+  size_t i = 0;
+
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    for (size_t k = 0; k < SIMD_LANES; k++) {
+      halfband_push(ring, capacity, &pos, in[i + k]);
+    }
+    // window[k] .. window[k + numTaps - 1] is the history of output k of this block
+    const float* window = &ring[pos + 1];
+    float even[SIMD_LANES];
+    simde_mm256_storeu_ps(even, halfband_block_dot(window, hb->taps, numTaps));
+    for (size_t k = 0; k < SIMD_LANES; k++) {
+      out[2 * (i + k)] = even[k];
+      out[2 * (i + k) + 1] = window[k + centerOffset];
+    }
+  }
+
+  for (; i < n; i++) {
+    halfband_push(ring, capacity, &pos, in[i]);
+    const float* window = &ring[pos + SIMD_LANES];
+    out[2 * i] = simd_dot(window, hb->taps, numTaps);
+    out[2 * i + 1] = window[centerOffset];
+  }
+  hb->pos = pos;
+}
+
+// keeps the even (dense) phase so output lands on the same grid the upsampler writes, which
+// makes an up/down round trip an integer number of base-rate samples
+void halfband_downsample2x(HalfbandResampler* hb, const float* in, float* out, size_t n) {
+  const size_t numTaps = hb->numTaps;
+  const size_t capacity = numTaps + SIMD_LANES;
+  const size_t centerOffset = numTaps / 2 - 1;
+  float* ring = hb->ring;
+  float* ringCenter = hb->ringCenter;
+  size_t pos = hb->pos;
+  size_t i = 0;
+
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    for (size_t k = 0; k < SIMD_LANES; k++) {
+      size_t p = pos;
+      halfband_push(ring, capacity, &p, in[2 * (i + k)]);
+      halfband_push(ringCenter, capacity, &pos, in[2 * (i + k) + 1]);
+    }
+    const simde__m256 dense = halfband_block_dot(&ring[pos + 1], hb->taps, numTaps);
+    const simde__m256 center = simde_mm256_loadu_ps(&ringCenter[pos + 1 + centerOffset]);
+    simde_mm256_storeu_ps(&out[i], simde_mm256_mul_ps(simde_mm256_set1_ps(0.5f), simde_mm256_add_ps(dense, center)));
+  }
+
+  for (; i < n; i++) {
+    size_t p = pos;
+    halfband_push(ring, capacity, &p, in[2 * i]);
+    halfband_push(ringCenter, capacity, &pos, in[2 * i + 1]);
+    out[i] = 0.5f * (simd_dot(&ring[pos + SIMD_LANES], hb->taps, numTaps) + ringCenter[pos + SIMD_LANES + centerOffset]);
+  }
+  hb->pos = pos;
+}
+
+// group delay in samples at the higher of the two rates
+size_t halfband_latency(const HalfbandResampler* hb) {
+  return hb->numTaps - 1;
+}
+
+int oversampler_init(Oversampler* os, size_t factor, size_t numTaps) {
+  size_t stages;
+  switch (factor) {
+    case 2: stages = 1; break;
+    case 4: stages = 2; break;
+    case 8: stages = 3; break;
+    default:
+      log_message(LOG_LEVEL_ERROR, "Unsupported oversampling factor %zu, expected 2, 4 or 8", factor);
+      return -1;
+  }
+  os->numStages = stages;
+  os->factor = factor;
+  for (size_t s = 0; s < stages; s++) {
+    size_t taps = numTaps >> s;
+    halfband_init(&os->up[s], taps);
+    halfband_init(&os->down[s], taps);
+  }
+  return 0;
+}
+
+void oversampler_reset(Oversampler* os) {
+  for (size_t s = 0; s < os->numStages; s++) {
+    halfband_reset(&os->up[s]);
+    halfband_reset(&os->down[s]);
+  }
+}
+
+// intermediate stages ping through scratch: stage s output of a chunk of c frames is 2^(s+1) * c
+// long, and the stage 1..numStages-1 outputs are packed back to back in scratch
+void oversampler_upsample(Oversampler* os, const float* in, float* out, size_t n) {
+  const size_t stages = os->numStages;
+  for (size_t done = 0; done < n; done += OVERSAMPLER_CHUNK) {
+    const size_t chunk = (n - done < OVERSAMPLER_CHUNK) ? n - done : OVERSAMPLER_CHUNK;
+    const float* src = &in[done];
+    float* scratch = os->scratch;
+    size_t len = chunk;
+    for (size_t s = 0; s < stages; s++) {
+      float* dst = (s + 1 == stages) ? &out[done * os->factor] : scratch;
+      halfband_upsample2x(&os->up[s], src, dst, len);
+      src = dst;
+      scratch += 2 * len;
+      len *= 2;
+    }
   }
 }
 
-void build_triode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax);
-void build_pentode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax);
-void build_tube_table_from_koren(float* table, size_t tableSize, TubeType type, const TubeParams* params, float vMin, float vMax);
-void normalize_ir(float* ir, size_t n, float targetRMS);
\ No newline at end of file
+void oversampler_downsample(Oversampler* os, const float* in, float* out, size_t n) {
+  const size_t stages = os->numStages;
+  for (size_t done = 0; done < n; done += OVERSAMPLER_CHUNK) {
+    const size_t chunk = (n - done < OVERSAMPLER_CHUNK) ? n - done : OVERSAMPLER_CHUNK;
+    const float* src = &in[done * os->factor];
+    float* scratch = os->scratch;
+    size_t len = chunk * os->factor;
+    for (size_t s = stages; s-- > 0;) {
+      float* dst = (s == 0) ? &out[done] : scratch;
+      halfband_downsample2x(&os->down[s], src, dst, len / 2);
+      src = dst;
+      scratch += len / 2;
+      len /= 2;
+    }
+  }
+}
+
+// round-trip (up then down) latency in base-rate samples, rounded to nearest; only the 2x
+// cascade is an exact integer, inner stages of 4x/8x add a fractional part
+size_t oversampler_latency(const Oversampler* os) {
+  float latency = 0.0f;
+  float rate = 2.0f;
+  for (size_t s = 0; s < os->numStages; s++) {
+    latency += 2.0f * (float)halfband_latency(&os->up[s]) / rate;
+    rate *= 2.0f;
+  }
+  return (size_t)(latency + 0.5f);
+}
+
+// Elliptic half-band design after Valenzuela & Constantinides, as used by most polyphase IIR
+// resamplers. transitionBw is relative to the low sample rate (0.5 = Nyquist), e.g. 0.05.
+static double iir_halfband_acc_num(double q, int order, int c) {
+  double acc = 0.0;
+  double term;
+  int sign = 1;
+  int i = 0;
+  do {
+    term = pow(q, (double)(i * (i + 1))) * sin((double)((i * 2 + 1) * c) * M_PI / (double)order) * sign;
+    acc += term;
+    sign = -sign;
+    i++;
+  } while (fabs(term) > 1e-100 && i < 64);
+  return acc;
+}
+
+static double iir_halfband_acc_den(double q, int order, int c) {
+  double acc = 0.0;
+  double term;
+  int sign = -1;
+  int i = 1;
+  do {
+    term = pow(q, (double)(i * i)) * cos((double)(i * 2 * c) * M_PI / (double)order) * sign;
+    acc += term;
+    sign = -sign;
+    i++;
+  } while (fabs(term) > 1e-100 && i < 64);
+  return acc;
+}
+
+void design_iir_halfband(float* coeffs, size_t numCoeffs, float transitionBw) {
+  if (coeffs == NULL || numCoeffs == 0) return;
+  transitionBw = clampf(transitionBw, 1e-4f, 0.4999f);
+  const double k = pow(tan((1.0 - 2.0 * (double)transitionBw) * M_PI / 4.0), 2.0);
+  const double kksqrt = pow(1.0 - k * k, 0.25);
+  const double e = 0.5 * (1.0 - kksqrt) / (1.0 + kksqrt);
+  const double e4 = e * e * e * e;
+  const double q = e * (1.0 + e4 * (2.0 + e4 * (15.0 + 150.0 * e4)));
+  const int order = (int)numCoeffs * 2 + 1;
+
+  for (size_t i = 0; i < numCoeffs; i++) {
+    const int c = (int)i + 1;
+    double num = iir_halfband_acc_num(q, order, c) * pow(q, 0.25);
+    double den = iir_halfband_acc_den(q, order, c) + 0.5;
+    double ww = num / den;
+    double wwsq = ww * ww;
+    double x = sqrt((1.0 - wwsq * k) * (1.0 - wwsq / k)) / (1.0 + wwsq);
+    coeffs[i] = (float)((1.0 - x) / (1.0 + x));
+  }
+}
+
+void iir_halfband_init(IIRHalfband* hb, size_t numCoeffs, float transitionBw) {
+  float coeffs[IIR_HALFBAND_MAX_COEFFS];
+  numCoeffs = (numCoeffs + 1) & ~(size_t)1;
+  if (numCoeffs < 2) numCoeffs = 2;
+  if (numCoeffs > IIR_HALFBAND_MAX_COEFFS) {
+    log_message(LOG_LEVEL_WARN, "IIR half-band supports at most %d coefficients, clamping %zu", IIR_HALFBAND_MAX_COEFFS, numCoeffs);
+    numCoeffs = IIR_HALFBAND_MAX_COEFFS;
+  }
+  design_iir_halfband(coeffs, numCoeffs, transitionBw);
+  hb->numSections = numCoeffs / 2;
+  for (size_t s = 0; s < hb->numSections; s++) {
+    allpass1_init(&hb->sections[0][s], -coeffs[2 * s]);
+    allpass1_init(&hb->sections[1][s], -coeffs[2 * s + 1]);
+  }
+}
+
+void iir_halfband_reset(IIRHalfband* hb) {
+  for (size_t s = 0; s < hb->numSections; s++) {
+    for (size_t b = 0; b < 2; b++) {
+      hb->sections[b][s].x_prev = 0.0f;
+      hb->sections[b][s].y_prev = 0.0f;
+    }
+  }
+}
+
+// Branch 0 in lane 0, branch 1 in lane 1. The AllPass1 state is unpacked into registers for the
+// whole block and written back at the end, so the AoS layout costs nothing per sample.
+typedef struct {
+  simde__m128 g[IIR_HALFBAND_MAX_COEFFS / 2];
+  simde__m128 x_prev[IIR_HALFBAND_MAX_COEFFS / 2];
+  simde__m128 y_prev[IIR_HALFBAND_MAX_COEFFS / 2];
+} IIRHalfbandLanes;
+
+static inline void iir_halfband_load(const IIRHalfband* hb, IIRHalfbandLanes* l) {
+  for (size_t s = 0; s < hb->numSections; s++) {
+    const AllPass1* b0 = &hb->sections[0][s];
+    const AllPass1* b1 = &hb->sections[1][s];
+    l->g[s] = simde_mm_set_ps(0.0f, 0.0f, b1->g, b0->g);
+    l->x_prev[s] = simde_mm_set_ps(0.0f, 0.0f, b1->x_prev, b0->x_prev);
+    l->y_prev[s] = simde_mm_set_ps(0.0f, 0.0f, b1->y_prev, b0->y_prev);
+  }
+}
+
+static inline void iir_halfband_store(IIRHalfband* hb, const IIRHalfbandLanes* l) {
+  float xp[4];
+  float yp[4];
+  for (size_t s = 0; s < hb->numSections; s++) {
+    simde_mm_storeu_ps(xp, l->x_prev[s]);
+    simde_mm_storeu_ps(yp, l->y_prev[s]);
+    for (size_t b = 0; b < 2; b++) {
+      hb->sections[b][s].x_prev = xp[b];
+      hb->sections[b][s].y_prev = yp[b];
+    }
+  }
+}
+
+// same recurrence as allpass1_process: y = -g * x + x_prev + g * y_prev
+static inline simde__m128 iir_halfband_cascade(IIRHalfbandLanes* l, size_t numSections, simde__m128 v) {
+  for (size_t s = 0; s < numSections; s++) {
+    simde__m128 y = simde_mm_add_ps(l->x_prev[s], simde_mm_mul_ps(l->g[s], simde_mm_sub_ps(l->y_prev[s], v)));
+    l->x_prev[s] = v;
+    l->y_prev[s] = y;
+    v = y;
+  }
+  return v;
+}
+
+void iir_halfband_upsample2x(IIRHalfband* hb, const float* in, float* out, size_t n) {
+  IIRHalfbandLanes l;
+  const size_t numSections = hb->numSections;
+  iir_halfband_load(hb, &l);
+  for (size_t i = 0; i < n; i++) {
+    simde__m128 v = iir_halfband_cascade(&l, numSections, simde_mm_set1_ps(in[i]));
+    float lanes[4];
+    simde_mm_storeu_ps(lanes, v);
+    out[2 * i] = lanes[0];
+    out[2 * i + 1] = lanes[1];
+  }
+  iir_halfband_store(hb, &l);
+}
+
+void iir_halfband_downsample2x(IIRHalfband* hb, const float* in, float* out, size_t n) {
+  IIRHalfbandLanes l;
+  const size_t numSections = hb->numSections;
+  iir_halfband_load(hb, &l);
+  for (size_t i = 0; i < n; i++) {
+    simde__m128 v = iir_halfband_cascade(&l, numSections, simde_mm_set_ps(0.0f, 0.0f, in[2 * i], in[2 * i + 1]));
+    float lanes[4];
+    simde_mm_storeu_ps(lanes, v);
+    out[i] = 0.5f * (lanes[0] + lanes[1]);
+  }
+  iir_halfband_store(hb, &l);
+}
+
+int convolver_ir_init(ConvolverIR* ir, const float* taps, size_t numTaps, size_t blockSize) {
+  memset(ir, 0, sizeof(*ir));
+  if (blockSize < SIMD_LANES || (blockSize & (blockSize - 1)) != 0) {
+    log_message(LOG_LEVEL_ERROR, "Convolver block size %zu must be a power of two >= %d", blockSize, SIMD_LANES);
+    return -1;
+  }
+  const size_t n = 2 * blockSize;
+  const FFTPlan* plan = fft_plan_get(n);
+  if (plan == NULL) {
+    return -1;
+  }
+  ir->blockSize = blockSize;
+  ir->numPartitions = numTaps > blockSize ? (numTaps - 1) / blockSize : 0;
+  ir->head = calloc(blockSize, sizeof(float));
+  ir->spectra = ir->numPartitions ? calloc(ir->numPartitions * n, sizeof(float)) : NULL;
+  if (ir->head == NULL || (ir->numPartitions && ir->spectra == NULL)) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate convolver IR");
+    convolver_ir_free(ir);
+    return -1;
+  }
+
+  for (size_t i = 0; i < blockSize && i < numTaps; i++) {
+    ir->head[blockSize - 1 - i] = taps[i];
+  }
+  // the inverse FFT's 1 / n is folded into the partitions
+  const float scale = 1.0f / (float)n;
+  for (size_t k = 0; k < ir->numPartitions; k++) {
+    float* x = ir->spectra + k * n;
+    for (size_t i = 0; i < blockSize; i++) {
+      size_t t = (k + 1) * blockSize + i;
+      x[i] = t < numTaps ? taps[t] * scale : 0.0f;
+    }
+    fft_forward_inplace(plan, x);
+  }
+  return 0;
+}
+
+void convolver_ir_free(ConvolverIR* ir) {
+  free(ir->head);
+  free(ir->spectra);
+  ir->head = NULL;
+  ir->spectra = NULL;
+  ir->numPartitions = 0;
+}
+
+int convolver_init(Convolver* c, size_t blockSize, size_t maxPartitions) {
+  memset(c, 0, sizeof(*c));
+  if (blockSize < SIMD_LANES || (blockSize & (blockSize - 1)) != 0) {
+    log_message(LOG_LEVEL_ERROR, "Convolver block size %zu must be a power of two >= %d", blockSize, SIMD_LANES);
+    return -1;
+  }
+  const size_t n = 2 * blockSize;
+  c->plan = fft_plan_get(n);
+  if (c->plan == NULL) {
+    return -1;
+  }
+  c->blockSize = blockSize;
+  c->maxPartitions = maxPartitions;
+  c->input = malloc((n + blockSize + maxPartitions * n + n) * sizeof(float));
+  if (c->input == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate convolver state");
+    return -1;
+  }
+  c->tail = c->input + n;
+  c->fdl = c->tail + blockSize;
+  c->accum = c->fdl + maxPartitions * n;
+  convolver_reset(c);
+  return 0;
+}
+
+void convolver_free(Convolver* c) {
+  free(c->input);
+  memset(c, 0, sizeof(*c));
+}
+
+void convolver_reset(Convolver* c) {
+  memset(c->input, 0, 3 * c->blockSize * sizeof(float));
+  memset(c->fdl, 0, c->maxPartitions * 2 * c->blockSize * sizeof(float));
+  c->pos = 0;
+  c->fdlHead = 0;
+}
+
+void convolver_set_ir(Convolver* c, const ConvolverIR* ir) {
+  if (ir != NULL && (ir->blockSize != c->blockSize || ir->numPartitions > c->maxPartitions)) {
+    log_message(LOG_LEVEL_ERROR, "IR does not fit this convolver (block %zu, %zu partitions)", ir->blockSize, ir->numPartitions);
+    return;
+  }
+  c->ir = ir;
+}
+
+// Sum of input spectrum j - 1 - k times partition k over every partition, back to the time domain;
+// the last blockSize samples of the overlap-save output are this block's tail.
+static void convolver_compute_tail(Convolver* c) {
+  const ConvolverIR* ir = c->ir;
+  const size_t B = c->blockSize;
+  const size_t n = 2 * B;
+  if (ir == NULL || ir->numPartitions == 0) {
+    memset(c->tail, 0, B * sizeof(float));
+    return;
+  }
+  memset(c->accum, 0, n * sizeof(float));
+  size_t slot = c->fdlHead;
+  for (size_t k = 0; k < ir->numPartitions; k++) {
+    fft_spectrum_mac(c->accum, c->fdl + slot * n, ir->spectra + k * n, n);
+    slot = slot == 0 ? c->maxPartitions - 1 : slot - 1;
+  }
+  fft_inverse_inplace(c->plan, c->accum);
+  memcpy(c->tail, c->accum + B, B * sizeof(float));
+}
+
+static void convolver_push_block(Convolver* c) {
+  const size_t B = c->blockSize;
+  if (c->maxPartitions > 0) {
+    c->fdlHead = c->fdlHead + 1 == c->maxPartitions ? 0 : c->fdlHead + 1;
+    fft_forward(c->plan, c->input, c->fdl + c->fdlHead * 2 * B);
+  }
+  memcpy(c->input, c->input + B, B * sizeof(float));
+}
+
+void convolver_process(Convolver* c, const float* in, float* out, size_t n) {
+  const size_t B = c->blockSize;
+  const float* head = c->ir ? c->ir->head : NULL;
+  size_t done = 0;
+  while (done < n) {
+    if (c->pos == 0) {
+      convolver_compute_tail(c);
+    }
+    size_t run = B - c->pos;
+    if (run > n - done) run = n - done;
+    // take the input first, in and out may be the same buffer
+    memcpy(c->input + B + c->pos, in + done, run * sizeof(float));
+    for (size_t i = 0; i < run; i++) {
+      size_t p = c->pos + i;
+      float y = c->tail[p];
+      if (head) {
+        y += simd_dot(head, c->input + p + 1, B);
+      }
+      out[done + i] = y;
+    }
+    c->pos += run;
+    done += run;
+    if (c->pos == B) {
+      convolver_push_block(c);
+      c->pos = 0;
+    }
+  }
+}
+
+void convolver_process_block(Convolver* c, const float* in, float* tail) {
+  const size_t B = c->blockSize;
+  memcpy(c->input + B, in, B * sizeof(float));
+  convolver_push_block(c);
+  convolver_compute_tail(c);
+  memcpy(tail, c->tail, B * sizeof(float));
+}
+
+int fdn_init(FDNReverb* fdn, float sampleRate) {
+  memset(fdn, 0, sizeof(*fdn));
+  fdn->buffer = malloc(FDN_MAX_DELAY * FDN_LINES * sizeof(float));
+  if (fdn->buffer == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate FDN delay memory");
+    return -1;
+  }
+  fdn->sampleRate = sampleRate;
+  fdn_reset(fdn);
+  fdn_set_params(fdn, 0.5f, 0.5f);
+  return 0;
+}
+
+void fdn_free(FDNReverb* fdn) {
+  free(fdn->buffer);
+  fdn->buffer = NULL;
+}
+
+void fdn_reset(FDNReverb* fdn) {
+  memset(fdn->buffer, 0, FDN_MAX_DELAY * FDN_LINES * sizeof(float));
+  memset(fdn->lowpass, 0, sizeof(fdn->lowpass));
+  fdn->writePos = 0;
+}
+
+void fdn_set_params(FDNReverb* fdn, float roomSize, float damping) {
+  // mutually prime lengths at 48 kHz, spread so the modes do not pile up
+  static const float baseDelay[FDN_LINES] = { 1031.0f, 1327.0f, 1523.0f, 1753.0f, 1973.0f, 2213.0f, 2459.0f, 2719.0f };
+  roomSize = clampf(roomSize, 0.0f, 1.0f);
+  const float scale = (0.4f + 1.2f * roomSize) * fdn->sampleRate / 48000.0f;
+  const float t60 = 0.3f + 4.7f * roomSize * roomSize;
+  for (size_t i = 0; i < FDN_LINES; i++) {
+    float d = clampf(baseDelay[i] * scale, 1.0f, (float)(FDN_MAX_DELAY - 1));
+    fdn->delay[i] = (int32_t)d;
+    fdn->feedback[i] = powf(10.0f, -3.0f * (float)fdn->delay[i] / (t60 * fdn->sampleRate));
+  }
+  fdn->damping = 0.85f * clampf(damping, 0.0f, 1.0f);
+}
+
+// orthogonal 8x8 Hadamard mix, three butterfly stages without leaving the register
+static inline simde__m256 fdn_hadamard(simde__m256 v) {
+  const simde__m256 sign1 = simde_mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+  const simde__m256 sign2 = simde_mm256_setr_ps(1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f);
+  const simde__m256 sign4 = simde_mm256_setr_ps(1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f);
+  v = simde_mm256_add_ps(simde_mm256_mul_ps(v, sign1), simde_mm256_permute_ps(v, 0xB1));
+  v = simde_mm256_add_ps(simde_mm256_mul_ps(v, sign2), simde_mm256_permute_ps(v, 0x4E));
+  v = simde_mm256_add_ps(simde_mm256_mul_ps(v, sign4), simde_mm256_permute2f128_ps(v, v, 1));
+  return simde_mm256_mul_ps(v, simde_mm256_set1_ps(0.35355339f));
+}
+
+void fdn_process(FDNReverb* fdn, const float* in, float* out, size_t n) {
+  const int32_t mask = FDN_MAX_DELAY - 1;
+  const simde__m256i lane = simde_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  const simde__m256i delay = simde_mm256_loadu_si256((const simde__m256i*)fdn->delay);
+  const simde__m256i vMask = simde_mm256_set1_epi32(mask);
+  const simde__m256 feedback = simde_mm256_loadu_ps(fdn->feedback);
+  const simde__m256 damp = simde_mm256_set1_ps(fdn->damping);
+  const simde__m256 undamp = simde_mm256_set1_ps(1.0f - fdn->damping);
+  // alternating signs in and out keep the lines decorrelated from the dry signal
+  const simde__m256 inSign = simde_mm256_setr_ps(1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f);
+  const simde__m256 outSign = simde_mm256_setr_ps(0.35f, 0.35f, -0.35f, -0.35f, 0.35f, -0.35f, 0.35f, -0.35f);
+  const float* buffer = fdn->buffer;
+  simde__m256 lp = simde_mm256_loadu_ps(fdn->lowpass);
+  int32_t t = (int32_t)fdn->writePos;
+
+  for (size_t i = 0; i < n; i++) {
+    simde__m256i readFrame = simde_mm256_and_si256(simde_mm256_sub_epi32(simde_mm256_set1_epi32(t), delay), vMask);
+    simde__m256i idx = simde_mm256_or_si256(simde_mm256_slli_epi32(readFrame, 3), lane);
+    simde__m256 y = simde_mm256_i32gather_ps(buffer, idx, 4);
+    float x = in[i];
+    out[i] = simd_hsum(simde_mm256_mul_ps(y, outSign));
+    lp = simde_mm256_add_ps(simde_mm256_mul_ps(undamp, y), simde_mm256_mul_ps(damp, lp));
+    simde__m256 w = simde_mm256_mul_ps(fdn_hadamard(lp), feedback);
+    w = simde_mm256_add_ps(w, simde_mm256_mul_ps(inSign, simde_mm256_set1_ps(x)));
+    simde_mm256_storeu_ps(&fdn->buffer[(size_t)t * FDN_LINES], w);
+    t = (t + 1) & mask;
+  }
+
+  simde_mm256_storeu_ps(fdn->lowpass, bank_flush_denormal(lp));
+  fdn->writePos = (size_t)t;
+}
+
+// restart points stay this far back so the 4-tap Lagrange read never needs samples not yet written
+#define GRAIN_SHIFTER_MIN_DELAY 2.0f
+
+int grain_shifter_init(GrainShifter* gs, float sampleRate) {
+  memset(gs, 0, sizeof(*gs));
+  gs->grain = (size_t)(GRAIN_SHIFTER_GRAIN_MS * 0.001f * sampleRate);
+  gs->search = (size_t)(GRAIN_SHIFTER_SEARCH_MS * 0.001f * sampleRate);
+  gs->window = ((size_t)(0.0025f * sampleRate) + SIMD_LANES - 1) & ~(size_t)(SIMD_LANES - 1);
+  // the furthest read is a search window behind the longest restart point, from a block's start
+  size_t reach = GRAIN_SHIFTER_BLOCK + (size_t)GRAIN_SHIFTER_MIN_DELAY + gs->grain + gs->search + gs->window + DELAYLINE_GUARD;
+  gs->memory = malloc(delayline_pow2_buffer_size(reach) * sizeof(float));
+  gs->scratch = malloc((5 * GRAIN_SHIFTER_BLOCK + 2 * gs->window + gs->search) * sizeof(float));
+  if (gs->memory == NULL || gs->scratch == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate pitch shifter memory");
+    grain_shifter_free(gs);
+    return -1;
+  }
+  delayline_init_pow2(&gs->line, gs->memory, reach, sampleRate);
+  gs->ratio = 1.0f;
+  grain_shifter_reset(gs);
+  return 0;
+}
+
+void grain_shifter_free(GrainShifter* gs) {
+  free(gs->memory);
+  free(gs->scratch);
+  gs->memory = NULL;
+  gs->scratch = NULL;
+}
+
+void grain_shifter_reset(GrainShifter* gs) {
+  memset(gs->memory, 0, (gs->line.size + DELAYLINE_GUARD) * sizeof(float));
+  gs->line.writeIndex = 0;
+  gs->phase = 0.0f;
+  gs->offset[0] = 0.0f;
+  gs->offset[1] = 0.0f;
+}
+
+void grain_shifter_set_ratio(GrainShifter* gs, float ratio) {
+  gs->ratio = clampf(ratio, 0.25f, 4.0f);
+}
+
+// Restart nudge for a tap starting at baseDelay, at sample i of the n just written: the shift in
+// [0, search] whose trailing window best matches (normalised cross-correlation) the one behind
+// the other tap
+static float grain_shifter_align(GrainShifter* gs, size_t n, size_t i, float baseDelay, float otherDelay) {
+  const size_t L = gs->window;
+  const size_t S = gs->search;
+  float* ref = gs->scratch + 5 * GRAIN_SHIFTER_BLOCK;
+  float* cand = ref + L;
+  const float back = (float)(n - i);
+  delayline_read_linear(&gs->line, ref, L, back + floorf(otherDelay + 0.5f) + (float)L);
+  delayline_read_linear(&gs->line, cand, S + L, back + floorf(baseDelay + 0.5f) + (float)(S + L));
+
+  // shift d uses cand[S - d, S - d + L); stepping d slides the energy by one sample at each end
+  float energy = simd_dot(cand + S, cand + S, L);
+  float best = -INFINITY;
+  size_t bestShift = 0;
+  for (size_t d = 0; d <= S; d++) {
+    const float* c = cand + S - d;
+    if (d > 0) {
+      energy += c[0] * c[0] - c[L] * c[L];
+    }
+    float score = simd_dot(ref, c, L) / sqrtf(fmaxf(energy, 0.0f) + 1e-9f);
+    if (score > best) {
+      best = score;
+      bestShift = d;
+    }
+  }
+  return (float)bestShift;
+}
+
+void grain_shifter_process(GrainShifter* gs, const float* in, float* out, size_t n) {
+  float* delayA = gs->scratch;
+  float* delayB = delayA + GRAIN_SHIFTER_BLOCK;
+  float* phases = delayB + GRAIN_SHIFTER_BLOCK;
+  float* tapA = phases + GRAIN_SHIFTER_BLOCK;
+  float* tapB = tapA + GRAIN_SHIFTER_BLOCK;
+  const float grain = (float)gs->grain;
+  const float inc = (1.0f - gs->ratio) / grain;
+  const simde__m256 pi = simde_mm256_set1_ps((float)M_PI);
+
+  for (size_t done = 0; done < n;) {
+    size_t m = n - done < GRAIN_SHIFTER_BLOCK ? n - done : GRAIN_SHIFTER_BLOCK;
+    delayline_write(&gs->line, in + done, m);
+
+    float phase = gs->phase;
+    float phaseB = phase < 0.5f ? phase + 0.5f : phase - 0.5f;
+    for (size_t i = 0; i < m; i++) {
+      float prev = phase;
+      float prevB = phaseB;
+      phase += inc;
+      phase -= floorf(phase);
+      phaseB = phase < 0.5f ? phase + 0.5f : phase - 0.5f;
+      // a tap wraps where its window is zero, so it can restart anywhere unheard
+      if (fabsf(phase - prev) > 0.5f) {
+        gs->offset[0] = grain_shifter_align(gs, m, i, GRAIN_SHIFTER_MIN_DELAY + phase * grain, GRAIN_SHIFTER_MIN_DELAY + gs->offset[1] + phaseB * grain);
+      }
+      if (fabsf(phaseB - prevB) > 0.5f) {
+        gs->offset[1] = grain_shifter_align(gs, m, i, GRAIN_SHIFTER_MIN_DELAY + phaseB * grain, GRAIN_SHIFTER_MIN_DELAY + gs->offset[0] + phase * grain);
+      }
+      delayA[i] = GRAIN_SHIFTER_MIN_DELAY + gs->offset[0] + phase * grain;
+      delayB[i] = GRAIN_SHIFTER_MIN_DELAY + gs->offset[1] + phaseB * grain;
+      phases[i] = phase;
+    }
+    gs->phase = phase;
+
+    delayline_read_modulated(&gs->line, tapA, delayA, m, DELAY_INTERP_LAGRANGE, NULL);
+    delayline_read_modulated(&gs->line, tapB, delayB, m, DELAY_INTERP_LAGRANGE, NULL);
+    // sin^2 and cos^2 of the same phase sum to one
+    float* y = out + done;
+    size_t i = 0;
+    for (; i + SIMD_LANES <= m; i += SIMD_LANES) {
+      simde__m256 s = fast_sin_ps(simde_mm256_mul_ps(pi, simde_mm256_loadu_ps(&phases[i])), FAST_MATH_BALANCED);
+      simde__m256 a = simde_mm256_loadu_ps(&tapA[i]);
+      simde__m256 b = simde_mm256_loadu_ps(&tapB[i]);
+      simde_mm256_storeu_ps(&y[i], simde_mm256_add_ps(b, simde_mm256_mul_ps(simde_mm256_mul_ps(s, s), simde_mm256_sub_ps(a, b))));
+    }
+    for (; i < m; i++) {
+      float s = fast_sinf((float)M_PI * phases[i], FAST_MATH_BALANCED);
+      y[i] = tapB[i] + s * s * (tapA[i] - tapB[i]);
+    }
+    done += m;
+  }
+}
+
+// atan2 from fast_atan_ps: atan(y / x), moved into the left half-plane when x < 0
+static inline simde__m256 pv_atan2_ps(simde__m256 y, simde__m256 x) {
+  const simde__m256 zero = simde_mm256_setzero_ps();
+  simde__m256 safeX = simde_mm256_blendv_ps(x, simde_mm256_set1_ps(1e-30f), simde_mm256_cmp_ps(x, zero, SIMDE_CMP_EQ_OQ));
+  simde__m256 a = fast_atan_ps(simde_mm256_div_ps(y, safeX), FAST_MATH_PRECISE);
+  simde__m256 halfTurn = simde_mm256_or_ps(simde_mm256_set1_ps((float)M_PI), simde_mm256_and_ps(y, simde_mm256_set1_ps(-0.0f)));
+  return simde_mm256_add_ps(a, simde_mm256_and_ps(simde_mm256_cmp_ps(x, zero, SIMDE_CMP_LT_OQ), halfTurn));
+}
+
+// x - 2 pi * round(x / 2 pi)
+static inline simde__m256 pv_wrap_phase_ps(simde__m256 x) {
+  simde__m256 k = simde_mm256_round_ps(simde_mm256_mul_ps(x, simde_mm256_set1_ps(0.15915494f)), SIMDE_MM_FROUND_TO_NEAREST_INT | SIMDE_MM_FROUND_NO_EXC);
+  return simde_mm256_sub_ps(x, simde_mm256_mul_ps(k, simde_mm256_set1_ps(6.28318531f)));
+}
+
+int phase_vocoder_init(PhaseVocoder* pv, size_t frameSize, float sampleRate) {
+  memset(pv, 0, sizeof(*pv));
+  pv->plan = fft_plan_get(frameSize);
+  if (pv->plan == NULL || frameSize < 4 * SIMD_LANES) {
+    return -1;
+  }
+  const size_t N = frameSize;
+  const size_t bins = N / 2;
+  pv->frameSize = N;
+  pv->hop = N / 4;
+  // keep quefrencies under ~0.7 ms: the envelope resolves formants but not harmonics of notes
+  // below ~1.4 kHz
+  pv->lifter = (size_t)(0.0007f * sampleRate);
+  if (pv->lifter < 2) pv->lifter = 2;
+  if (pv->lifter > bins) pv->lifter = bins;
+
+  // peaks are at least two bins apart, so there are never more than bins / 2
+  pv->window = malloc((5 * N + pv->hop + 11 * bins) * sizeof(float));
+  pv->peaks = malloc(3 * (bins / 2) * sizeof(uint32_t));
+  if (pv->window == NULL || pv->peaks == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate phase vocoder memory");
+    phase_vocoder_free(pv);
+    return -1;
+  }
+  pv->input = pv->window + N;
+  pv->output = pv->input + N;
+  pv->frame = pv->output + N;
+  pv->cepstrum = pv->frame + N;
+  pv->ready = pv->cepstrum + N;
+  pv->re = pv->ready + pv->hop;
+  pv->im = pv->re + bins;
+  pv->magnitude = pv->im + bins;
+  pv->frequency = pv->magnitude + bins;
+  pv->phase = pv->frequency + bins;
+  pv->lastPhase = pv->phase + bins;
+  pv->envelope = pv->lastPhase + bins;
+  pv->synthRe = pv->envelope + bins;
+  pv->synthIm = pv->synthRe + bins;
+  pv->peakPhase = pv->synthIm + bins;
+  pv->lastPeakPhase = pv->peakPhase + bins / 2;
+  pv->peakTarget = pv->peaks + bins / 2;
+  pv->lastPeakTarget = pv->peakTarget + bins / 2;
+
+  // periodic Hann on both ends; at 75% overlap the squared windows sum to a constant
+  double energy = 0.0;
+  for (size_t k = 0; k < N; k++) {
+    pv->window[k] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * (float)k / (float)N);
+    energy += (double)pv->window[k] * pv->window[k];
+  }
+  pv->outputScale = (float)((double)pv->hop / (energy * (double)N));
+  pv->ratio = 1.0f;
+  phase_vocoder_reset(pv);
+  return 0;
+}
+
+void phase_vocoder_free(PhaseVocoder* pv) {
+  free(pv->window);
+  free(pv->peaks);
+  memset(pv, 0, sizeof(*pv));
+}
+
+void phase_vocoder_reset(PhaseVocoder* pv) {
+  memset(pv->input, 0, 2 * pv->frameSize * sizeof(float));
+  memset(pv->ready, 0, pv->hop * sizeof(float));
+  memset(pv->lastPhase, 0, pv->frameSize / 2 * sizeof(float));
+  pv->fill = 0;
+  pv->numLastPeaks = 0;
+}
+
+void phase_vocoder_set_params(PhaseVocoder* pv, float ratio, float formant) {
+  pv->ratio = clampf(ratio, 0.25f, 4.0f);
+  pv->formant = clampf(formant, 0.0f, 1.0f);
+}
+
+size_t phase_vocoder_latency(const PhaseVocoder* pv) {
+  return pv->frameSize;
+}
+
+// Log magnitude smoothed by keeping only the low quefrencies; the log spectrum is extended to an
+// even sequence so its cepstrum and the smoothed result are both real
+static void phase_vocoder_envelope(PhaseVocoder* pv) {
+  const size_t N = pv->frameSize;
+  const size_t bins = N / 2;
+  float* c = pv->cepstrum;
+  for (size_t k = 0; k < bins; k += SIMD_LANES) {
+    simde__m256 m = simde_mm256_add_ps(simde_mm256_loadu_ps(&pv->magnitude[k]), simde_mm256_set1_ps(1e-9f));
+    simde_mm256_storeu_ps(&c[k], fast_log_ps(m, FAST_MATH_BALANCED));
+  }
+  c[bins] = c[bins - 1];
+  for (size_t k = 1; k < bins; k++) {
+    c[N - k] = c[k];
+  }
+  fft_forward_inplace(pv->plan, c);
+  memset(c + 2 * pv->lifter, 0, (N - 2 * pv->lifter) * sizeof(float));
+  c[1] = 0.0f;
+  fft_inverse_inplace(pv->plan, c);
+  const simde__m256 scale = simde_mm256_set1_ps(1.0f / (float)N);
+  for (size_t k = 0; k < bins; k += SIMD_LANES) {
+    simde_mm256_storeu_ps(&pv->envelope[k], simde_mm256_mul_ps(simde_mm256_loadu_ps(&c[k]), scale));
+  }
+}
+
+// Local maxima over +-2 bins, no more than 80 dB below the loudest
+static size_t phase_vocoder_find_peaks(PhaseVocoder* pv) {
+  const size_t bins = pv->frameSize / 2;
+  const float* m = pv->magnitude;
+  float loudest = 0.0f;
+  for (size_t k = 0; k < bins; k++) {
+    loudest = fmaxf(loudest, m[k]);
+  }
+  const float floor = loudest * 1e-4f;
+  size_t count = 0;
+  for (size_t k = 2; k + 2 < bins; k++) {
+    if (m[k] > floor && m[k] > m[k - 1] && m[k] >= m[k + 1] && m[k] > m[k - 2] && m[k] >= m[k + 2]) {
+      pv->peaks[count++] = (uint32_t)k;
+      k++;
+    }
+  }
+  return count;
+}
+
+// Moves every peak's region of influence (out to halfway to its neighbours) to the bin nearest
+// ratio times the peak's true frequency, rotated so the peak's phase carries on from where the
+// partial was heading last frame. The lobe's shape and relative phases stay intact, which keeps
+// partials from smearing the way independently shifted bins do.
+static void phase_vocoder_shift_peaks(PhaseVocoder* pv, size_t numPeaks) {
+  const size_t bins = pv->frameSize / 2;
+  const float expected = 2.0f * (float)M_PI * (float)pv->hop / (float)pv->frameSize;
+  const float ratio = pv->ratio;
+  const float formant = pv->formant;
+  size_t last = 0;
+
+  memset(pv->synthRe, 0, 2 * bins * sizeof(float));
+  for (size_t p = 0; p < numPeaks; p++) {
+    const size_t k = pv->peaks[p];
+    const size_t lo = p == 0 ? 1 : (pv->peaks[p - 1] + k + 1) / 2;
+    const size_t hi = p + 1 == numPeaks ? bins : (k + pv->peaks[p + 1] + 1) / 2;
+    const float target = pv->frequency[k] * ratio;
+    const long shift = lroundf(target) - (long)k;
+    const uint32_t dest = (uint32_t)lroundf(target);
+
+    // the partial that landed closest last frame, if any, sets where the phase continues from
+    while (last + 1 < pv->numLastPeaks && pv->lastPeakTarget[last + 1] <= dest) last++;
+    // signed distances: dest can sit below every target from last frame, where an unsigned
+    // dest - lastPeakTarget[last] would wrap and hand the match to the wrong neighbour
+    size_t match = last;
+    if (last + 1 < pv->numLastPeaks && abs((int)pv->lastPeakTarget[last + 1] - (int)dest) < abs((int)pv->lastPeakTarget[last] - (int)dest)) match = last + 1;
+    float phase;
+    if (pv->numLastPeaks > 0 && abs((int)pv->lastPeakTarget[match] - (int)dest) <= 2) {
+      phase = pv->lastPeakPhase[match] + expected * target;
+      phase -= 2.0f * (float)M_PI * floorf(phase / (2.0f * (float)M_PI) + 0.5f);
+    } else {
+      phase = pv->phase[k];
+    }
+    pv->peakTarget[p] = dest;
+    pv->peakPhase[p] = phase;
+
+    const float rotation = phase - pv->phase[k];
+    const float c = fast_sinf(rotation + 0.5f * (float)M_PI, FAST_MATH_BALANCED);
+    const float s = fast_sinf(rotation, FAST_MATH_BALANCED);
+    for (size_t j = lo; j < hi; j++) {
+      long d = (long)j + shift;
+      if (d <= 0 || d >= (long)bins) {
+        continue;
+      }
+      float g = formant > 0.0f ? fast_expf(formant * (pv->envelope[d] - pv->envelope[j]), FAST_MATH_BALANCED) : 1.0f;
+      pv->synthRe[d] += g * (pv->re[j] * c - pv->im[j] * s);
+      pv->synthIm[d] += g * (pv->re[j] * s + pv->im[j] * c);
+    }
+  }
+
+  float* phases = pv->lastPeakPhase;
+  uint32_t* targets = pv->lastPeakTarget;
+  pv->lastPeakPhase = pv->peakPhase;
+  pv->lastPeakTarget = pv->peakTarget;
+  pv->peakPhase = phases;
+  pv->peakTarget = targets;
+  pv->numLastPeaks = numPeaks;
+}
+
+static void phase_vocoder_frame(PhaseVocoder* pv) {
+  const size_t N = pv->frameSize;
+  const size_t bins = N / 2;
+  const float expected = 2.0f * (float)M_PI * (float)pv->hop / (float)N;
+  float* x = pv->frame;
+
+  for (size_t k = 0; k < N; k += SIMD_LANES) {
+    simde_mm256_storeu_ps(&x[k], simde_mm256_mul_ps(simde_mm256_loadu_ps(&pv->input[k]), simde_mm256_loadu_ps(&pv->window[k])));
+  }
+  fft_forward_inplace(pv->plan, x);
+  for (size_t k = 0; k < bins; k++) {
+    pv->re[k] = x[2 * k];
+    pv->im[k] = x[2 * k + 1];
+  }
+  pv->im[0] = 0.0f;
+
+  // analysis: magnitude, phase, and the bin's true frequency from how far its phase moved past
+  // the advance its centre frequency predicts
+  const simde__m256 vExpected = simde_mm256_set1_ps(expected);
+  const simde__m256 invExpected = simde_mm256_set1_ps(1.0f / expected);
+  for (size_t k = 0; k < bins; k += SIMD_LANES) {
+    simde__m256 re = simde_mm256_loadu_ps(&pv->re[k]);
+    simde__m256 im = simde_mm256_loadu_ps(&pv->im[k]);
+    simde__m256 bin = simde_mm256_add_ps(simde_mm256_set1_ps((float)k), simde_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f));
+    simde__m256 phase = pv_atan2_ps(im, re);
+    simde__m256 delta = simde_mm256_sub_ps(phase, simde_mm256_loadu_ps(&pv->lastPhase[k]));
+    delta = pv_wrap_phase_ps(simde_mm256_sub_ps(delta, simde_mm256_mul_ps(bin, vExpected)));
+    simde_mm256_storeu_ps(&pv->phase[k], phase);
+    simde_mm256_storeu_ps(&pv->lastPhase[k], phase);
+    simde_mm256_storeu_ps(&pv->magnitude[k], simde_mm256_sqrt_ps(simde_mm256_add_ps(simde_mm256_mul_ps(re, re), simde_mm256_mul_ps(im, im))));
+    simde_mm256_storeu_ps(&pv->frequency[k], simde_mm256_add_ps(bin, simde_mm256_mul_ps(delta, invExpected)));
+  }
+
+  if (pv->formant > 0.0f) {
+    phase_vocoder_envelope(pv);
+  }
+  phase_vocoder_shift_peaks(pv, phase_vocoder_find_peaks(pv));
+
+  for (size_t k = 0; k < bins; k++) {
+    x[2 * k] = pv->synthRe[k];
+    x[2 * k + 1] = pv->synthIm[k];
+  }
+  // DC and Nyquist are dropped
+  x[0] = 0.0f;
+  x[1] = 0.0f;
+  fft_inverse_inplace(pv->plan, x);
+
+  const simde__m256 scale = simde_mm256_set1_ps(pv->outputScale);
+  for (size_t k = 0; k < N; k += SIMD_LANES) {
+    simde__m256 y = simde_mm256_mul_ps(simde_mm256_mul_ps(simde_mm256_loadu_ps(&x[k]), simde_mm256_loadu_ps(&pv->window[k])), scale);
+    simde_mm256_storeu_ps(&pv->output[k], simde_mm256_add_ps(simde_mm256_loadu_ps(&pv->output[k]), y));
+  }
+  memcpy(pv->ready, pv->output, pv->hop * sizeof(float));
+  memmove(pv->output, pv->output + pv->hop, (N - pv->hop) * sizeof(float));
+  memset(pv->output + N - pv->hop, 0, pv->hop * sizeof(float));
+  memmove(pv->input, pv->input + pv->hop, (N - pv->hop) * sizeof(float));
+}
+
+void phase_vocoder_process(PhaseVocoder* pv, const float* in, float* out, size_t n) {
+  const size_t hop = pv->hop;
+  float* tail = pv->input + pv->frameSize - hop;
+  for (size_t done = 0; done < n;) {
+    size_t run = hop - pv->fill;
+    if (run > n - done) run = n - done;
+    // take the input first, in and out may be the same buffer
+    memcpy(tail + pv->fill, in + done, run * sizeof(float));
+    memcpy(out + done, pv->ready + pv->fill, run * sizeof(float));
+    pv->fill += run;
+    done += run;
+    if (pv->fill == hop) {
+      phase_vocoder_frame(pv);
+      pv->fill = 0;
+    }
+  }
+}
+
+int limiter_init(Limiter* l, float sampleRate) {
+  memset(l, 0, sizeof(*l));
+  l->sampleRate = sampleRate;
+  l->maxWindow = (size_t)(LIMITER_MAX_LOOKAHEAD_MS * 0.001f * sampleRate) + 1;
+  if (oversampler_init(&l->os, LIMITER_TRUE_PEAK_FACTOR, 32) != 0) {
+    return -1;
+  }
+  // room for the longest lookahead, the upsampler's delay and one chunk read back
+  size_t reach = l->maxWindow + oversampler_latency(&l->os) + LIMITER_CHUNK + DELAYLINE_GUARD;
+  l->memory = malloc(delayline_pow2_buffer_size(reach) * sizeof(float));
+  l->segment = malloc((2 * l->maxWindow + 1) * sizeof(float));
+  if (l->memory == NULL || l->segment == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate limiter memory");
+    limiter_free(l);
+    return -1;
+  }
+  l->suffixMax = l->segment + l->maxWindow;
+  delayline_init_pow2(&l->line, l->memory, reach, sampleRate);
+  l->ratio = 100.0f;
+  l->attackCoeff = 1.0f;
+  l->releaseCoeff = 1.0f;
+  l->window = 1;
+  l->latency = 0;
+  limiter_reset(l);
+  return 0;
+}
+
+void limiter_free(Limiter* l) {
+  free(l->memory);
+  free(l->segment);
+  l->memory = NULL;
+  l->segment = NULL;
+  l->suffixMax = NULL;
+}
+
+void limiter_reset(Limiter* l) {
+  memset(l->memory, 0, (l->line.size + DELAYLINE_GUARD) * sizeof(float));
+  l->line.writeIndex = 0;
+  memset(l->segment, 0, (2 * l->maxWindow + 1) * sizeof(float));
+  l->segPos = 0;
+  l->prefixMax = 0.0f;
+  l->reduction = 0.0f;
+  oversampler_reset(&l->os);
+}
+
+void limiter_set_params(Limiter* l, float thresholdDb, float ratio, float lookaheadMs, float releaseMs, int truePeak) {
+  size_t lookahead = (size_t)(clampf(lookaheadMs, 0.0f, LIMITER_MAX_LOOKAHEAD_MS) * 0.001f * l->sampleRate);
+  if (lookahead + 1 > l->maxWindow) lookahead = l->maxWindow - 1;
+  truePeak = truePeak ? 1 : 0;
+  // the detector and the audio would no longer line up
+  if (lookahead + 1 != l->window || truePeak != l->truePeak) {
+    l->window = lookahead + 1;
+    l->truePeak = truePeak;
+    l->latency = lookahead + (truePeak ? oversampler_latency(&l->os) / 2 : 0);
+    limiter_reset(l);
+  }
+  l->thresholdDb = fminf(thresholdDb, 0.0f);
+  l->ratio = fmaxf(ratio, 1.0f);
+  // a fifth of the lookahead leaves under 1% of the reduction to settle when the peak comes out
+  l->attackCoeff = lookahead > 0 ? 1.0f - expf(-5.0f / (float)lookahead) : 1.0f;
+  l->releaseCoeff = ms_to_coeff(releaseMs, l->sampleRate);
+}
+
+// per-sample peak, the true peak being the largest |x| of each sample's oversampled group
+static void limiter_peaks(Limiter* l, const float* in, float* peak, size_t n) {
+  if (!l->truePeak) {
+    for (size_t i = 0; i < n; i++) {
+      peak[i] = fabsf(in[i]);
+    }
+    return;
+  }
+  float up[LIMITER_CHUNK * LIMITER_TRUE_PEAK_FACTOR];
+  oversampler_upsample(&l->os, in, up, n);
+  for (size_t i = 0; i < n; i++) {
+    const float* group = &up[i * LIMITER_TRUE_PEAK_FACTOR];
+    float m = fabsf(group[0]);
+    for (size_t k = 1; k < LIMITER_TRUE_PEAK_FACTOR; k++) {
+      m = fmaxf(m, fabsf(group[k]));
+    }
+    peak[i] = m;
+  }
+}
+
+// Window max in place. Sample j of a segment sees the previous segment from j + 1 on and the
+// current one up to j; when a segment completes, its suffix maxima serve the next one.
+static void limiter_window_max(Limiter* l, float* peak, size_t n) {
+  const size_t window = l->window;
+  float* segment = l->segment;
+  float* suffixMax = l->suffixMax;
+  size_t pos = l->segPos;
+  float prefixMax = l->prefixMax;
+  for (size_t i = 0; i < n; i++) {
+    segment[pos] = peak[i];
+    prefixMax = fmaxf(prefixMax, peak[i]);
+    peak[i] = fmaxf(suffixMax[pos + 1], prefixMax);
+    if (++pos == window) {
+      float m = 0.0f;
+      suffixMax[window] = 0.0f;
+      for (size_t k = window; k-- > 0;) {
+        m = fmaxf(m, segment[k]);
+        suffixMax[k] = m;
+      }
+      pos = 0;
+      prefixMax = 0.0f;
+    }
+  }
+  l->segPos = pos;
+  l->prefixMax = prefixMax;
+}
+
+void limiter_process(Limiter* l, const float* in, float* out, size_t n) {
+  const float ceiling = db_to_linear(l->thresholdDb);
+  float level[LIMITER_CHUNK];
+  float threshold[LIMITER_CHUNK];
+  float reduction[LIMITER_CHUNK];
+  float delayed[LIMITER_CHUNK];
+  for (size_t done = 0; done < n; done += LIMITER_CHUNK) {
+    const size_t run = n - done < LIMITER_CHUNK ? n - done : LIMITER_CHUNK;
+    limiter_peaks(l, in + done, level, run);
+    limiter_window_max(l, level, run);
+    for (size_t i = 0; i < run; i++) {
+      // only levels over the threshold need the log
+      level[i] = level[i] > ceiling ? linear_to_db(level[i]) : l->thresholdDb;
+      threshold[i] = l->thresholdDb;
+    }
+    compute_gain_reduction_db(level, threshold, l->ratio, reduction, run);
+    // smoothed as a positive amount, so more reduction takes the attack coefficient
+    for (size_t i = 0; i < run; i++) {
+      reduction[i] = -reduction[i];
+    }
+    apply_gain_smoothing(reduction, reduction, &l->reduction, l->attackCoeff, l->releaseCoeff, run);
+
+    delayline_write(&l->line, in + done, run);
+    delayline_read_linear(&l->line, delayed, run, (float)(l->latency + run));
+    for (size_t i = 0; i < run; i++) {
+      float y = delayed[i] * db_to_linear(-reduction[i]);
+      out[done + i] = clampf(y, -ceiling, ceiling);
+    }
+  }
+}
+
+size_t limiter_latency(const Limiter* l) {
+  return l->latency;
+}
+
+// detector ballistics; the audible attack and release are the gain smoothing's
+#define COMPRESSOR_PEAK_RELEASE_MS 10.0f
+#define COMPRESSOR_RMS_MS 10.0f
+
+void compressor_init(Compressor* c, float sampleRate, int isRMS) {
+  memset(c, 0, sizeof(*c));
+  c->sampleRate = sampleRate;
+  if (isRMS) {
+    env_init(&c->detector, COMPRESSOR_RMS_MS, COMPRESSOR_RMS_MS, sampleRate, 1);
+  } else {
+    env_init(&c->detector, 0.0f, COMPRESSOR_PEAK_RELEASE_MS, sampleRate, 0);
+  }
+  c->interval = 1;
+  compressor_set_params(c, 0.0f, 1.0f, 0.0f, 10.0f, 100.0f, 0.0f);
+  compressor_reset(c);
+}
+
+void compressor_reset(Compressor* c) {
+  c->detector.env = 0.0f;
+  c->reduction = 0.0f;
+  c->countdown = 0;
+  c->gain = db_to_linear(c->makeupDb);
+  c->gainStep = 0.0f;
+}
+
+static void compressor_update_coeffs(Compressor* c) {
+  const float controlRate = c->sampleRate / (float)c->interval;
+  c->attackCoeff = ms_to_coeff(c->attackMs, controlRate);
+  c->releaseCoeff = ms_to_coeff(c->releaseMs, controlRate);
+}
+
+void compressor_set_params(Compressor* c, float thresholdDb, float ratio, float kneeDb, float attackMs, float releaseMs, float makeupDb) {
+  c->thresholdDb = thresholdDb;
+  c->ratio = fmaxf(ratio, 1.0f);
+  c->kneeDb = fmaxf(kneeDb, 0.0f);
+  c->makeupDb = makeupDb;
+  c->attackMs = attackMs;
+  c->releaseMs = releaseMs;
+  compressor_update_coeffs(c);
+}
+
+void compressor_set_control_rate(Compressor* c, size_t interval) {
+  c->interval = interval > 0 ? interval : 1;
+  if (c->countdown >= c->interval) {
+    c->countdown = 0;
+  }
+  compressor_update_coeffs(c);
+}
+
+void compressor_compute_gain(Compressor* c, const float* key, float* gain, size_t n) {
+  const size_t interval = c->interval;
+  const float invInterval = 1.0f / (float)interval;
+  float env[COMPRESSOR_CHUNK];
+  float control[COMPRESSOR_CHUNK];
+  for (size_t done = 0; done < n; done += COMPRESSOR_CHUNK) {
+    const size_t run = n - done < COMPRESSOR_CHUNK ? n - done : COMPRESSOR_CHUNK;
+    env_process(&c->detector, key + done, env, run);
+
+    // the gain computer only sees the samples that fall on the control grid
+    size_t m = 0;
+    for (size_t i = c->countdown; i < run; i += interval) {
+      control[m++] = env[i];
+    }
+    linear_to_db_block(control, control, m);
+    compute_gain_reduction_db_soft(control, c->thresholdDb, c->ratio, c->kneeDb, control, m);
+    // smoothed as a positive amount, so more reduction takes the attack coefficient
+    for (size_t k = 0; k < m; k++) {
+      control[k] = -control[k];
+    }
+    apply_gain_smoothing(control, control, &c->reduction, c->attackCoeff, c->releaseCoeff, m);
+    for (size_t k = 0; k < m; k++) {
+      control[k] = c->makeupDb - control[k];
+    }
+    db_to_linear_block(control, control, m);
+
+    // each control point starts a ramp that reaches its gain one interval later
+    float* g = gain + done;
+    size_t k = 0;
+    for (size_t i = 0; i < run; i++) {
+      if (c->countdown == 0) {
+        c->gainStep = (control[k++] - c->gain) * invInterval;
+        c->countdown = interval;
+      }
+      c->gain += c->gainStep;
+      g[i] = c->gain;
+      c->countdown--;
+    }
+  }
+}
+
+void compressor_process(Compressor* c, const float* in, float* out, size_t n) {
+  float gain[COMPRESSOR_CHUNK];
+  for (size_t done = 0; done < n; done += COMPRESSOR_CHUNK) {
+    const size_t run = n - done < COMPRESSOR_CHUNK ? n - done : COMPRESSOR_CHUNK;
+    compressor_compute_gain(c, in + done, gain, run);
+    size_t i = 0;
+    for (; i + SIMD_LANES <= run; i += SIMD_LANES) {
+      simde__m256 x = simde_mm256_loadu_ps(&in[done + i]);
+      simde_mm256_storeu_ps(&out[done + i], simde_mm256_mul_ps(x, simde_mm256_loadu_ps(&gain[i])));
+    }
+    for (; i < run; i++) {
+      out[done + i] = in[done + i] * gain[i];
+    }
+  }
+}
+
+// long enough that the detector doesn't fall through the hysteresis between the peaks of a
+// low E
+#define NOISE_GATE_DETECTOR_MS 20.0f
+
+void noise_gate_init(NoiseGate* g, float sampleRate) {
+  memset(g, 0, sizeof(*g));
+  g->sampleRate = sampleRate;
+  g->envDecay = expf(-(float)SIMD_LANES / (0.001f * NOISE_GATE_DETECTOR_MS * sampleRate));
+  noise_gate_set_params(g, -60.0f, 6.0f, 1.0f, 50.0f, 100.0f, -80.0f);
+  noise_gate_reset(g);
+}
+
+void noise_gate_reset(NoiseGate* g) {
+  g->env = 0.0f;
+  g->hold = 0;
+  g->open = 1;
+  g->gain = 1.0f;
+}
+
+void noise_gate_set_params(NoiseGate* g, float thresholdDb, float hysteresisDb, float attackMs, float holdMs, float releaseMs, float rangeDb) {
+  g->openLevel = db_to_linear(thresholdDb);
+  g->closeLevel = db_to_linear(thresholdDb - fmaxf(hysteresisDb, 0.0f));
+  g->floorGain = rangeDb <= -120.0f ? 0.0f : db_to_linear(fminf(rangeDb, 0.0f));
+  g->holdBlocks = (size_t)(fmaxf(holdMs, 0.0f) * 0.001f * g->sampleRate / (float)SIMD_LANES);
+  const float attackKeep = 1.0f - ms_to_coeff(attackMs, g->sampleRate);
+  const float releaseKeep = 1.0f - ms_to_coeff(releaseMs, g->sampleRate);
+  float a = attackKeep;
+  float r = releaseKeep;
+  for (size_t k = 0; k < SIMD_LANES; k++) {
+    g->attackPow[k] = a;
+    g->releasePow[k] = r;
+    a *= attackKeep;
+    r *= releaseKeep;
+  }
+}
+
+void noise_gate_process(NoiseGate* g, const float* in, const float* key, float* out, size_t n) {
+  float start[NOISE_GATE_CHUNK / SIMD_LANES];
+  float target[NOISE_GATE_CHUNK / SIMD_LANES];
+  const simde__m256 signMask = simde_mm256_set1_ps(-0.0f);
+  if (key == NULL) {
+    key = in;
+  }
+  for (size_t done = 0; done < n; done += NOISE_GATE_CHUNK) {
+    const size_t run = n - done < NOISE_GATE_CHUNK ? n - done : NOISE_GATE_CHUNK;
+    const float* k = key + done;
+
+    // decide every block's target first; a run that stays fully open needs no gain at all
+    int idle = 1;
+    for (size_t b = 0, i = 0; i < run; b++, i += SIMD_LANES) {
+      const size_t len = run - i < SIMD_LANES ? run - i : SIMD_LANES;
+      float peak = 0.0f;
+      if (len == SIMD_LANES) {
+        peak = simd_hmax(simde_mm256_andnot_ps(signMask, simde_mm256_loadu_ps(&k[i])));
+      } else {
+        for (size_t j = 0; j < len; j++) {
+          peak = fmaxf(peak, fabsf(k[i + j]));
+        }
+      }
+      g->env = fmaxf(peak, g->env * g->envDecay);
+      const int above = g->env > g->openLevel;
+      const int below = g->env < g->closeLevel;
+      g->hold = above ? g->holdBlocks : g->hold - (size_t)(below & (g->hold > 0));
+      g->open = above | (g->open & !(below & (g->hold == 0)));
+
+      const float t = g->open ? 1.0f : g->floorGain;
+      const float* pw = t > g->gain ? g->attackPow : g->releasePow;
+      start[b] = g->gain;
+      target[b] = t;
+      g->gain = t + (g->gain - t) * pw[len - 1];
+      // land exactly on the target, so a reopened gate gets back to the idle path
+      g->gain = fabsf(g->gain - t) < 1e-6f ? t : g->gain;
+      idle &= (start[b] == 1.0f) & (t == 1.0f);
+    }
+    if (idle) {
+      if (out != in) {
+        memmove(out + done, in + done, run * sizeof(float));
+      }
+      continue;
+    }
+
+    // gain at sample j of a block: t + (g0 - t) * keep^(j + 1), keep picked by direction
+    const simde__m256 attackPow = simde_mm256_loadu_ps(g->attackPow);
+    const simde__m256 releasePow = simde_mm256_loadu_ps(g->releasePow);
+    size_t b = 0;
+    size_t i = 0;
+    for (; i + SIMD_LANES <= run; b++, i += SIMD_LANES) {
+      const simde__m256 t = simde_mm256_set1_ps(target[b]);
+      const simde__m256 g0 = simde_mm256_set1_ps(start[b]);
+      const simde__m256 opening = simde_mm256_cmp_ps(t, g0, SIMDE_CMP_GT_OQ);
+      const simde__m256 pw = simde_mm256_blendv_ps(releasePow, attackPow, opening);
+      const simde__m256 gain = simde_mm256_add_ps(t, simde_mm256_mul_ps(simde_mm256_sub_ps(g0, t), pw));
+      simde_mm256_storeu_ps(&out[done + i], simde_mm256_mul_ps(simde_mm256_loadu_ps(&in[done + i]), gain));
+    }
+    if (i < run) {
+      const float* pw = target[b] > start[b] ? g->attackPow : g->releasePow;
+      for (size_t j = 0; i + j < run; j++) {
+        out[done + i + j] = in[done + i + j] * (target[b] + (start[b] - target[b]) * pw[j]);
+      }
+    }
+  }
+}
+
+void denormal_fix_inplace(float* buffer, size_t n) {
+  const float DENORMAL_THRESHOLD = 1.0e-24f;
+  for (size_t i = 0; i < n; i++) {
+    buffer[i] *= (fabsf(buffer[i]) >= DENORMAL_THRESHOLD);
+  }
+}
+
+float blackman_window_scalar(float w, size_t n) {
+  float N = (float)n;
+  const float alpha = 0.16f;
+  const float a0 = (1.0f - alpha) / 2.0f;
+  const float a1 = 0.5f;
+  const float a2 = alpha / 2.0f;
+  return a0 - a1 * cosf((2.0f * M_PI * w) / (N - 1)) + a2 * cosf((4.0f * M_PI * w) / (N - 1));
+}
+
+void build_blackman_window(float* w, size_t n) {
+  for (size_t i = 0; i < n; i++)
+  {
+    w[i] = blackman_window_scalar((float)i, n);
+  }
+}
+
+// B+ behind the plate load, and the pentode's screen supply
+#define TUBE_SUPPLY_V 300.0f
+// Koren's Kvb, which TubeParams doesn't carry: the 12AX7 fit's value for triodes, a typical
+// power pentode's for pentodes
+#define TUBE_TRIODE_KVB 300.0f
+#define TUBE_PENTODE_KVB 24.0f
+// bisection steps on the load line, enough to pin the plate voltage to a few microvolts
+#define TUBE_SOLVE_ITERATIONS 26
+// grid step for the small-signal gain used to normalise the tables
+#define TUBE_GAIN_STEP_V 0.01f
+
+// log(1 + e^x) without overflowing for large x
+static inline simde__m256 tube_softplus_ps(simde__m256 x) {
+  const simde__m256 absX = simde_mm256_andnot_ps(simde_mm256_set1_ps(-0.0f), x);
+  const simde__m256 tail = fast_exp_ps(simde_mm256_sub_ps(simde_mm256_setzero_ps(), absX), FAST_MATH_PRECISE);
+  const simde__m256 log1p = fast_log_ps(simde_mm256_add_ps(simde_mm256_set1_ps(1.0f), tail), FAST_MATH_PRECISE);
+  return simde_mm256_add_ps(simde_mm256_max_ps(x, simde_mm256_setzero_ps()), log1p);
+}
+
+// Koren plate current in amps at grid vg and plate vp, both relative to the cathode:
+//   triode  E1 = vp / Kp * log(1 + exp(Kp * (1 / mu + vg / sqrt(Kvb + vp^2))))
+//   pentode E1 = vs / Kp * log(1 + exp(Kp * (1 / mu + vg / vs))), times atan(vp / Kvb) below
+//   Ip = 2 * E1^Ex / Kg1
+static inline simde__m256 tube_plate_current_ps(simde__m256 vg, simde__m256 vp, TubeStageType type, const TubeParams* p) {
+  const simde__m256 kp = simde_mm256_set1_ps(p->k);
+  const simde__m256 invMu = simde_mm256_set1_ps(1.0f / p->mu);
+  simde__m256 ref;
+  if (type == TUBE_PENTODE) {
+    ref = simde_mm256_set1_ps(TUBE_SUPPLY_V);
+  } else {
+    ref = simde_mm256_sqrt_ps(simde_mm256_add_ps(simde_mm256_set1_ps(TUBE_TRIODE_KVB), simde_mm256_mul_ps(vp, vp)));
+  }
+  simde__m256 arg = simde_mm256_mul_ps(kp, simde_mm256_add_ps(invMu, simde_mm256_div_ps(vg, ref)));
+  simde__m256 e1 = simde_mm256_div_ps(simde_mm256_mul_ps(type == TUBE_PENTODE ? ref : vp, tube_softplus_ps(arg)), kp);
+  simde__m256 ip = fast_exp_ps(simde_mm256_mul_ps(simde_mm256_set1_ps(p->a), fast_log_ps(e1, FAST_MATH_PRECISE)), FAST_MATH_PRECISE);
+  // log clamps E1 = 0 to FLT_MIN, which would still leave a trickle of current
+  ip = simde_mm256_and_ps(ip, simde_mm256_cmp_ps(e1, simde_mm256_setzero_ps(), SIMDE_CMP_GT_OQ));
+  ip = simde_mm256_mul_ps(ip, simde_mm256_set1_ps(2.0f / p->Kg1));
+  if (type == TUBE_PENTODE) {
+    ip = simde_mm256_mul_ps(ip, fast_atan_ps(simde_mm256_div_ps(vp, simde_mm256_set1_ps(TUBE_PENTODE_KVB)), FAST_MATH_PRECISE));
+  }
+  return ip;
+}
+
+// Plate voltage where vp + Rp * Ip(vg, vp) = B+. The left side rises with vp and brackets B+
+// between 0 and B+, so bisection converges for any parameters without a branch.
+static simde__m256 tube_plate_voltage_ps(simde__m256 vg, TubeStageType type, const TubeParams* p) {
+  const simde__m256 supply = simde_mm256_set1_ps(TUBE_SUPPLY_V);
+  const simde__m256 rp = simde_mm256_set1_ps(p->Rp);
+  simde__m256 lo = simde_mm256_setzero_ps();
+  simde__m256 hi = supply;
+  for (int i = 0; i < TUBE_SOLVE_ITERATIONS; i++) {
+    simde__m256 mid = simde_mm256_mul_ps(simde_mm256_set1_ps(0.5f), simde_mm256_add_ps(lo, hi));
+    simde__m256 f = simde_mm256_add_ps(mid, simde_mm256_mul_ps(rp, tube_plate_current_ps(vg, mid, type, p)));
+    simde__m256 over = simde_mm256_cmp_ps(f, supply, SIMDE_CMP_GT_OQ);
+    hi = simde_mm256_blendv_ps(hi, mid, over);
+    lo = simde_mm256_blendv_ps(mid, lo, over);
+  }
+  return simde_mm256_mul_ps(simde_mm256_set1_ps(0.5f), simde_mm256_add_ps(lo, hi));
+}
+
+static void build_koren_table(float* table, size_t tableSize, TubeStageType type, const TubeParams* params, float vMin, float vMax) {
+  if (tableSize < 2) {
+    return;
+  }
+  const float bias = params->biasV;
+  // quiescent plate voltage and the gain around it
+  float probe[SIMD_LANES] = { bias, bias - TUBE_GAIN_STEP_V, bias + TUBE_GAIN_STEP_V };
+  float plate[SIMD_LANES];
+  simde_mm256_storeu_ps(plate, tube_plate_voltage_ps(simde_mm256_loadu_ps(probe), type, params));
+  const float quiescent = plate[0];
+  float gain = (plate[1] - plate[2]) / (2.0f * TUBE_GAIN_STEP_V);
+  if (!(gain > 1e-6f)) {
+    log_message(LOG_LEVEL_WARN, "Tube stage has no gain at a %.2f V bias, table left unnormalised", bias);
+    gain = 1.0f;
+  }
+
+  const float step = (vMax - vMin) / (float)(tableSize - 1);
+  const simde__m256 ramp = simde_mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+  const simde__m256 vQuiescent = simde_mm256_set1_ps(quiescent);
+  const simde__m256 invGain = simde_mm256_set1_ps(1.0f / gain);
+  for (size_t i = 0; i < tableSize; i += SIMD_LANES) {
+    simde__m256 index = simde_mm256_add_ps(simde_mm256_set1_ps((float)i), ramp);
+    simde__m256 vg = simde_mm256_add_ps(simde_mm256_set1_ps(vMin + bias), simde_mm256_mul_ps(index, simde_mm256_set1_ps(step)));
+    simde__m256 vp = tube_plate_voltage_ps(vg, type, params);
+    simde__m256 y = simde_mm256_mul_ps(simde_mm256_sub_ps(vQuiescent, vp), invGain);
+    if (i + SIMD_LANES <= tableSize) {
+      simde_mm256_storeu_ps(&table[i], y);
+    } else {
+      float tail[SIMD_LANES];
+      simde_mm256_storeu_ps(tail, y);
+      memcpy(&table[i], tail, (tableSize - i) * sizeof(float));
+    }
+  }
+}
+
+void build_triode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax) {
+  build_koren_table(table, tableSize, TUBE_TRIODE, params, vMin, vMax);
+}
+
+void build_pentode_table(float* table, size_t tableSize, const TubeParams* params, float vMin, float vMax) {
+  build_koren_table(table, tableSize, TUBE_PENTODE, params, vMin, vMax);
+}
+
+void build_tube_table_from_koren(float* table, size_t tableSize, TubeStageType type, const TubeParams* params, float vMin, float vMax) {
+  build_koren_table(table, tableSize, type, params, vMin, vMax);
+}
+
+// Keyed, refcounted cache of read-only float arrays built on a miss, shared by the tube tables
+// and the tone stack surfaces. Keys are compared bytewise, so callers zero a key before filling
+// it in. A miss takes a free slot, or else the least recently used one nothing references.
+#define SHARED_CACHE_KEY_BYTES 64
+
+typedef struct {
+  unsigned char key[SHARED_CACHE_KEY_BYTES];
+  float* data;         // NULL for a free slot
+  size_t refs;
+  uint64_t lastUse;
+} SharedCacheSlot;
+
+typedef struct {
+  SharedCacheSlot* slots;
+  size_t numSlots;
+  uint64_t clock;
+  pthread_mutex_t lock;
+  const char* name;    // for log messages
+} SharedCache;
+
+typedef void (*SharedCacheBuild)(float* data, const void* key);
+
+static const float* shared_cache_acquire(SharedCache* cache, const void* key, size_t keyBytes, size_t length, SharedCacheBuild build) {
+  if (keyBytes > SHARED_CACHE_KEY_BYTES) {
+    log_message(LOG_LEVEL_ERROR, "%s cache key of %zu bytes, at most %d fit", cache->name, keyBytes, SHARED_CACHE_KEY_BYTES);
+    return NULL;
+  }
+  pthread_mutex_lock(&cache->lock);
+  SharedCacheSlot* victim = NULL;
+  for (size_t i = 0; i < cache->numSlots; i++) {
+    SharedCacheSlot* slot = &cache->slots[i];
+    if (slot->data != NULL && memcmp(slot->key, key, keyBytes) == 0) {
+      slot->refs++;
+      slot->lastUse = ++cache->clock;
+      pthread_mutex_unlock(&cache->lock);
+      return slot->data;
+    }
+    if (slot->refs == 0 && (victim == NULL || slot->data == NULL || (victim->data != NULL && slot->lastUse < victim->lastUse))) {
+      victim = slot;
+    }
+  }
+  if (victim == NULL) {
+    pthread_mutex_unlock(&cache->lock);
+    log_message(LOG_LEVEL_ERROR, "%s cache full, all %zu entries in use", cache->name, cache->numSlots);
+    return NULL;
+  }
+
+  float* data = malloc(length * sizeof(float));
+  if (data == NULL) {
+    pthread_mutex_unlock(&cache->lock);
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate %s cache entry", cache->name);
+    return NULL;
+  }
+  build(data, key);
+  free(victim->data);
+  memcpy(victim->key, key, keyBytes);
+  victim->data = data;
+  victim->refs = 1;
+  victim->lastUse = ++cache->clock;
+  pthread_mutex_unlock(&cache->lock);
+  return data;
+}
+
+static void shared_cache_release(SharedCache* cache, const float* data) {
+  if (data == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&cache->lock);
+  for (size_t i = 0; i < cache->numSlots; i++) {
+    SharedCacheSlot* slot = &cache->slots[i];
+    if (slot->data == data && slot->refs > 0) {
+      slot->refs--;
+      break;
+    }
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
+
+typedef struct {
+  TubeStageType type;
+  TubeParams params;
+  float vMin;
+  float vMax;
+  size_t tableSize;
+} TubeTableKey;
+
+static SharedCacheSlot tubeTableSlots[TUBE_TABLE_CACHE_SLOTS];
+static SharedCache tubeTableCache = { tubeTableSlots, TUBE_TABLE_CACHE_SLOTS, 0, PTHREAD_MUTEX_INITIALIZER, "Tube table" };
+
+static void tube_table_build(float* table, const void* key) {
+  const TubeTableKey* k = key;
+  build_koren_table(table, k->tableSize, k->type, &k->params, k->vMin, k->vMax);
+}
+
+const float* tube_table_acquire(TubeStageType type, const TubeParams* params, float vMin, float vMax, size_t tableSize) {
+  TubeTableKey key;
+  memset(&key, 0, sizeof(key));
+  key.type = type;
+  key.params = *params;
+  key.vMin = vMin;
+  key.vMax = vMax;
+  key.tableSize = tableSize;
+  return shared_cache_acquire(&tubeTableCache, &key, sizeof(key), tableSize, tube_table_build);
+}
+
+void tube_table_release(const float* table) {
+  shared_cache_release(&tubeTableCache, table);
+}
+
+// Parts of the TMB network: R1 treble pot, R2 bass pot, R3 mid pot, R4 slope resistor, C1 treble
+// cap, C2 bass cap, C3 mid cap. The Vox values put its cut-style stack on the same topology.
+typedef struct {
+  double r1, r2, r3, r4;
+  double c1, c2, c3;
+} ToneStackParts;
+
+static const ToneStackParts toneStackParts[] = {
+  [TONE_STACK_FENDER] = { 250e3, 1e6, 25e3, 56e3, 250e-12, 20e-9, 20e-9 },
+  [TONE_STACK_MARSHALL] = { 220e3, 1e6, 22e3, 33e3, 470e-12, 22e-9, 22e-9 },
+  [TONE_STACK_VOX] = { 1e6, 1e6, 10e3, 100e3, 50e-12, 22e-9, 22e-9 },
+};
+
+// log frequencies the noon response is searched for its peak
+#define TONE_STACK_PEAK_POINTS 64
+
+// 10% of the track at half rotation, the usual audio taper
+static double tone_stack_bass_taper(double knob) {
+  return (pow(10.0, 2.0 * knob) - 1.0) / 99.0;
+}
+
+// H(s) = (b1 s + b2 s^2 + b3 s^3) / (1 + a1 s + a2 s^2 + a3 s^3) at pot positions t, m, l
+static void tone_stack_analog(const ToneStackParts* p, double t, double m, double l, double b[4], double a[4]) {
+  const double r1 = p->r1, r2 = p->r2, r3 = p->r3, r4 = p->r4;
+  const double c1 = p->c1, c2 = p->c2, c3 = p->c3;
+  const double c123 = c1 * c2 * c3;
+  b[0] = 0.0;
+  b[1] = t * c1 * r1 + m * c3 * r3 + l * (c1 * r2 + c2 * r2) + (c1 * r3 + c2 * r3);
+  b[2] = t * (c1 * c2 * r1 * r4 + c1 * c3 * r1 * r4) - m * m * (c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3) +
+         m * (c1 * c3 * r1 * r3 + c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3) + l * (c1 * c2 * r1 * r2 + c1 * c2 * r2 * r4 + c1 * c3 * r2 * r4) +
+         l * m * (c1 * c3 * r2 * r3 + c2 * c3 * r2 * r3) + (c1 * c2 * r1 * r3 + c1 * c2 * r3 * r4 + c1 * c3 * r3 * r4);
+  b[3] = l * m * c123 * (r1 * r2 * r3 + r2 * r3 * r4) - m * m * c123 * (r1 * r3 * r3 + r3 * r3 * r4) + m * c123 * (r1 * r3 * r3 + r3 * r3 * r4) +
+         t * c123 * r1 * r3 * r4 - t * m * c123 * r1 * r3 * r4 + t * l * c123 * r1 * r2 * r4;
+  a[0] = 1.0;
+  a[1] = (c1 * r1 + c1 * r3 + c2 * r3 + c2 * r4 + c3 * r4) + m * c3 * r3 + l * (c1 * r2 + c2 * r2);
+  a[2] = m * (c1 * c3 * r1 * r3 - c2 * c3 * r3 * r4 + c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3) + l * m * (c1 * c3 * r2 * r3 + c2 * c3 * r2 * r3) -
+         m * m * (c1 * c3 * r3 * r3 + c2 * c3 * r3 * r3) + l * (c1 * c2 * r2 * r4 + c1 * c2 * r1 * r2 + c1 * c3 * r2 * r4 + c2 * c3 * r2 * r4) +
+         (c1 * c2 * r1 * r4 + c1 * c3 * r1 * r4 + c1 * c2 * r3 * r4 + c1 * c2 * r1 * r3 + c1 * c3 * r3 * r4 + c2 * c3 * r3 * r4);
+  a[3] = l * m * c123 * (r1 * r2 * r3 + r2 * r3 * r4) - m * m * c123 * (r1 * r3 * r3 + r3 * r3 * r4) + m * c123 * (r3 * r3 * r4 + r1 * r3 * r3 - r1 * r3 * r4) +
+         l * c123 * r1 * r2 * r4 + c123 * r1 * r3 * r4;
+}
+
+static double tone_stack_analog_magnitude(const double b[4], const double a[4], double w) {
+  // s = jw: even powers are real, odd imaginary
+  const double numRe = b[0] - b[2] * w * w;
+  const double numIm = b[1] * w - b[3] * w * w * w;
+  const double denRe = a[0] - a[2] * w * w;
+  const double denIm = a[1] * w - a[3] * w * w * w;
+  return sqrt((numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm));
+}
+
+// The one root of 1 + a1 s + a2 s^2 + a3 s^3 nearest zero. An RC network's poles are real and
+// negative, and Newton from the right of every root of a real-rooted polynomial walks
+// monotonically onto the rightmost one.
+static double tone_stack_lowest_pole(const double a[4]) {
+  double s = 0.0;
+  for (int i = 0; i < 100; i++) {
+    double f = a[0] + s * (a[1] + s * (a[2] + s * a[3]));
+    double df = a[1] + s * (2.0 * a[2] + s * 3.0 * a[3]);
+    double step = f / df;
+    s -= step;
+    if (fabs(step) <= 1e-12 * fabs(s)) {
+      break;
+    }
+  }
+  return s;
+}
+
+// Bilinear transform, unwarped, as s / (s - p) times (b1 + b2 s + b3 s^2) / (q0 + q1 s + a3 s^2)
+// with p the lowest pole; out gets the layout of TONE_STACK_COEFFS
+static void tone_stack_digital(const double b[4], const double a[4], double sampleRate, double gain, float* out) {
+  const double c = 2.0 * sampleRate;
+  const double c2 = c * c;
+  const double p = tone_stack_lowest_pole(a);
+  // deflate: 1 + a1 s + a2 s^2 + a3 s^3 = (s - p)(q0 + q1 s + a3 s^2)
+  const double q0 = -a[0] / p;
+  const double q1 = a[2] + p * a[3];
+
+  // the DC zero goes with the low pole: a high-pass with unity gain at Nyquist
+  out[0] = (float)(c / (c - p));
+  out[1] = (float)(-c / (c - p));
+  out[2] = (float)(-(c + p) / (c - p));
+
+  const double n0 = b[1] + b[2] * c + b[3] * c2;
+  const double n1 = 2.0 * b[1] - 2.0 * b[3] * c2;
+  const double n2 = b[1] - b[2] * c + b[3] * c2;
+  const double d0 = q0 + q1 * c + a[3] * c2;
+  const double d1 = 2.0 * q0 - 2.0 * a[3] * c2;
+  const double d2 = q0 - q1 * c + a[3] * c2;
+  out[3] = (float)(gain * n0 / d0);
+  out[4] = (float)(gain * n1 / d0);
+  out[5] = (float)(gain * n2 / d0);
+  out[6] = (float)(d1 / d0);
+  out[7] = (float)(d2 / d0);
+}
+
+static void build_tone_stack_surface(float* surface, ToneStackType type, float sampleRate) {
+  const ToneStackParts* parts = &toneStackParts[type];
+  double b[4];
+  double a[4];
+
+  tone_stack_analog(parts, 0.5, 0.5, tone_stack_bass_taper(0.5), b, a);
+  double peak = 0.0;
+  for (size_t i = 0; i < TONE_STACK_PEAK_POINTS; i++) {
+    double hz = 20.0 * pow(1000.0, (double)i / (TONE_STACK_PEAK_POINTS - 1));
+    peak = fmax(peak, tone_stack_analog_magnitude(b, a, 2.0 * M_PI * hz));
+  }
+  const double gain = peak > 0.0 ? 1.0 / peak : 1.0;
+
+  const double step = 1.0 / (TONE_STACK_GRID - 1);
+  float* point = surface;
+  for (size_t t = 0; t < TONE_STACK_GRID; t++) {
+    for (size_t m = 0; m < TONE_STACK_GRID; m++) {
+      for (size_t l = 0; l < TONE_STACK_GRID; l++) {
+        tone_stack_analog(parts, (double)t * step, (double)m * step, tone_stack_bass_taper((double)l * step), b, a);
+        tone_stack_digital(b, a, sampleRate, gain, point);
+        point += TONE_STACK_COEFFS;
+      }
+    }
+  }
+}
+
+typedef struct {
+  ToneStackType type;
+  float sampleRate;
+} ToneStackKey;
+
+static SharedCacheSlot toneStackSlots[TONE_STACK_CACHE_SLOTS];
+static SharedCache toneStackCache = { toneStackSlots, TONE_STACK_CACHE_SLOTS, 0, PTHREAD_MUTEX_INITIALIZER, "Tone stack" };
+
+static void tone_stack_build(float* surface, const void* key) {
+  const ToneStackKey* k = key;
+  build_tone_stack_surface(surface, k->type, k->sampleRate);
+}
+
+const float* tone_stack_surface_acquire(ToneStackType type, float sampleRate) {
+  if ((int)type < TONE_STACK_FENDER || type > TONE_STACK_VOX) {
+    log_message(LOG_LEVEL_ERROR, "Unknown tone stack type %d", (int)type);
+    return NULL;
+  }
+  ToneStackKey key;
+  memset(&key, 0, sizeof(key));
+  key.type = type;
+  key.sampleRate = sampleRate;
+  return shared_cache_acquire(&toneStackCache, &key, sizeof(key), TONE_STACK_GRID * TONE_STACK_GRID * TONE_STACK_GRID * TONE_STACK_COEFFS, tone_stack_build);
+}
+
+void tone_stack_surface_release(const float* surface) {
+  shared_cache_release(&toneStackCache, surface);
+}
+
+static void tone_stack_process_scalar(ToneStack* ts, const float* in, float* out, size_t numSamples) {
+  onepole_process(&ts->low, in, out, numSamples);
+  biquad_process(&ts->body, out, out, numSamples);
+}
+
+// Like the other block kernels, built by running the scalar path on unit inputs and states. The
+// states carried out of a block come from a matrix too: with two sections in series there is no
+// replaying them from the block's edge samples.
+static void tone_stack_block_prepare(ToneStack* ts) {
+  float impulse[SIMD_LANES] = {1.0f};
+  float zeros[SIMD_LANES] = {0};
+  float scratch[SIMD_LANES];
+  ToneStack probe = *ts;
+
+  probe.low.z1 = probe.body.z1 = probe.body.z2 = 0.0f;
+  tone_stack_process_scalar(&probe, impulse, impulse, SIMD_LANES);
+  iir_block_fill_toeplitz(&ts->block, impulse);
+
+  for (size_t k = 0; k < SIMD_LANES + 3; k++) {
+    float x[SIMD_LANES] = {0};
+    if (k < SIMD_LANES) {
+      x[k] = 1.0f;
+    }
+    probe.low.z1 = k == SIMD_LANES ? 1.0f : 0.0f;
+    probe.body.z1 = k == SIMD_LANES + 1 ? 1.0f : 0.0f;
+    probe.body.z2 = k == SIMD_LANES + 2 ? 1.0f : 0.0f;
+    tone_stack_process_scalar(&probe, k < SIMD_LANES ? x : zeros, k < SIMD_LANES ? scratch : ts->block.c[k - SIMD_LANES], SIMD_LANES);
+    memset(ts->carry[k], 0, sizeof(ts->carry[k]));
+    ts->carry[k][0] = probe.low.z1;
+    ts->carry[k][1] = probe.body.z1;
+    ts->carry[k][2] = probe.body.z2;
+  }
+}
+
+int tone_stack_init(ToneStack* ts, ToneStackType type, float sampleRate) {
+  memset(ts, 0, sizeof(*ts));
+  ts->surface = tone_stack_surface_acquire(type, sampleRate);
+  if (ts->surface == NULL) {
+    return -1;
+  }
+  tone_stack_set_knobs(ts, 0.5f, 0.5f, 0.5f);
+  return 0;
+}
+
+void tone_stack_free(ToneStack* ts) {
+  tone_stack_surface_release(ts->surface);
+  ts->surface = NULL;
+}
+
+void tone_stack_reset(ToneStack* ts) {
+  ts->low.z1 = 0.0f;
+  ts->body.z1 = ts->body.z2 = 0.0f;
+}
+
+void tone_stack_set_knobs(ToneStack* ts, float treble, float mid, float bass) {
+  const float knobs[3] = { treble, mid, bass };
+  size_t cell[3];
+  float frac[3];
+  for (size_t k = 0; k < 3; k++) {
+    float x = clampf(knobs[k], 0.0f, 1.0f) * (float)(TONE_STACK_GRID - 1);
+    cell[k] = (size_t)x < TONE_STACK_GRID - 2 ? (size_t)x : TONE_STACK_GRID - 2;
+    frac[k] = x - (float)cell[k];
+  }
+
+  // trilinear over the cell's eight corners, all eight coefficients per lane
+  simde__m256 acc = simde_mm256_setzero_ps();
+  for (size_t corner = 0; corner < 8; corner++) {
+    const size_t dt = (corner >> 2) & 1, dm = (corner >> 1) & 1, dl = corner & 1;
+    const float w = (dt ? frac[0] : 1.0f - frac[0]) * (dm ? frac[1] : 1.0f - frac[1]) * (dl ? frac[2] : 1.0f - frac[2]);
+    const size_t index = ((cell[0] + dt) * TONE_STACK_GRID + cell[1] + dm) * TONE_STACK_GRID + cell[2] + dl;
+    acc = simde_mm256_add_ps(acc, simde_mm256_mul_ps(simde_mm256_set1_ps(w), simde_mm256_loadu_ps(&ts->surface[index * TONE_STACK_COEFFS])));
+  }
+  float c[TONE_STACK_COEFFS];
+  simde_mm256_storeu_ps(c, acc);
+  ts->low.b0 = c[0];
+  ts->low.b1 = c[1];
+  ts->low.a0 = c[2];
+  ts->body.b0 = c[3];
+  ts->body.b1 = c[4];
+  ts->body.b2 = c[5];
+  ts->body.a1 = c[6];
+  ts->body.a2 = c[7];
+  tone_stack_block_prepare(ts);
+}
+
+void tone_stack_process(ToneStack* ts, const float* in, float* out, size_t numSamples) {
+  const simde__m256 c2 = simde_mm256_loadu_ps(ts->block.c[2]);
+  float state[SIMD_LANES] = { ts->low.z1, ts->body.z1, ts->body.z2 };
+  size_t n = 0;
+
+  for (; n + SIMD_LANES <= numSamples; n += SIMD_LANES) {
+    simde__m256 next = simde_mm256_add_ps(
+      simde_mm256_add_ps(simde_mm256_mul_ps(simde_mm256_set1_ps(state[0]), simde_mm256_loadu_ps(ts->carry[SIMD_LANES])),
+                         simde_mm256_mul_ps(simde_mm256_set1_ps(state[1]), simde_mm256_loadu_ps(ts->carry[SIMD_LANES + 1]))),
+      simde_mm256_mul_ps(simde_mm256_set1_ps(state[2]), simde_mm256_loadu_ps(ts->carry[SIMD_LANES + 2])));
+    for (size_t j = 0; j < SIMD_LANES; j++) {
+      next = simde_mm256_add_ps(next, simde_mm256_mul_ps(simde_mm256_set1_ps(in[n + j]), simde_mm256_loadu_ps(ts->carry[j])));
+    }
+    // the carried states are taken before the store, in and out may alias
+    simde__m256 y = iir_block_response(&ts->block, &in[n], state[0], state[1]);
+    y = simde_mm256_add_ps(y, simde_mm256_mul_ps(simde_mm256_set1_ps(state[2]), c2));
+    simde_mm256_storeu_ps(&out[n], y);
+    simde_mm256_storeu_ps(state, next);
+  }
+
+  ts->low.z1 = state[0];
+  ts->body.z1 = state[1];
+  ts->body.z2 = state[2];
+  if (n < numSamples) {
+    tone_stack_process_scalar(ts, &in[n], &out[n], numSamples - n);
+  } else {
+    if (fabsf(ts->low.z1) < 1.0e-15f) ts->low.z1 = 0.0f;
+    if (fabsf(ts->body.z1) < 1.0e-15f) ts->body.z1 = 0.0f;
+    if (fabsf(ts->body.z2) < 1.0e-15f) ts->body.z2 = 0.0f;
+  }
+}
+
+// centre delays, swing, pans and LFO rates from the voice count, knobs and sample rate
+static void chorus_update_voices(Chorus* c) {
+  const float msToSamples = 0.001f * c->sampleRate;
+  const float level = 1.0f / sqrtf((float)c->voices);
+  for (size_t v = 0; v < SIMD_LANES; v++) {
+    c->centre[v] = CHORUS_BASE_DELAY_MS * (1.0f + CHORUS_VOICE_STAGGER * (float)v) * msToSamples;
+    if (v >= c->voices) {
+      c->gainL[v] = c->gainR[v] = c->gainMono[v] = 0.0f;
+      c->stepCos[v] = 1.0f;
+      c->stepSin[v] = 0.0f;
+      continue;
+    }
+    // -1 for the first voice to 1 for the last
+    const float place = 2.0f * (float)v / (float)(c->voices - 1) - 1.0f;
+    const float angle = (c->spread * place + 1.0f) * (float)M_PI * 0.25f;
+    c->gainL[v] = cosf(angle) * level;
+    c->gainR[v] = sinf(angle) * level;
+    c->gainMono[v] = (c->gainL[v] + c->gainR[v]) * (float)M_SQRT1_2;
+    const float w = 2.0f * (float)M_PI * c->rate * (1.0f + 0.5f * CHORUS_RATE_SPREAD * place) / c->sampleRate;
+    c->stepCos[v] = cosf(w);
+    c->stepSin[v] = sinf(w);
+  }
+  c->swing = c->depth * CHORUS_MAX_SWING_MS * msToSamples;
+}
+
+int chorus_init(Chorus* c, float sampleRate) {
+  memset(c, 0, sizeof(*c));
+  c->sampleRate = sampleRate;
+  // the outermost voice at full swing, plus one chunk read back
+  const float longestMs = CHORUS_BASE_DELAY_MS * (1.0f + CHORUS_VOICE_STAGGER * (CHORUS_MAX_VOICES - 1)) + CHORUS_MAX_SWING_MS;
+  size_t reach = (size_t)ceilf(longestMs * 0.001f * sampleRate) + CHORUS_CHUNK + DELAYLINE_GUARD;
+  c->memory = malloc(delayline_pow2_buffer_size(reach) * sizeof(float));
+  if (c->memory == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate chorus delay line");
+    return -1;
+  }
+  delayline_init_pow2(&c->line, c->memory, reach, sampleRate);
+  c->rate = 0.8f;
+  c->depth = 0.5f;
+  c->mix = 0.5f;
+  c->spread = 1.0f;
+  c->lfoCos[0] = 1.0f;
+  chorus_set_voices(c, 3);
+  return 0;
+}
+
+void chorus_free(Chorus* c) {
+  free(c->memory);
+  c->memory = NULL;
+  c->line.buffer = NULL;
+}
+
+void chorus_reset(Chorus* c) {
+  if (c->memory != NULL) {
+    memset(c->memory, 0, delayline_pow2_buffer_size(c->line.size) * sizeof(float));
+  }
+  c->line.writeIndex = 0;
+}
+
+void chorus_set_voices(Chorus* c, size_t voices) {
+  voices = voices < 2 ? 2 : voices > CHORUS_MAX_VOICES ? CHORUS_MAX_VOICES : voices;
+  const float start = atan2f(c->lfoSin[0], c->lfoCos[0]);
+  for (size_t v = 0; v < SIMD_LANES; v++) {
+    const float phase = start + 2.0f * (float)M_PI * (float)v / (float)voices;
+    c->lfoCos[v] = cosf(phase);
+    c->lfoSin[v] = sinf(phase);
+  }
+  c->voices = voices;
+  chorus_update_voices(c);
+}
+
+void chorus_set_params(Chorus* c, float rateHz, float depth, float mix, float spread) {
+  rateHz = clampf(rateHz, 0.0f, 20.0f);
+  depth = clampf(depth, 0.0f, 1.0f);
+  spread = clampf(spread, 0.0f, 1.0f);
+  c->mix = clampf(mix, 0.0f, 1.0f);
+  if (rateHz != c->rate || depth != c->depth || spread != c->spread) {
+    c->rate = rateHz;
+    c->depth = depth;
+    c->spread = spread;
+    chorus_update_voices(c);
+  }
+}
+
+// out[k] = the horizontal sum of v[k]
+static inline simde__m256 chorus_sum_lanes(const simde__m256 v[SIMD_LANES]) {
+  simde__m256 h0123 = simde_mm256_hadd_ps(simde_mm256_hadd_ps(v[0], v[1]), simde_mm256_hadd_ps(v[2], v[3]));
+  simde__m256 h4567 = simde_mm256_hadd_ps(simde_mm256_hadd_ps(v[4], v[5]), simde_mm256_hadd_ps(v[6], v[7]));
+  return simde_mm256_add_ps(simde_mm256_permute2f128_ps(h0123, h4567, 0x20), simde_mm256_permute2f128_ps(h0123, h4567, 0x31));
+}
+
+void chorus_process(Chorus* c, const float* in, float* left, float* right, size_t n) {
+  if (c->memory == NULL) {
+    return;
+  }
+  const float* buffer = c->line.buffer;
+  const simde__m256i vMask = simde_mm256_set1_epi32((int32_t)c->line.mask);
+  const simde__m256 centre = simde_mm256_loadu_ps(c->centre);
+  const simde__m256 swing = simde_mm256_set1_ps(c->swing);
+  const simde__m256 stepCos = simde_mm256_loadu_ps(c->stepCos);
+  const simde__m256 stepSin = simde_mm256_loadu_ps(c->stepSin);
+  const simde__m256 gainL = simde_mm256_loadu_ps(right != NULL ? c->gainL : c->gainMono);
+  const simde__m256 gainR = simde_mm256_loadu_ps(c->gainR);
+  const simde__m256 dry = simde_mm256_set1_ps(1.0f - c->mix);
+  const simde__m256 wet = simde_mm256_set1_ps(c->mix);
+  simde__m256 lfoCos = simde_mm256_loadu_ps(c->lfoCos);
+  simde__m256 lfoSin = simde_mm256_loadu_ps(c->lfoSin);
+
+  for (size_t done = 0; done < n; done += CHORUS_CHUNK) {
+    const size_t run = n - done < CHORUS_CHUNK ? n - done : CHORUS_CHUNK;
+    delayline_write(&c->line, in + done, run);
+    // taps start one sample before the read point, as in delayline_read_modulated
+    const simde__m256i vBase = simde_mm256_set1_epi32((int32_t)((c->line.writeIndex - run) & c->line.mask) - 1);
+
+    for (size_t i = 0; i < run; i += SIMD_LANES) {
+      const size_t m = run - i < SIMD_LANES ? run - i : SIMD_LANES;
+      simde__m256 accL[SIMD_LANES];
+      simde__m256 accR[SIMD_LANES];
+      for (size_t k = 0; k < SIMD_LANES; k++) {
+        if (k >= m) {
+          accL[k] = accR[k] = simde_mm256_setzero_ps();
+          continue;
+        }
+        // one sample, every voice: lane v reads voice v's delay
+        simde__m256 d = simde_mm256_add_ps(centre, simde_mm256_mul_ps(swing, lfoSin));
+        simde__m256 pos = simde_mm256_sub_ps(simde_mm256_set1_ps((float)(i + k)), d);
+        simde__m256 whole = simde_mm256_floor_ps(pos);
+        simde__m256 t = simde_mm256_sub_ps(pos, whole);
+        simde__m256i idx = simde_mm256_and_si256(simde_mm256_add_epi32(vBase, simde_mm256_cvtps_epi32(whole)), vMask);
+        simde__m256 y = cubic_interp_simd(simde_mm256_i32gather_ps(buffer, idx, 4), simde_mm256_i32gather_ps(buffer + 1, idx, 4),
+                                          simde_mm256_i32gather_ps(buffer + 2, idx, 4), simde_mm256_i32gather_ps(buffer + 3, idx, 4), t);
+        accL[k] = simde_mm256_mul_ps(y, gainL);
+        accR[k] = simde_mm256_mul_ps(y, gainR);
+
+        simde__m256 nextCos = simde_mm256_sub_ps(simde_mm256_mul_ps(lfoCos, stepCos), simde_mm256_mul_ps(lfoSin, stepSin));
+        lfoSin = simde_mm256_add_ps(simde_mm256_mul_ps(lfoSin, stepCos), simde_mm256_mul_ps(lfoCos, stepSin));
+        lfoCos = nextCos;
+      }
+      float sumL[SIMD_LANES];
+      float sumR[SIMD_LANES];
+      simde_mm256_storeu_ps(sumL, chorus_sum_lanes(accL));
+      simde_mm256_storeu_ps(sumR, chorus_sum_lanes(accR));
+      memcpy(&c->wetL[i], sumL, m * sizeof(float));
+      memcpy(&c->wetR[i], sumR, m * sizeof(float));
+    }
+
+    // in may alias an output, so each block of it is loaded before either store
+    const float* x = in + done;
+    float* l = left + done;
+    float* r = right != NULL ? right + done : NULL;
+    size_t i = 0;
+    for (; i + SIMD_LANES <= run; i += SIMD_LANES) {
+      simde__m256 dryPart = simde_mm256_mul_ps(dry, simde_mm256_loadu_ps(&x[i]));
+      simde__m256 outL = simde_mm256_add_ps(dryPart, simde_mm256_mul_ps(wet, simde_mm256_loadu_ps(&c->wetL[i])));
+      if (r != NULL) {
+        simde_mm256_storeu_ps(&r[i], simde_mm256_add_ps(dryPart, simde_mm256_mul_ps(wet, simde_mm256_loadu_ps(&c->wetR[i]))));
+      }
+      simde_mm256_storeu_ps(&l[i], outL);
+    }
+    for (; i < run; i++) {
+      float dryPart = (1.0f - c->mix) * x[i];
+      if (r != NULL) {
+        r[i] = dryPart + c->mix * c->wetR[i];
+      }
+      l[i] = dryPart + c->mix * c->wetL[i];
+    }
+
+    // keep the phasors on the unit circle against rounding drift
+    simde__m256 norm = simde_mm256_add_ps(simde_mm256_mul_ps(lfoCos, lfoCos), simde_mm256_mul_ps(lfoSin, lfoSin));
+    norm = simde_mm256_sub_ps(simde_mm256_set1_ps(1.5f), simde_mm256_mul_ps(simde_mm256_set1_ps(0.5f), norm));
+    lfoCos = simde_mm256_mul_ps(lfoCos, norm);
+    lfoSin = simde_mm256_mul_ps(lfoSin, norm);
+  }
+  simde_mm256_storeu_ps(c->lfoCos, lfoCos);
+  simde_mm256_storeu_ps(c->lfoSin, lfoSin);
+}
+
+void normalize_ir(float* ir, size_t n, float targetRMS) {
+  if (n == 0) {
+    return;
+  }
+  simde__m256 acc = simde_mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde__m256 x = simde_mm256_loadu_ps(&ir[i]);
+    acc = simde_mm256_add_ps(acc, simde_mm256_mul_ps(x, x));
+  }
+  float energy = simd_hsum(acc);
+  for (; i < n; i++) {
+    energy += ir[i] * ir[i];
+  }
+  float rms = sqrtf(energy / (float)n);
+  if (rms < EPSILON_F) {
+    log_message(LOG_LEVEL_WARN, "Impulse response is silent, not normalising");
+    return;
+  }
+  const float scale = targetRMS / rms;
+  const simde__m256 vScale = simde_mm256_set1_ps(scale);
+  for (i = 0; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde_mm256_storeu_ps(&ir[i], simde_mm256_mul_ps(simde_mm256_loadu_ps(&ir[i]), vScale));
+  }
+  for (; i < n; i++) {
+    ir[i] *= scale;
+  }
+}
@@ -1 +1,763 @@
-#include <effects_interface.h>
\ No newline at end of file
+#include <effects_interface.h>
+#include <amp.h>
+#include <long_convolver.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// ---------------------------------------------------------------------------------------------
+// Cabinet simulation
+// ---------------------------------------------------------------------------------------------
+
+#define CAB_BLOCK_SIZE 64
+#define CAB_IR_LENGTH 4096
+#define CAB_NUM_MICS (MIC_TYPE_RIBBON_R122 + 1)
+#define CAB_NUM_POSITIONS (MIC_POSITION_OFF_AXIS_90 + 1)
+#define CAB_CHUNK 256
+#define CAB_NUM_REFLECTIONS 4
+#define CAB_ROOM_DELAY_SIZE 2048
+
+// IR spectra for every mic / position are built with the rest of the state and kept for the life
+// of the process, so switching mics is a pointer swap
+static ConvolverIR cabIRCache[CAB_NUM_MICS][CAB_NUM_POSITIONS];
+static int cabIRReady;
+
+typedef struct {
+  int initialized;
+  Convolver convolver;
+  Biquad proximity;
+  float proximityDb;
+  DelayLine room;
+  float roomMemory[CAB_ROOM_DELAY_SIZE + DELAYLINE_GUARD];
+} CabinetState;
+
+static CabinetState cabState;
+
+// A synthetic 4x12 closed-back response: an impulse plus a few ms of decaying noise for cone
+// breakup, shaped by the cabinet, the speaker and then the mic's voicing and axis
+static void cab_build_ir(float* ir, size_t n, MicType mic, MicPosition position) {
+  const float fs = EFFECTS_SAMPLE_RATE;
+  NoiseGen noise;
+  noise_seed(&noise, 0xCAB);
+  white_noise(&noise, ir, n);
+  for (size_t i = 0; i < n; i++) {
+    ir[i] *= 0.3f * expf(-(float)i / (0.003f * fs));
+  }
+  ir[0] += 1.0f;
+
+  Biquad bq;
+  biquad_init(&bq, BQ_HPF, 75.0f, 0.8f, 0.0f, fs);
+  biquad_process_inplace(&bq, ir, n);
+  biquad_init(&bq, BQ_PEAK, 110.0f, 1.5f, 4.0f, fs);
+  biquad_process_inplace(&bq, ir, n);
+  biquad_init(&bq, BQ_PEAK, 2500.0f, 1.2f, 3.0f, fs);
+  biquad_process_inplace(&bq, ir, n);
+  biquad_init(&bq, BQ_LPF, 5000.0f, 0.9f, 0.0f, fs);
+  biquad_process_inplace(&bq, ir, n);
+
+  switch (mic) {
+    case MIC_TYPE_DYNAMIC_SM57:
+      biquad_init(&bq, BQ_PEAK, 5500.0f, 1.0f, 4.0f, fs);
+      biquad_process_inplace(&bq, ir, n);
+      biquad_init(&bq, BQ_LOWSHELF, 200.0f, 0.7f, -2.0f, fs);
+      break;
+    case MIC_TYPE_DYNAMIC_MD421:
+      biquad_init(&bq, BQ_LOWSHELF, 250.0f, 0.7f, 2.0f, fs);
+      biquad_process_inplace(&bq, ir, n);
+      biquad_init(&bq, BQ_HIGHSHELF, 6000.0f, 0.7f, -1.0f, fs);
+      break;
+    case MIC_TYPE_CONDENSER_U87:
+      biquad_init(&bq, BQ_HIGHSHELF, 10000.0f, 0.7f, 1.0f, fs);
+      break;
+    case MIC_TYPE_CONDENSER_C414:
+      biquad_init(&bq, BQ_HIGHSHELF, 6000.0f, 0.7f, 3.0f, fs);
+      break;
+    case MIC_TYPE_RIBBON_R121:
+      biquad_init(&bq, BQ_HIGHSHELF, 4000.0f, 0.7f, -5.0f, fs);
+      break;
+    default:
+      biquad_init(&bq, BQ_HIGHSHELF, 4000.0f, 0.7f, -3.0f, fs);
+      break;
+  }
+  biquad_process_inplace(&bq, ir, n);
+
+  // further off axis, less of the cone's top end reaches the capsule
+  if (position == MIC_POSITION_OFF_AXIS_45) {
+    biquad_init(&bq, BQ_HIGHSHELF, 3000.0f, 0.7f, -4.0f, fs);
+    biquad_process_inplace(&bq, ir, n);
+  } else if (position == MIC_POSITION_OFF_AXIS_90) {
+    biquad_init(&bq, BQ_HIGHSHELF, 2000.0f, 0.7f, -8.0f, fs);
+    biquad_process_inplace(&bq, ir, n);
+    biquad_init(&bq, BQ_LPF, 7000.0f, 0.7f, 0.0f, fs);
+    biquad_process_inplace(&bq, ir, n);
+  }
+
+  // unit energy, so every mic sits at roughly the same loudness
+  double energy = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    energy += (double)ir[i] * ir[i];
+  }
+  if (energy > 0.0) {
+    float scale = (float)(1.0 / sqrt(energy));
+    for (size_t i = 0; i < n; i++) {
+      ir[i] *= scale;
+    }
+  }
+}
+
+static int cab_build_ir_cache(void) {
+  if (cabIRReady) {
+    return 0;
+  }
+  float* ir = malloc(CAB_IR_LENGTH * sizeof(float));
+  if (ir == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate cabinet IR");
+    return -1;
+  }
+  for (int mic = 0; mic < CAB_NUM_MICS; mic++) {
+    for (int position = 0; position < CAB_NUM_POSITIONS; position++) {
+      cab_build_ir(ir, CAB_IR_LENGTH, (MicType)mic, (MicPosition)position);
+      if (convolver_ir_init(&cabIRCache[mic][position], ir, CAB_IR_LENGTH, CAB_BLOCK_SIZE) != 0) {
+        // unwind, so a later attempt starts from scratch
+        for (int built = mic * CAB_NUM_POSITIONS + position - 1; built >= 0; built--) {
+          convolver_ir_free(&cabIRCache[built / CAB_NUM_POSITIONS][built % CAB_NUM_POSITIONS]);
+        }
+        free(ir);
+        return -1;
+      }
+    }
+  }
+  free(ir);
+  cabIRReady = 1;
+  return 0;
+}
+
+// unknown mics and positions fall back to an on-axis SM57, the way the amp stages fall back to a
+// default channel or tube
+static const ConvolverIR* cab_get_ir(MicType mic, MicPosition position) {
+  if ((unsigned)mic >= CAB_NUM_MICS) {
+    mic = MIC_TYPE_DYNAMIC_SM57;
+  }
+  if ((unsigned)position >= CAB_NUM_POSITIONS) {
+    position = MIC_POSITION_ON_AXIS;
+  }
+  return &cabIRCache[mic][position];
+}
+
+static int cab_init_state(CabinetState* cab) {
+  if (cab_build_ir_cache() != 0) {
+    return -1;
+  }
+  if (convolver_init(&cab->convolver, CAB_BLOCK_SIZE, (CAB_IR_LENGTH - 1) / CAB_BLOCK_SIZE) != 0) {
+    return -1;
+  }
+  cab->proximityDb = 0.0f;
+  biquad_init(&cab->proximity, BQ_LOWSHELF, 150.0f, 0.7f, 0.0f, EFFECTS_SAMPLE_RATE);
+  delayline_init_pow2(&cab->room, cab->roomMemory, CAB_ROOM_DELAY_SIZE, EFFECTS_SAMPLE_RATE);
+  cab->initialized = 1;
+  return 0;
+}
+
+void apply_cabinet_simulation(MicType micType, MicPosition micPosition, float distance, float roomAmount, float* buffer, int bufferSize) {
+  static const float reflectionMs[CAB_NUM_REFLECTIONS] = { 3.1f, 5.7f, 8.3f, 11.9f };
+  static const float reflectionGain[CAB_NUM_REFLECTIONS] = { 0.5f, -0.35f, 0.25f, -0.18f };
+  CabinetState* cab = &cabState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  // the first call allocates and builds every mic's IR; everything after runs without touching
+  // the heap
+  if (!cab->initialized && cab_init_state(cab) != 0) {
+    return;
+  }
+  const ConvolverIR* ir = cab_get_ir(micType, micPosition);
+  if (cab->convolver.ir != ir) {
+    convolver_set_ir(&cab->convolver, ir);
+  }
+
+  // distance runs 0 (on the grille) to 1; close up a directional mic picks up proximity bass
+  distance = clampf(distance, 0.0f, 1.0f);
+  roomAmount = clampf(roomAmount, 0.0f, 1.0f);
+  float proximityDb = 6.0f * (1.0f - distance);
+  if (proximityDb != cab->proximityDb) {
+    biquad_set_params(&cab->proximity, BQ_LOWSHELF, 150.0f, 0.7f, proximityDb, EFFECTS_SAMPLE_RATE);
+    cab->proximityDb = proximityDb;
+  }
+
+  float tap[CAB_CHUNK];
+  for (size_t done = 0; done < (size_t)bufferSize; done += CAB_CHUNK) {
+    size_t n = (size_t)bufferSize - done < CAB_CHUNK ? (size_t)bufferSize - done : CAB_CHUNK;
+    float* x = buffer + done;
+    convolver_process(&cab->convolver, x, x, n);
+    biquad_process_inplace(&cab->proximity, x, n);
+
+    // early reflections off the room, further apart as the mic backs away
+    delayline_write(&cab->room, x, n);
+    if (roomAmount > 0.0f) {
+      for (size_t r = 0; r < CAB_NUM_REFLECTIONS; r++) {
+        float delay = reflectionMs[r] * (1.0f + distance) * 0.001f * EFFECTS_SAMPLE_RATE;
+        // the block reads measure from the end of what was just written
+        delayline_read_linear(&cab->room, tap, n, delay + (float)n);
+        const float g = roomAmount * reflectionGain[r];
+        for (size_t i = 0; i < n; i++) {
+          x[i] += g * tap[i];
+        }
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Reverb
+// ---------------------------------------------------------------------------------------------
+
+#define REVERB_CHUNK 256
+#define REVERB_MAX_PREDELAY_MS 500.0f
+#define REVERB_PREDELAY_SIZE 32768
+// how long a control thread sleeps between checks while waiting for the callback to move on
+#define CALLBACK_EXIT_POLL_NS 100000L
+
+// Callbacks bump their epoch on entry and on exit, so it is odd while they are inside. Once a
+// new object has been published, a control thread calls this before freeing the old one: if the
+// callback was inside it may still hold the old pointer, so wait for it to leave; any pass that
+// starts after the publish picks up the new one. Only the control thread ever waits.
+static void wait_for_callback_exit(atomic_uint* epoch) {
+  const struct timespec pause = { 0, CALLBACK_EXIT_POLL_NS };
+  const unsigned int entered = atomic_load(epoch);
+  if (entered & 1u) {
+    while (atomic_load(epoch) == entered) {
+      nanosleep(&pause, NULL);
+    }
+  }
+}
+
+typedef struct {
+  int initialized;
+  FDNReverb fdn;
+  float roomSize;
+  float damping;
+  _Atomic(LongConvolver*) convolver;  // published by reverb_load_impulse_response
+  atomic_uint epoch;                  // odd while apply_reverb may be using convolver
+  DelayLine preDelay;
+  float preDelayMemory[REVERB_PREDELAY_SIZE + DELAYLINE_GUARD];
+} ReverbState;
+
+static ReverbState reverbState;
+
+// the FDN memory is allocated once, on the first call
+static int reverb_init_state(ReverbState* rv) {
+  if (fdn_init(&rv->fdn, EFFECTS_SAMPLE_RATE) != 0) {
+    return -1;
+  }
+  delayline_init_pow2(&rv->preDelay, rv->preDelayMemory, REVERB_PREDELAY_SIZE, EFFECTS_SAMPLE_RATE);
+  rv->roomSize = -1.0f;
+  rv->initialized = 1;
+  return 0;
+}
+
+// The new convolver is built off to the side and swapped in; the old one is only torn down once
+// the callback has let go of it
+int reverb_load_impulse_response(const float* ir, int length) {
+  ReverbState* rv = &reverbState;
+  LongConvolver* next = NULL;
+
+  if (ir != NULL && length > 0) {
+    next = malloc(sizeof(LongConvolver));
+    if (next == NULL) {
+      log_message(LOG_LEVEL_ERROR, "Failed to allocate reverb convolver");
+      return -1;
+    }
+    if (long_convolver_init(next, ir, (size_t)length) != 0) {
+      free(next);
+      return -1;
+    }
+  }
+  LongConvolver* old = atomic_exchange(&rv->convolver, next);
+  if (old != NULL) {
+    wait_for_callback_exit(&rv->epoch);
+    long_convolver_free(old);
+    free(old);
+  }
+  return 0;
+}
+
+void apply_reverb(float roomSize, float damping, float preDelay, float mix, float* buffer, int bufferSize) {
+  ReverbState* rv = &reverbState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  if (!rv->initialized && reverb_init_state(rv) != 0) {
+    return;
+  }
+  atomic_fetch_add(&rv->epoch, 1u);
+  LongConvolver* convolver = atomic_load(&rv->convolver);
+  if (convolver == NULL && (roomSize != rv->roomSize || damping != rv->damping)) {
+    fdn_set_params(&rv->fdn, roomSize, damping);
+    rv->roomSize = roomSize;
+    rv->damping = damping;
+  }
+
+  const float wet = clampf(mix / 100.0f, 0.0f, 1.0f);
+  const float preDelaySamples = clampf(preDelay, 0.0f, REVERB_MAX_PREDELAY_MS) * 0.001f * EFFECTS_SAMPLE_RATE;
+  float scratch[REVERB_CHUNK];
+  for (size_t done = 0; done < (size_t)bufferSize; done += REVERB_CHUNK) {
+    size_t n = (size_t)bufferSize - done < REVERB_CHUNK ? (size_t)bufferSize - done : REVERB_CHUNK;
+    float* x = buffer + done;
+    delayline_write(&rv->preDelay, x, n);
+    // the block reads measure from the end of what was just written
+    delayline_read_linear(&rv->preDelay, scratch, n, preDelaySamples + (float)n);
+    if (convolver != NULL) {
+      long_convolver_process(convolver, scratch, scratch, n);
+    } else {
+      fdn_process(&rv->fdn, scratch, scratch, n);
+    }
+    for (size_t i = 0; i < n; i++) {
+      x[i] += wet * (scratch[i] - x[i]);
+    }
+  }
+  atomic_fetch_add(&rv->epoch, 1u);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Pitch shifter
+// ---------------------------------------------------------------------------------------------
+
+#define PITCH_FRAME_SIZE 2048
+#define PITCH_CHUNK 256
+#define PITCH_MAX_INTERVAL 24.0f
+
+typedef struct {
+  int initialized;
+  int quality;
+  GrainShifter grain;
+  PhaseVocoder vocoder;
+} PitchShifterState;
+
+static PitchShifterState pitchState;
+
+// both tiers are allocated up front so switching quality never touches the heap
+static int pitch_init_state(PitchShifterState* ps) {
+  if (grain_shifter_init(&ps->grain, EFFECTS_SAMPLE_RATE) != 0) {
+    return -1;
+  }
+  if (phase_vocoder_init(&ps->vocoder, PITCH_FRAME_SIZE, EFFECTS_SAMPLE_RATE) != 0) {
+    grain_shifter_free(&ps->grain);
+    return -1;
+  }
+  ps->quality = 0;
+  ps->initialized = 1;
+  return 0;
+}
+
+void apply_pitch_shifter(float interval, float mix, float formant, int quality, float* buffer, int bufferSize) {
+  PitchShifterState* ps = &pitchState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  if (!ps->initialized && pitch_init_state(ps) != 0) {
+    return;
+  }
+  quality = quality > 0 ? 1 : 0;
+  // the tier that was idle holds stale audio
+  if (quality != ps->quality) {
+    if (quality) {
+      phase_vocoder_reset(&ps->vocoder);
+    } else {
+      grain_shifter_reset(&ps->grain);
+    }
+    ps->quality = quality;
+  }
+
+  const float ratio = exp2f(clampf(interval, -PITCH_MAX_INTERVAL, PITCH_MAX_INTERVAL) / 12.0f);
+  const float wet = clampf(mix, 0.0f, 1.0f);
+  if (quality) {
+    phase_vocoder_set_params(&ps->vocoder, ratio, formant);
+  } else {
+    grain_shifter_set_ratio(&ps->grain, ratio);
+  }
+
+  float shifted[PITCH_CHUNK];
+  for (size_t done = 0; done < (size_t)bufferSize; done += PITCH_CHUNK) {
+    size_t n = (size_t)bufferSize - done < PITCH_CHUNK ? (size_t)bufferSize - done : PITCH_CHUNK;
+    float* x = buffer + done;
+    if (quality) {
+      phase_vocoder_process(&ps->vocoder, x, shifted, n);
+    } else {
+      grain_shifter_process(&ps->grain, x, shifted, n);
+    }
+    for (size_t i = 0; i < n; i++) {
+      x[i] += wet * (shifted[i] - x[i]);
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------------------------
+// Looper
+// ---------------------------------------------------------------------------------------------
+
+typedef struct {
+  _Atomic(Looper*) looper;  // published by looper_prepare, NULL until it has succeeded
+  atomic_uint epoch;        // odd while apply_looper may be using looper
+} LooperState;
+
+static LooperState looperState;
+
+// As with reverb IRs, the new looper is mapped off to the side and swapped in; the old mapping
+// is only released once the callback has let go of it
+int looper_prepare(float maxSeconds, const char* backingFile) {
+  LooperState* ls = &looperState;
+
+  Looper* next = malloc(sizeof(Looper));
+  if (next == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate looper");
+    return -1;
+  }
+  size_t capacity = (size_t)(fmaxf(maxSeconds, 1.0f) * EFFECTS_SAMPLE_RATE);
+  if (looper_init(next, capacity, EFFECTS_SAMPLE_RATE, backingFile) != 0) {
+    free(next);
+    return -1;
+  }
+  Looper* old = atomic_exchange(&ls->looper, next);
+  if (old != NULL) {
+    wait_for_callback_exit(&ls->epoch);
+    looper_free(old);
+    free(old);
+  }
+  return 0;
+}
+
+void looper_request_mode(LooperMode mode) {
+  Looper* lp = atomic_load(&looperState.looper);
+  if (lp != NULL) {
+    looper_request(lp, mode);
+  }
+}
+
+void apply_looper(float loopLength, float feedback, float overdubLevel, float* buffer, int bufferSize) {
+  LooperState* ls = &looperState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  atomic_fetch_add(&ls->epoch, 1u);
+  Looper* lp = atomic_load(&ls->looper);
+  if (lp != NULL) {
+    size_t fixedLength = loopLength > 0.0f ? (size_t)(loopLength * 0.001f * EFFECTS_SAMPLE_RATE) : 0;
+    looper_process(lp, buffer, buffer, (size_t)bufferSize, fixedLength, clampf(feedback, 0.0f, 1.0f), clampf(overdubLevel, 0.0f, 1.0f));
+  }
+  atomic_fetch_add(&ls->epoch, 1u);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Limiter
+// ---------------------------------------------------------------------------------------------
+
+typedef struct {
+  int initialized;
+  atomic_int truePeak;  // written only by limiter_set_true_peak
+  Limiter limiter;
+} LimiterState;
+
+static LimiterState limiterState;
+
+void limiter_set_true_peak(int enabled) {
+  atomic_store_explicit(&limiterState.truePeak, enabled ? 1 : 0, memory_order_relaxed);
+}
+
+int limiter_get_latency(void) {
+  return limiterState.initialized ? (int)limiter_latency(&limiterState.limiter) : 0;
+}
+
+void apply_limiter(float threshold, float ratio, float attackTime, float releaseTime, float* buffer, int bufferSize) {
+  LimiterState* ls = &limiterState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  if (!ls->initialized) {
+    if (limiter_init(&ls->limiter, EFFECTS_SAMPLE_RATE) != 0) {
+      return;
+    }
+    ls->initialized = 1;
+  }
+  // the attack time is the lookahead: the gain is down by the time the peak it saw is played
+  limiter_set_params(&ls->limiter, threshold, ratio, attackTime, releaseTime, atomic_load_explicit(&ls->truePeak, memory_order_relaxed));
+  limiter_process(&ls->limiter, buffer, buffer, (size_t)bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Compressor
+// ---------------------------------------------------------------------------------------------
+
+typedef struct {
+  int initialized;
+  atomic_size_t interval;   // requested, written only by compressor_set_gain_interval
+  Compressor compressor;
+} CompressorState;
+
+static CompressorState compressorState = { .interval = 1 };
+
+void compressor_set_gain_interval(int interval) {
+  atomic_store_explicit(&compressorState.interval, interval > 1 ? (size_t)interval : 1, memory_order_relaxed);
+}
+
+void apply_compressor(float threshold, float ratio, float attackTime, float releaseTime, float makeupGain, float* buffer, int bufferSize) {
+  CompressorState* cs = &compressorState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  if (!cs->initialized) {
+    compressor_init(&cs->compressor, EFFECTS_SAMPLE_RATE, 0);
+    cs->initialized = 1;
+  }
+  const size_t interval = atomic_load_explicit(&cs->interval, memory_order_relaxed);
+  if (interval != cs->compressor.interval) {
+    compressor_set_control_rate(&cs->compressor, interval);
+  }
+  compressor_set_params(&cs->compressor, threshold, ratio, COMPRESSOR_KNEE_DB, attackTime, releaseTime, makeupGain);
+  compressor_process(&cs->compressor, buffer, buffer, (size_t)bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Noise gate
+// ---------------------------------------------------------------------------------------------
+
+#define NOISE_GATE_HYSTERESIS_DB 6.0f
+#define NOISE_GATE_HOLD_MS 50.0f
+#define NOISE_GATE_RANGE_DB -80.0f
+
+typedef struct {
+  int initialized;
+  NoiseGate gate;
+} NoiseGateState;
+
+static NoiseGateState noiseGateState;
+
+void apply_noise_gate_keyed(float threshold, float attackTime, float releaseTime, const float* key, float* buffer, int bufferSize) {
+  NoiseGateState* ns = &noiseGateState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  if (!ns->initialized) {
+    noise_gate_init(&ns->gate, EFFECTS_SAMPLE_RATE);
+    ns->initialized = 1;
+  }
+  noise_gate_set_params(&ns->gate, threshold, NOISE_GATE_HYSTERESIS_DB, attackTime, NOISE_GATE_HOLD_MS, releaseTime, NOISE_GATE_RANGE_DB);
+  noise_gate_process(&ns->gate, buffer, key, buffer, (size_t)bufferSize);
+}
+
+void apply_noise_gate(float threshold, float attackTime, float releaseTime, float* buffer, int bufferSize) {
+  apply_noise_gate_keyed(threshold, attackTime, releaseTime, NULL, buffer, bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Preamp
+// ---------------------------------------------------------------------------------------------
+
+#define PREAMP_OVERSAMPLING 4
+#define PREAMP_TABLE_RANGE_V 8.0f
+
+// Koren fits: mu, Kp, Ex, Kg1, then plate load and grid bias
+static const TubeParams tube12AX7 = { 100.0f, 600.0f, 1.4f, 1060.0f, 100000.0f, -1.5f };
+static const TubeParams tube7025 = { 100.0f, 600.0f, 1.4f, 1060.0f, 100000.0f, -1.2f };
+static const TubeParams tube12AT7 = { 60.0f, 300.0f, 1.35f, 460.0f, 47000.0f, -2.0f };
+
+#define PREAMP_STAGE(tubeParams, driveV, cathodeCornerHz, cathodeLossDb, couplingCornerHz) \
+  { .tube = tubeParams, .tableRange = PREAMP_TABLE_RANGE_V, .drive = driveV, .cathodeHz = cathodeCornerHz, \
+    .cathodeDb = cathodeLossDb, .couplingHz = couplingCornerHz }
+
+// Stage 0's drive is the grid swing for a full-scale input. Later drives are the previous
+// stage's gain less whatever the volume pots and tone stack between them take.
+static const PreampVoicing preampVoicings[AMP_CHANNEL_BASS_DRIVE + 1] = {
+  [AMP_CHANNEL_CLEAN] = { 2, { PREAMP_STAGE(tube12AX7, 0.5f, 200.0f, -6.0f, 20.0f),
+                               PREAMP_STAGE(tube12AX7, 4.0f, 100.0f, -10.0f, 20.0f) }, 1, 0, 0.35f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_FAT_CLEAN] = { 2, { PREAMP_STAGE(tube12AX7, 0.5f, 80.0f, -3.0f, 15.0f),
+                                   PREAMP_STAGE(tube12AX7, 6.0f, 60.0f, -6.0f, 15.0f) }, 1, 0, 0.35f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_CRUNCH] = { 3, { PREAMP_STAGE(tube12AX7, 0.5f, 150.0f, -6.0f, 30.0f),
+                                PREAMP_STAGE(tube12AX7, 20.0f, 250.0f, -8.0f, 40.0f),
+                                PREAMP_STAGE(tube12AX7, 8.0f, 150.0f, -10.0f, 30.0f) }, 1, 2, 0.3f, TONE_STACK_VOX },
+  [AMP_CHANNEL_PLEXI] = { 3, { PREAMP_STAGE(tube12AX7, 0.5f, 700.0f, -8.0f, 30.0f),
+                               PREAMP_STAGE(tube12AX7, 25.0f, 300.0f, -6.0f, 40.0f),
+                               PREAMP_STAGE(tube12AX7, 10.0f, 150.0f, -10.0f, 30.0f) }, 1, 2, 0.3f, TONE_STACK_MARSHALL },
+  [AMP_CHANNEL_LEAD] = { 4, { PREAMP_STAGE(tube12AX7, 0.5f, 300.0f, -6.0f, 40.0f),
+                              PREAMP_STAGE(tube12AX7, 30.0f, 300.0f, -4.0f, 60.0f),
+                              PREAMP_STAGE(tube12AX7, 20.0f, 200.0f, -6.0f, 60.0f),
+                              PREAMP_STAGE(tube12AX7, 10.0f, 150.0f, -10.0f, 30.0f) }, 1, 3, 0.3f, TONE_STACK_MARSHALL },
+  [AMP_CHANNEL_HOT_ROD_LEAD] = { 4, { PREAMP_STAGE(tube12AX7, 0.5f, 400.0f, -8.0f, 50.0f),
+                                      PREAMP_STAGE(tube12AX7, 35.0f, 300.0f, -4.0f, 80.0f),
+                                      PREAMP_STAGE(tube12AX7, 25.0f, 200.0f, -4.0f, 80.0f),
+                                      PREAMP_STAGE(tube12AX7, 12.0f, 150.0f, -10.0f, 30.0f) }, 1, 3, 0.3f, TONE_STACK_MARSHALL },
+  [AMP_CHANNEL_HIGH_GAIN] = { 4, { PREAMP_STAGE(tube12AX7, 0.5f, 500.0f, -10.0f, 100.0f),
+                                   PREAMP_STAGE(tube12AX7, 40.0f, 300.0f, -4.0f, 120.0f),
+                                   PREAMP_STAGE(tube12AX7, 30.0f, 200.0f, -4.0f, 100.0f),
+                                   PREAMP_STAGE(tube12AX7, 15.0f, 150.0f, -10.0f, 40.0f) }, 1, 3, 0.3f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_METAL] = { 5, { PREAMP_STAGE(tube12AX7, 0.5f, 500.0f, -10.0f, 80.0f),
+                               PREAMP_STAGE(tube12AX7, 40.0f, 300.0f, -4.0f, 100.0f),
+                               PREAMP_STAGE(tube12AX7, 30.0f, 200.0f, -4.0f, 100.0f),
+                               PREAMP_STAGE(tube12AX7, 25.0f, 200.0f, -6.0f, 60.0f),
+                               PREAMP_STAGE(tube12AX7, 10.0f, 150.0f, -10.0f, 30.0f) }, 1, 4, 0.3f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_DJENT] = { 5, { PREAMP_STAGE(tube12AX7, 0.5f, 800.0f, -12.0f, 200.0f),
+                               PREAMP_STAGE(tube12AX7, 40.0f, 400.0f, -4.0f, 200.0f),
+                               PREAMP_STAGE(tube12AX7, 30.0f, 300.0f, -4.0f, 150.0f),
+                               PREAMP_STAGE(tube12AX7, 25.0f, 200.0f, -6.0f, 100.0f),
+                               PREAMP_STAGE(tube12AX7, 10.0f, 150.0f, -10.0f, 40.0f) }, 1, 4, 0.3f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_BASS_CLEAN] = { 2, { PREAMP_STAGE(tube12AT7, 0.5f, 60.0f, -3.0f, 8.0f),
+                                    PREAMP_STAGE(tube12AT7, 3.0f, 40.0f, -6.0f, 8.0f) }, 1, 0, 0.4f, TONE_STACK_FENDER },
+  [AMP_CHANNEL_BASS_DRIVE] = { 3, { PREAMP_STAGE(tube12AT7, 0.5f, 60.0f, -3.0f, 10.0f),
+                                    PREAMP_STAGE(tube7025, 15.0f, 80.0f, -4.0f, 15.0f),
+                                    PREAMP_STAGE(tube12AX7, 8.0f, 60.0f, -8.0f, 10.0f) }, 1, 2, 0.3f, TONE_STACK_MARSHALL },
+};
+
+typedef struct {
+  int initialized;
+  Preamp preamp;
+} PreampState;
+
+static PreampState preampState;
+
+int preamp_get_latency(void) {
+  return preampState.initialized ? (int)preamp_latency(&preampState.preamp) : 0;
+}
+
+void apply_preamp_simulation(float gain, float bass, float mid, float treble, float presence, AmpChannelType channelType, float* buffer, int bufferSize) {
+  PreampState* ps = &preampState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  // the first call compiles every channel; after that a channel change is an index swap
+  if (!ps->initialized) {
+    if (preamp_init(&ps->preamp, EFFECTS_SAMPLE_RATE, PREAMP_OVERSAMPLING) != 0 ||
+        preamp_set_voicings(&ps->preamp, preampVoicings, AMP_CHANNEL_BASS_DRIVE + 1) != 0) {
+      preamp_free(&ps->preamp);
+      return;
+    }
+    ps->initialized = 1;
+  }
+  int channel = (int)channelType;
+  if (channel < 0 || channel > AMP_CHANNEL_BASS_DRIVE) {
+    channel = AMP_CHANNEL_CLEAN;
+  }
+  preamp_select_voicing(&ps->preamp, (size_t)channel);
+  preamp_set_controls(&ps->preamp, gain, bass, mid, treble, presence);
+  preamp_process(&ps->preamp, buffer, buffer, (size_t)bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Power amp
+// ---------------------------------------------------------------------------------------------
+
+#define POWERAMP_OVERSAMPLING 2
+
+// Pentodes are biased class AB at about three quarters of the way to cutoff on the 300 V supply
+// the tables assume. Preamp tubes run as a small push-pull triode stage. Solid-state rectified
+// designs (KT88, 6550) sag fastest and least; the 5Y3 in 6V6 amps the most.
+static const PowerAmpVoicing powerAmpVoicings[TUBE_TYPE_6550 + 1] = {
+  [TUBE_TYPE_12AX7] = { TUBE_TRIODE, { 100.0f, 600.0f, 1.4f, 1060.0f, 100000.0f, -1.5f }, 3.0f, 6.0f, 0.5f, 6.0f, 10.0f, 100.0f },
+  [TUBE_TYPE_7025] = { TUBE_TRIODE, { 100.0f, 600.0f, 1.4f, 1060.0f, 100000.0f, -1.2f }, 3.0f, 5.0f, 0.5f, 6.0f, 10.0f, 100.0f },
+  [TUBE_TYPE_12AT7] = { TUBE_TRIODE, { 60.0f, 300.0f, 1.35f, 460.0f, 47000.0f, -2.0f }, 4.0f, 6.0f, 0.6f, 6.0f, 10.0f, 100.0f },
+  [TUBE_TYPE_EL84] = { TUBE_PENTODE, { 19.5f, 152.0f, 1.35f, 600.0f, 4000.0f, -11.5f }, 11.5f, 12.0f, 3.0f, 6.0f, 15.0f, 120.0f },
+  [TUBE_TYPE_EL34] = { TUBE_PENTODE, { 11.0f, 60.0f, 1.35f, 650.0f, 2000.0f, -20.5f }, 20.5f, 24.0f, 5.0f, 12.0f, 10.0f, 100.0f },
+  [TUBE_TYPE_6V6] = { TUBE_PENTODE, { 10.7f, 41.0f, 1.31f, 1672.0f, 4000.0f, -21.0f }, 21.0f, 28.0f, 5.0f, 8.0f, 20.0f, 150.0f },
+  [TUBE_TYPE_6L6] = { TUBE_PENTODE, { 8.7f, 48.0f, 1.35f, 1460.0f, 2500.0f, -26.0f }, 26.0f, 28.0f, 6.0f, 12.0f, 8.0f, 80.0f },
+  [TUBE_TYPE_KT88] = { TUBE_PENTODE, { 8.8f, 32.0f, 1.35f, 730.0f, 1500.0f, -25.5f }, 25.5f, 24.0f, 6.0f, 14.0f, 5.0f, 60.0f },
+  [TUBE_TYPE_6550] = { TUBE_PENTODE, { 7.9f, 35.0f, 1.35f, 890.0f, 1600.0f, -28.5f }, 28.5f, 24.0f, 6.0f, 14.0f, 5.0f, 60.0f },
+};
+
+typedef struct {
+  int initialized;
+  PowerAmp amp;
+} PowerAmpState;
+
+static PowerAmpState powerAmpState;
+
+int power_amp_get_latency(void) {
+  return powerAmpState.initialized ? (int)poweramp_latency(&powerAmpState.amp) : 0;
+}
+
+void apply_power_amp_simulation(float masterVolume, float sag, float presence, float depth, TubeType tubeType, float bias, float* buffer, int bufferSize) {
+  PowerAmpState* ps = &powerAmpState;
+
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  // the first call takes every tube's table; after that a tube change is an index swap
+  if (!ps->initialized) {
+    if (poweramp_init(&ps->amp, EFFECTS_SAMPLE_RATE, POWERAMP_OVERSAMPLING) != 0 ||
+        poweramp_set_voicings(&ps->amp, powerAmpVoicings, TUBE_TYPE_6550 + 1) != 0) {
+      poweramp_free(&ps->amp);
+      return;
+    }
+    ps->initialized = 1;
+  }
+  int tube = (int)tubeType;
+  if (tube < 0 || tube > TUBE_TYPE_6550) {
+    tube = TUBE_TYPE_6L6;
+  }
+  poweramp_select_voicing(&ps->amp, (size_t)tube);
+  poweramp_set_controls(&ps->amp, masterVolume, sag, presence, depth, bias);
+  poweramp_process(&ps->amp, buffer, buffer, (size_t)bufferSize);
+}
+
+// ---------------------------------------------------------------------------------------------
+// Chorus
+// ---------------------------------------------------------------------------------------------
+
+#define CHORUS_DEFAULT_VOICES 3
+
+typedef struct {
+  int initialized;
+  atomic_size_t voices; // requested count, written only by chorus_set_voice_count
+  Chorus chorus;        // chorus.voices is the count in effect
+} ChorusState;
+
+static ChorusState chorusState = { .voices = CHORUS_DEFAULT_VOICES };
+
+// clamped here, to the range chorus_set_voices keeps, so a request the chorus can't honour
+// exactly doesn't look pending on every call
+void chorus_set_voice_count(int voices) {
+  size_t count = voices > 0 ? (size_t)voices : CHORUS_DEFAULT_VOICES;
+  count = count < 2 ? 2 : count > CHORUS_MAX_VOICES ? CHORUS_MAX_VOICES : count;
+  atomic_store_explicit(&chorusState.voices, count, memory_order_relaxed);
+}
+
+static Chorus* chorus_prepare(float rate, float depth, float mix, float spread) {
+  ChorusState* cs = &chorusState;
+  if (!cs->initialized) {
+    if (chorus_init(&cs->chorus, EFFECTS_SAMPLE_RATE) != 0) {
+      return NULL;
+    }
+    cs->initialized = 1;
+  }
+  const size_t voices = atomic_load_explicit(&cs->voices, memory_order_relaxed);
+  if (voices != cs->chorus.voices) {
+    chorus_set_voices(&cs->chorus, voices);
+  }
+  chorus_set_params(&cs->chorus, rate, depth, mix, spread);
+  return &cs->chorus;
+}
+
+void apply_chorus(float rate, float depth, float mix, float* buffer, int bufferSize) {
+  if (buffer == NULL || bufferSize <= 0) {
+    return;
+  }
+  Chorus* chorus = chorus_prepare(rate, depth, mix, 0.0f);
+  if (chorus != NULL) {
+    chorus_process(chorus, buffer, buffer, NULL, (size_t)bufferSize);
+  }
+}
+
+void apply_chorus_stereo(float rate, float depth, float mix, float spread, const float* input, float* left, float* right, int bufferSize) {
+  if (input == NULL || left == NULL || right == NULL || bufferSize <= 0) {
+    return;
+  }
+  Chorus* chorus = chorus_prepare(rate, depth, mix, spread);
+  if (chorus != NULL) {
+    chorus_process(chorus, input, left, right, (size_t)bufferSize);
+  }
+}
@@ -0,0 +1,333 @@
+#include <fft.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define FFT_MAX_LOG2 16
+
+static FFTPlan* planCache[FFT_MAX_LOG2 + 1];
+static pthread_mutex_t planCacheLock = PTHREAD_MUTEX_INITIALIZER;
+
+// complex helpers on 4 interleaved (re, im) pairs
+
+static inline simde__m256 fft_cmul(simde__m256 a, simde__m256 w) {
+  simde__m256 aSwap = simde_mm256_permute_ps(a, 0xB1);
+  return simde_mm256_addsub_ps(simde_mm256_mul_ps(a, simde_mm256_moveldup_ps(w)), simde_mm256_mul_ps(aSwap, simde_mm256_movehdup_ps(w)));
+}
+
+static inline simde__m256 fft_cmul_conj(simde__m256 a, simde__m256 w) {
+  simde__m256 aSwap = simde_mm256_permute_ps(a, 0xB1);
+  simde__m256 wi = simde_mm256_xor_ps(simde_mm256_movehdup_ps(w), simde_mm256_set1_ps(-0.0f));
+  return simde_mm256_addsub_ps(simde_mm256_mul_ps(a, simde_mm256_moveldup_ps(w)), simde_mm256_mul_ps(aSwap, wi));
+}
+
+static inline simde__m256 fft_conj(simde__m256 a) {
+  return simde_mm256_xor_ps(a, simde_mm256_setr_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f));
+}
+
+// i * a
+static inline simde__m256 fft_mul_i(simde__m256 a) {
+  return simde_mm256_xor_ps(simde_mm256_permute_ps(a, 0xB1), simde_mm256_setr_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f));
+}
+
+// reverses the order of the 4 complex values
+static inline simde__m256 fft_reverse(simde__m256 a) {
+  return simde_mm256_permute_ps(simde_mm256_permute2f128_ps(a, a, 1), 0x4E);
+}
+
+static FFTPlan* fft_plan_create(size_t n) {
+  const size_t m = n / 2;
+  FFTPlan* plan = calloc(1, sizeof(FFTPlan));
+  if (plan == NULL) return NULL;
+  plan->n = n;
+  plan->bitrev = malloc(m * sizeof(uint32_t));
+  plan->twiddle = malloc(2 * m * sizeof(float));
+  plan->split = malloc(2 * (m / 2 + 1) * sizeof(float));
+  if (plan->bitrev == NULL || plan->twiddle == NULL || plan->split == NULL) {
+    free(plan->bitrev);
+    free(plan->twiddle);
+    free(plan->split);
+    free(plan);
+    return NULL;
+  }
+
+  size_t bits = 0;
+  while (((size_t)1 << bits) < m) bits++;
+  for (size_t i = 0; i < m; i++) {
+    uint32_t r = 0;
+    for (size_t b = 0; b < bits; b++) {
+      r |= (uint32_t)((i >> b) & 1) << (bits - 1 - b);
+    }
+    plan->bitrev[i] = r;
+  }
+  // stage of half-size h keeps its h twiddles at 2 * (h - 4), right after the smaller stages
+  for (size_t h = 4; h < m; h <<= 1) {
+    float* tw = plan->twiddle + 2 * (h - 4);
+    for (size_t k = 0; k < h; k++) {
+      double w = -M_PI * (double)k / (double)h;
+      tw[2 * k] = (float)cos(w);
+      tw[2 * k + 1] = (float)sin(w);
+    }
+  }
+  for (size_t k = 0; k <= m / 2; k++) {
+    double w = -2.0 * M_PI * (double)k / (double)n;
+    plan->split[2 * k] = (float)cos(w);
+    plan->split[2 * k + 1] = (float)sin(w);
+  }
+  return plan;
+}
+
+static void fft_plan_destroy(FFTPlan* plan) {
+  if (plan == NULL) return;
+  free(plan->bitrev);
+  free(plan->twiddle);
+  free(plan->split);
+  free(plan);
+}
+
+const FFTPlan* fft_plan_get(size_t n) {
+  if (n < FFT_MIN_SIZE || n > FFT_MAX_SIZE || (n & (n - 1)) != 0) {
+    log_message(LOG_LEVEL_ERROR, "FFT size %zu is not a power of two in [%d, %d]", n, FFT_MIN_SIZE, FFT_MAX_SIZE);
+    return NULL;
+  }
+  size_t log2n = 0;
+  while (((size_t)1 << log2n) < n) log2n++;
+
+  pthread_mutex_lock(&planCacheLock);
+  if (planCache[log2n] == NULL) {
+    planCache[log2n] = fft_plan_create(n);
+    if (planCache[log2n] == NULL) {
+      log_message(LOG_LEVEL_ERROR, "Failed to allocate FFT plan for size %zu", n);
+    }
+  }
+  FFTPlan* plan = planCache[log2n];
+  pthread_mutex_unlock(&planCacheLock);
+  return plan;
+}
+
+void fft_plan_cache_clear(void) {
+  pthread_mutex_lock(&planCacheLock);
+  for (size_t i = 0; i <= FFT_MAX_LOG2; i++) {
+    fft_plan_destroy(planCache[i]);
+    planCache[i] = NULL;
+  }
+  pthread_mutex_unlock(&planCacheLock);
+}
+
+static void fft_bitrev_inplace(const FFTPlan* plan, float* z) {
+  const size_t m = plan->n / 2;
+  for (size_t i = 0; i < m; i++) {
+    size_t j = plan->bitrev[i];
+    if (i < j) {
+      float tr = z[2 * i], ti = z[2 * i + 1];
+      z[2 * i] = z[2 * j];
+      z[2 * i + 1] = z[2 * j + 1];
+      z[2 * j] = tr;
+      z[2 * j + 1] = ti;
+    }
+  }
+}
+
+static void fft_bitrev_copy(const FFTPlan* plan, const float* in, float* z) {
+  const size_t m = plan->n / 2;
+  for (size_t i = 0; i < m; i++) {
+    size_t j = plan->bitrev[i];
+    z[2 * j] = in[2 * i];
+    z[2 * j + 1] = in[2 * i + 1];
+  }
+}
+
+// Decimation-in-time butterflies over m bit-reversed complex points. The first two stages only
+// rotate by +-i, so they run together as an in-register radix-4; every later stage covers at least one
+// whole vector per butterfly run, and they go two at a time where possible. inverse is a constant
+// at every call site.
+static inline void fft_complex(const FFTPlan* plan, float* z, int inverse) {
+  const size_t m = plan->n / 2;
+  // each vector is one 4-point group: [z0 z1 z2 z3] -> [z0+z1, z0-z1, z2+z3, z2-z3], then the
+  // upper pair combines with the lower one, a3 rotated by -i (forward) or i (inverse)
+  const simde__m256 pairSign = simde_mm256_setr_ps(1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, -1.0f, -1.0f);
+  const simde__m256 halfSign = simde_mm256_setr_ps(1.0f, 1.0f, 1.0f, 1.0f, -1.0f, -1.0f, -1.0f, -1.0f);
+  const simde__m256 rotSign = inverse ? simde_mm256_setr_ps(0.0f, 0.0f, -0.0f, 0.0f, 0.0f, 0.0f, -0.0f, 0.0f)
+                                      : simde_mm256_setr_ps(0.0f, 0.0f, 0.0f, -0.0f, 0.0f, 0.0f, 0.0f, -0.0f);
+  for (size_t i = 0; i < 2 * m; i += 8) {
+    simde__m256 v = simde_mm256_loadu_ps(&z[i]);
+    simde__m256 a = simde_mm256_add_ps(simde_mm256_permute_ps(v, 0x44), simde_mm256_mul_ps(simde_mm256_permute_ps(v, 0xEE), pairSign));
+    simde__m256 lo = simde_mm256_permute2f128_ps(a, a, 0x00);
+    simde__m256 hi = simde_mm256_permute2f128_ps(a, a, 0x11);
+    hi = simde_mm256_xor_ps(simde_mm256_permute_ps(hi, 0xB4), rotSign);
+    simde_mm256_storeu_ps(&z[i], simde_mm256_add_ps(lo, simde_mm256_mul_ps(hi, halfSign)));
+  }
+
+  // pairs of stages h and 2h run fused as radix-4, halving the passes over memory
+  size_t h = 4;
+  for (; 2 * h < m; h <<= 2) {
+    const float* tw1 = plan->twiddle + 2 * (h - 4);
+    const float* tw2 = plan->twiddle + 2 * (2 * h - 4);
+    for (size_t i = 0; i < m; i += 4 * h) {
+      float* a = z + 2 * i;
+      float* b = a + 2 * h;
+      float* c = b + 2 * h;
+      float* d = c + 2 * h;
+      for (size_t k = 0; k < h; k += 4) {
+        simde__m256 w1 = simde_mm256_loadu_ps(&tw1[2 * k]);
+        simde__m256 w2 = simde_mm256_loadu_ps(&tw2[2 * k]);
+        simde__m256 va = simde_mm256_loadu_ps(&a[2 * k]);
+        simde__m256 vb = simde_mm256_loadu_ps(&b[2 * k]);
+        simde__m256 vc = simde_mm256_loadu_ps(&c[2 * k]);
+        simde__m256 vd = simde_mm256_loadu_ps(&d[2 * k]);
+        simde__m256 t1 = inverse ? fft_cmul_conj(vb, w1) : fft_cmul(vb, w1);
+        simde__m256 t2 = inverse ? fft_cmul_conj(vd, w1) : fft_cmul(vd, w1);
+        simde__m256 a1 = simde_mm256_add_ps(va, t1);
+        simde__m256 b1 = simde_mm256_sub_ps(va, t1);
+        simde__m256 c1 = simde_mm256_add_ps(vc, t2);
+        simde__m256 d1 = simde_mm256_sub_ps(vc, t2);
+        simde__m256 u = inverse ? fft_cmul_conj(c1, w2) : fft_cmul(c1, w2);
+        // w2h^(k + h) = w2h^k * -i forward, * i inverse
+        simde__m256 v = inverse ? fft_cmul_conj(d1, w2) : fft_cmul(d1, w2);
+        v = inverse ? fft_mul_i(v) : simde_mm256_sub_ps(simde_mm256_setzero_ps(), fft_mul_i(v));
+        simde_mm256_storeu_ps(&a[2 * k], simde_mm256_add_ps(a1, u));
+        simde_mm256_storeu_ps(&c[2 * k], simde_mm256_sub_ps(a1, u));
+        simde_mm256_storeu_ps(&b[2 * k], simde_mm256_add_ps(b1, v));
+        simde_mm256_storeu_ps(&d[2 * k], simde_mm256_sub_ps(b1, v));
+      }
+    }
+  }
+  if (h < m) {
+    const float* tw = plan->twiddle + 2 * (h - 4);
+    for (size_t i = 0; i < m; i += 2 * h) {
+      float* a = z + 2 * i;
+      float* b = a + 2 * h;
+      for (size_t k = 0; k < h; k += 4) {
+        simde__m256 w = simde_mm256_loadu_ps(&tw[2 * k]);
+        simde__m256 va = simde_mm256_loadu_ps(&a[2 * k]);
+        simde__m256 vb = simde_mm256_loadu_ps(&b[2 * k]);
+        simde__m256 t = inverse ? fft_cmul_conj(vb, w) : fft_cmul(vb, w);
+        simde_mm256_storeu_ps(&a[2 * k], simde_mm256_add_ps(va, t));
+        simde_mm256_storeu_ps(&b[2 * k], simde_mm256_sub_ps(va, t));
+      }
+    }
+  }
+}
+
+// Turns the n/2-point transform Z of the (even, odd) pairs into the real spectrum X:
+// with A = Z[k], B = conj(Z[m - k]), P = -i/2 * W^k * (A - B) and E = (A + B) / 2,
+// X[k] = E + P and X[m - k] = conj(E - P)
+static void fft_split_forward(const FFTPlan* plan, float* z) {
+  const size_t m = plan->n / 2;
+  const float* tw = plan->split;
+  const simde__m256 half = simde_mm256_set1_ps(0.5f);
+
+  float r0 = z[0], i0 = z[1];
+  z[0] = r0 + i0;
+  z[1] = r0 - i0;
+  z[m + 1] = -z[m + 1];
+
+  size_t k = 1;
+  for (; k + 4 <= m / 2; k += 4) {
+    float* lo = z + 2 * k;
+    float* hi = z + 2 * (m - k - 3);
+    simde__m256 a = simde_mm256_loadu_ps(lo);
+    simde__m256 b = fft_conj(fft_reverse(simde_mm256_loadu_ps(hi)));
+    simde__m256 e = simde_mm256_mul_ps(half, simde_mm256_add_ps(a, b));
+    simde__m256 q = fft_cmul(simde_mm256_sub_ps(a, b), simde_mm256_loadu_ps(&tw[2 * k]));
+    // -i/2 * q
+    simde__m256 p = simde_mm256_mul_ps(half, fft_conj(simde_mm256_permute_ps(q, 0xB1)));
+    simde_mm256_storeu_ps(lo, simde_mm256_add_ps(e, p));
+    simde_mm256_storeu_ps(hi, fft_reverse(fft_conj(simde_mm256_sub_ps(e, p))));
+  }
+  for (; k < m / 2; k++) {
+    size_t j = m - k;
+    float ar = z[2 * k], ai = z[2 * k + 1];
+    float br = z[2 * j], bi = -z[2 * j + 1];
+    float er = 0.5f * (ar + br), ei = 0.5f * (ai + bi);
+    float dr = ar - br, di = ai - bi;
+    float wr = tw[2 * k], wi = tw[2 * k + 1];
+    float qr = dr * wr - di * wi, qi = dr * wi + di * wr;
+    float pr = 0.5f * qi, pi = -0.5f * qr;
+    z[2 * k] = er + pr;
+    z[2 * k + 1] = ei + pi;
+    z[2 * j] = er - pr;
+    z[2 * j + 1] = -(ei - pi);
+  }
+}
+
+// Inverse of the split, scaled by 2 so the whole inverse comes out as n * x:
+// with A = X[k], B = conj(X[m - k]), Y = conj(W^k) * (A - B) and S = A + B,
+// Z[k] = S + iY and Z[m - k] = conj(S - iY)
+static void fft_split_inverse(const FFTPlan* plan, float* z) {
+  const size_t m = plan->n / 2;
+  const float* tw = plan->split;
+
+  float dc = z[0], nyq = z[1];
+  z[0] = dc + nyq;
+  z[1] = dc - nyq;
+  z[m] = 2.0f * z[m];
+  z[m + 1] = -2.0f * z[m + 1];
+
+  size_t k = 1;
+  for (; k + 4 <= m / 2; k += 4) {
+    float* lo = z + 2 * k;
+    float* hi = z + 2 * (m - k - 3);
+    simde__m256 a = simde_mm256_loadu_ps(lo);
+    simde__m256 b = fft_conj(fft_reverse(simde_mm256_loadu_ps(hi)));
+    simde__m256 s = simde_mm256_add_ps(a, b);
+    simde__m256 iy = fft_mul_i(fft_cmul_conj(simde_mm256_sub_ps(a, b), simde_mm256_loadu_ps(&tw[2 * k])));
+    simde_mm256_storeu_ps(lo, simde_mm256_add_ps(s, iy));
+    simde_mm256_storeu_ps(hi, fft_reverse(fft_conj(simde_mm256_sub_ps(s, iy))));
+  }
+  for (; k < m / 2; k++) {
+    size_t j = m - k;
+    float ar = z[2 * k], ai = z[2 * k + 1];
+    float br = z[2 * j], bi = -z[2 * j + 1];
+    float sr = ar + br, si = ai + bi;
+    float dr = ar - br, di = ai - bi;
+    float wr = tw[2 * k], wi = -tw[2 * k + 1];
+    float yr = dr * wr - di * wi, yi = dr * wi + di * wr;
+    z[2 * k] = sr - yi;
+    z[2 * k + 1] = si + yr;
+    z[2 * j] = sr + yi;
+    z[2 * j + 1] = -(si - yr);
+  }
+}
+
+void fft_forward(const FFTPlan* plan, const float* in, float* out) {
+  if (in == out) {
+    fft_forward_inplace(plan, out);
+    return;
+  }
+  fft_bitrev_copy(plan, in, out);
+  fft_complex(plan, out, 0);
+  fft_split_forward(plan, out);
+}
+
+void fft_forward_inplace(const FFTPlan* plan, float* data) {
+  fft_bitrev_inplace(plan, data);
+  fft_complex(plan, data, 0);
+  fft_split_forward(plan, data);
+}
+
+void fft_inverse(const FFTPlan* plan, const float* in, float* out) {
+  if (in != out) {
+    memcpy(out, in, plan->n * sizeof(float));
+  }
+  fft_inverse_inplace(plan, out);
+}
+
+void fft_inverse_inplace(const FFTPlan* plan, float* data) {
+  fft_split_inverse(plan, data);
+  fft_bitrev_inplace(plan, data);
+  fft_complex(plan, data, 1);
+}
+
+void fft_spectrum_mac(float* acc, const float* a, const float* b, size_t n) {
+  // bin 0 packs two real bins, so it is redone after the complex pass
+  const float dc = acc[0] + a[0] * b[0];
+  const float nyq = acc[1] + a[1] * b[1];
+  for (size_t i = 0; i < n; i += 8) {
+    simde__m256 prod = fft_cmul(simde_mm256_loadu_ps(&a[i]), simde_mm256_loadu_ps(&b[i]));
+    simde_mm256_storeu_ps(&acc[i], simde_mm256_add_ps(simde_mm256_loadu_ps(&acc[i]), prod));
+  }
+  acc[0] = dc;
+  acc[1] = nyq;
+}
@@ -0,0 +1,262 @@
+#include <long_convolver.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// how long an idle worker sleeps before rescanning in case the callback's wake-up was skipped
+#define LONG_CONV_IDLE_NS 2000000L
+// callback input is staged through the stack in runs of at most this many samples
+#define LONG_CONV_CHUNK 1024
+
+// Block size and the IR tap each stage ends at. Every worker stage starts at least two of its blocks
+// in, and every block size divides the next, so callback runs split at the first worker stage's
+// boundaries never straddle a later stage's block either.
+static const struct {
+  size_t blockSize;
+  size_t end;
+} longConvLayout[LONG_CONV_MAX_STAGES] = {
+  { 64, 4096 },
+  { 1024, 32768 },
+  { 8192, SIZE_MAX },
+};
+
+static int long_convolver_stage_init(LongConvolverStage* s, const float* taps, size_t numTaps, size_t offset, size_t end, size_t blockSize) {
+  memset(s, 0, sizeof(*s));
+  if (end > numTaps) end = numTaps;
+  s->blockSize = blockSize;
+  s->offset = offset;
+  s->ringBlocks = 1;
+  while (s->ringBlocks < offset / blockSize) s->ringBlocks <<= 1;
+
+  // the stage IR starts one block early, so its first partition lands on offset; the direct head
+  // that creates overlaps the previous stage and is never run
+  if (convolver_ir_init(&s->ir, taps + offset - blockSize, end - offset + blockSize, blockSize) != 0 ||
+      convolver_init(&s->conv, blockSize, s->ir.numPartitions) != 0) {
+    return -1;
+  }
+  convolver_set_ir(&s->conv, &s->ir);
+  s->inRing = calloc((2 * s->ringBlocks + 1) * blockSize, sizeof(float));
+  if (s->inRing == NULL) {
+    log_message(LOG_LEVEL_ERROR, "Failed to allocate convolution stage buffers");
+    return -1;
+  }
+  s->outRing = s->inRing + s->ringBlocks * blockSize;
+  s->scratch = s->outRing + s->ringBlocks * blockSize;
+  atomic_init(&s->submitted, 0);
+  atomic_init(&s->done, 0);
+  atomic_init(&s->busy, 0);
+  return 0;
+}
+
+static void long_convolver_stage_free(LongConvolverStage* s) {
+  convolver_free(&s->conv);
+  convolver_ir_free(&s->ir);
+  free(s->inRing);
+  s->inRing = NULL;
+}
+
+// Input block j goes in, the stage's output for block j + offset / blockSize comes out
+static void long_convolver_run_job(LongConvolverStage* s) {
+  const size_t B = s->blockSize;
+  const size_t mask = s->ringBlocks - 1;
+  const size_t j = atomic_load_explicit(&s->done, memory_order_relaxed);
+  memcpy(s->scratch, s->inRing + (j & mask) * B, B * sizeof(float));
+  // the callback reuses slot j once it reaches block j + ringBlocks; by then this block's output is
+  // long overdue, so just keep the garbage out of the delay line
+  if (atomic_load_explicit(&s->submitted, memory_order_acquire) >= j + s->ringBlocks) {
+    memset(s->scratch, 0, B * sizeof(float));
+  }
+  const size_t q = j + s->offset / B;
+  convolver_process_block(&s->conv, s->scratch, s->outRing + (q & mask) * B);
+  atomic_store_explicit(&s->done, j + 1, memory_order_release);
+}
+
+static int long_convolver_stage_pending(LongConvolverStage* s) {
+  return atomic_load_explicit(&s->done, memory_order_acquire) < atomic_load_explicit(&s->submitted, memory_order_acquire);
+}
+
+// Earliest deadline first: of the stages with work that no other worker holds, take the one whose
+// next output is due soonest
+static LongConvolverStage* long_convolver_claim(LongConvolver* lc) {
+  for (;;) {
+    LongConvolverStage* best = NULL;
+    uint64_t bestDeadline = UINT64_MAX;
+    for (size_t k = 0; k < lc->numStages; k++) {
+      LongConvolverStage* s = &lc->stages[k];
+      if (atomic_load_explicit(&s->busy, memory_order_relaxed) || !long_convolver_stage_pending(s)) {
+        continue;
+      }
+      uint64_t deadline = (uint64_t)atomic_load_explicit(&s->done, memory_order_relaxed) * s->blockSize + s->offset;
+      if (deadline < bestDeadline) {
+        bestDeadline = deadline;
+        best = s;
+      }
+    }
+    if (best == NULL) {
+      return NULL;
+    }
+    int expected = 0;
+    if (atomic_compare_exchange_strong(&best->busy, &expected, 1)) {
+      if (long_convolver_stage_pending(best)) {
+        return best;
+      }
+      atomic_store_explicit(&best->busy, 0, memory_order_release);
+    }
+  }
+}
+
+static void* long_convolver_worker(void* arg) {
+  LongConvolver* lc = arg;
+  while (atomic_load_explicit(&lc->running, memory_order_acquire)) {
+    LongConvolverStage* s;
+    while ((s = long_convolver_claim(lc)) != NULL) {
+      long_convolver_run_job(s);
+      atomic_store_explicit(&s->busy, 0, memory_order_release);
+    }
+
+    pthread_mutex_lock(&lc->lock);
+    if (atomic_load_explicit(&lc->running, memory_order_acquire)) {
+      struct timespec until;
+      clock_gettime(CLOCK_REALTIME, &until);
+      until.tv_nsec += LONG_CONV_IDLE_NS;
+      if (until.tv_nsec >= 1000000000L) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000L;
+      }
+      pthread_cond_timedwait(&lc->wake, &lc->lock, &until);
+    }
+    pthread_mutex_unlock(&lc->lock);
+  }
+  return NULL;
+}
+
+// Never waits on the lock: if a worker holds it, that worker is about to sleep for at most
+// LONG_CONV_IDLE_NS, well inside the smallest worker stage's slack
+static void long_convolver_wake(LongConvolver* lc) {
+  if (pthread_mutex_trylock(&lc->lock) == 0) {
+    pthread_cond_broadcast(&lc->wake);
+    pthread_mutex_unlock(&lc->lock);
+  }
+}
+
+int long_convolver_init(LongConvolver* lc, const float* taps, size_t numTaps) {
+  memset(lc, 0, sizeof(*lc));
+  pthread_mutex_init(&lc->lock, NULL);
+  pthread_cond_init(&lc->wake, NULL);
+  atomic_init(&lc->running, 1);
+  atomic_init(&lc->misses, 0);
+
+  const size_t headTaps = numTaps < longConvLayout[0].end ? numTaps : longConvLayout[0].end;
+  if (convolver_ir_init(&lc->headIR, taps, headTaps, longConvLayout[0].blockSize) != 0 ||
+      convolver_init(&lc->head, longConvLayout[0].blockSize, lc->headIR.numPartitions) != 0) {
+    long_convolver_free(lc);
+    return -1;
+  }
+  convolver_set_ir(&lc->head, &lc->headIR);
+  for (size_t k = 1; k < LONG_CONV_MAX_STAGES && numTaps > longConvLayout[k - 1].end; k++) {
+    LongConvolverStage* s = &lc->stages[lc->numStages];
+    lc->numStages++;
+    if (long_convolver_stage_init(s, taps, numTaps, longConvLayout[k - 1].end, longConvLayout[k].end, longConvLayout[k].blockSize) != 0) {
+      long_convolver_free(lc);
+      return -1;
+    }
+  }
+
+  // one worker per stage so the long stage never holds up the short one, leaving a core for audio
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  size_t maxWorkers = cores > 2 ? (size_t)cores - 1 : 1;
+  size_t numWorkers = lc->numStages < maxWorkers ? lc->numStages : maxWorkers;
+  for (size_t i = 0; i < numWorkers; i++) {
+    if (pthread_create(&lc->workers[i], NULL, long_convolver_worker, lc) != 0) {
+      log_message(LOG_LEVEL_ERROR, "Failed to start convolution worker");
+      long_convolver_free(lc);
+      return -1;
+    }
+    lc->numWorkers++;
+  }
+  return 0;
+}
+
+void long_convolver_free(LongConvolver* lc) {
+  atomic_store_explicit(&lc->running, 0, memory_order_release);
+  pthread_mutex_lock(&lc->lock);
+  pthread_cond_broadcast(&lc->wake);
+  pthread_mutex_unlock(&lc->lock);
+  for (size_t i = 0; i < lc->numWorkers; i++) {
+    pthread_join(lc->workers[i], NULL);
+  }
+  for (size_t k = 0; k < lc->numStages; k++) {
+    long_convolver_stage_free(&lc->stages[k]);
+  }
+  convolver_free(&lc->head);
+  convolver_ir_free(&lc->headIR);
+  pthread_cond_destroy(&lc->wake);
+  pthread_mutex_destroy(&lc->lock);
+  lc->numWorkers = 0;
+  lc->numStages = 0;
+}
+
+// Adds the stage's output for this run if its worker made it in time; returns 1 when the run
+// completed an input block
+static int long_convolver_stage_run(LongConvolver* lc, LongConvolverStage* s, const float* in, float* out, size_t n) {
+  const size_t B = s->blockSize;
+  const uint64_t q = lc->time / B;
+  const size_t pos = (size_t)(lc->time % B);
+  const size_t lag = s->offset / B;
+  const size_t slot = (size_t)(q & (s->ringBlocks - 1)) * B;
+
+  memcpy(s->inRing + slot + pos, in, n * sizeof(float));
+  if (q >= lag) {
+    if (atomic_load_explicit(&s->done, memory_order_acquire) > q - lag) {
+      const float* y = s->outRing + slot + pos;
+      for (size_t i = 0; i < n; i++) {
+        out[i] += y[i];
+      }
+    } else {
+      atomic_fetch_add_explicit(&lc->misses, n, memory_order_relaxed);
+    }
+  }
+  if (pos + n == B) {
+    atomic_store_explicit(&s->submitted, (size_t)q + 1, memory_order_release);
+    return 1;
+  }
+  return 0;
+}
+
+void long_convolver_process(LongConvolver* lc, const float* in, float* out, size_t n) {
+  float staged[LONG_CONV_CHUNK];
+  const size_t minBlock = lc->numStages ? lc->stages[0].blockSize : LONG_CONV_CHUNK;
+  int submitted = 0;
+  size_t done = 0;
+  while (done < n) {
+    size_t run = n - done;
+    size_t left = minBlock - (size_t)(lc->time % minBlock);
+    if (run > left) run = left;
+    // keep the input, in and out may be the same buffer
+    memcpy(staged, in + done, run * sizeof(float));
+    convolver_process(&lc->head, staged, out + done, run);
+    for (size_t k = 0; k < lc->numStages; k++) {
+      submitted |= long_convolver_stage_run(lc, &lc->stages[k], staged, out + done, run);
+    }
+    lc->time += run;
+    done += run;
+  }
+  if (submitted) {
+    long_convolver_wake(lc);
+  }
+}
+
+void long_convolver_sync(LongConvolver* lc) {
+  const struct timespec pause = { 0, 100000L };
+  for (size_t k = 0; k < lc->numStages; k++) {
+    while (long_convolver_stage_pending(&lc->stages[k])) {
+      long_convolver_wake(lc);
+      nanosleep(&pause, NULL);
+    }
+  }
+}
+
+size_t long_convolver_misses(LongConvolver* lc) {
+  return atomic_load_explicit(&lc->misses, memory_order_relaxed);
+}
@@ -0,0 +1,223 @@
+#include <looper.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOOPER_NO_REQUEST (-1)
+// audio starts one page into a backing file, after the header
+#define LOOPER_HEADER_BYTES 4096
+
+static const char looperMagic[8] = { 'G', 'T', 'R', 'L', 'O', 'O', 'P', '1' };
+
+static int looper_map_file(Looper* lp, size_t capacity, float sampleRate, const char* path) {
+  lp->fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (lp->fd < 0) {
+    log_message(LOG_LEVEL_ERROR, "Failed to open looper file %s: %s", path, strerror(errno));
+    return -1;
+  }
+  lp->mappingBytes = LOOPER_HEADER_BYTES + capacity * sizeof(float);
+  struct stat st;
+  if (fstat(lp->fd, &st) != 0 || (size_t)st.st_size < lp->mappingBytes) {
+    // reserve the blocks now where we can; writing into a hole from the callback would make the
+    // filesystem allocate under a page fault
+    int err = -1;
+#ifdef __linux__
+    err = posix_fallocate(lp->fd, 0, (off_t)lp->mappingBytes);
+#endif
+    if (err != 0 && ftruncate(lp->fd, (off_t)lp->mappingBytes) != 0) {
+      log_message(LOG_LEVEL_ERROR, "Failed to size looper file %s: %s", path, strerror(errno));
+      return -1;
+    }
+  }
+  lp->mapping = mmap(NULL, lp->mappingBytes, PROT_READ | PROT_WRITE, MAP_SHARED, lp->fd, 0);
+  if (lp->mapping == MAP_FAILED) {
+    lp->mapping = NULL;
+    log_message(LOG_LEVEL_ERROR, "Failed to map looper file %s: %s", path, strerror(errno));
+    return -1;
+  }
+  lp->header = lp->mapping;
+  lp->loop = (float*)((char*)lp->mapping + LOOPER_HEADER_BYTES);
+
+  LooperFileHeader* h = lp->header;
+  if (memcmp(h->magic, looperMagic, sizeof(looperMagic)) == 0 && h->sampleRate == sampleRate && h->length <= capacity) {
+    lp->length = (size_t)h->length;
+    // the loop is played from the start, so have the kernel start reading it in
+    posix_madvise(lp->loop, lp->length * sizeof(float), POSIX_MADV_WILLNEED);
+  } else {
+    memcpy(h->magic, looperMagic, sizeof(looperMagic));
+    h->length = 0;
+    h->sampleRate = sampleRate;
+  }
+  h->capacity = capacity;
+  return 0;
+}
+
+int looper_init(Looper* lp, size_t capacity, float sampleRate, const char* path) {
+  memset(lp, 0, sizeof(*lp));
+  lp->fd = -1;
+  lp->capacity = capacity;
+  lp->mode = LOOPER_MODE_IDLE;
+  atomic_init(&lp->request, LOOPER_NO_REQUEST);
+  atomic_init(&lp->publishedMode, LOOPER_MODE_IDLE);
+  if (capacity == 0) {
+    log_message(LOG_LEVEL_ERROR, "Looper needs a non-zero capacity");
+    return -1;
+  }
+
+  if (path != NULL) {
+    if (looper_map_file(lp, capacity, sampleRate, path) != 0) {
+      looper_free(lp);
+      return -1;
+    }
+  } else {
+    // pages are only committed once recording reaches them
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif
+    lp->mappingBytes = capacity * sizeof(float);
+    lp->mapping = mmap(NULL, lp->mappingBytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (lp->mapping == MAP_FAILED) {
+      lp->mapping = NULL;
+      log_message(LOG_LEVEL_ERROR, "Failed to map %zu bytes of looper memory", lp->mappingBytes);
+      return -1;
+    }
+    lp->loop = lp->mapping;
+  }
+  posix_madvise(lp->loop, capacity * sizeof(float), POSIX_MADV_SEQUENTIAL);
+  return 0;
+}
+
+void looper_free(Looper* lp) {
+  if (lp->mapping != NULL) {
+    munmap(lp->mapping, lp->mappingBytes);
+  }
+  if (lp->fd >= 0) {
+    close(lp->fd);
+  }
+  lp->mapping = NULL;
+  lp->loop = NULL;
+  lp->header = NULL;
+  lp->fd = -1;
+}
+
+void looper_request(Looper* lp, LooperMode mode) {
+  atomic_store_explicit(&lp->request, (int)mode, memory_order_release);
+}
+
+LooperMode looper_get_mode(Looper* lp) {
+  return (LooperMode)atomic_load_explicit(&lp->publishedMode, memory_order_relaxed);
+}
+
+static void looper_close_recording(Looper* lp) {
+  lp->length = lp->pos;
+  lp->pos = 0;
+  if (lp->header != NULL) {
+    lp->header->length = lp->length;
+  }
+}
+
+static void looper_apply_request(Looper* lp, LooperMode next) {
+  if (next == LOOPER_MODE_RECORD) {
+    lp->mode = LOOPER_MODE_RECORD;
+    lp->pos = 0;
+    lp->length = 0;
+    if (lp->header != NULL) {
+      lp->header->length = 0;
+    }
+    return;
+  }
+  if (lp->mode == LOOPER_MODE_RECORD) {
+    looper_close_recording(lp);
+  }
+  if (next == LOOPER_MODE_IDLE) {
+    lp->pos = 0;
+  }
+  // nothing to play or overdub onto yet
+  lp->mode = lp->length == 0 ? LOOPER_MODE_IDLE : next;
+}
+
+// out = in + loop
+static void looper_play(const float* in, float* out, const float* loop, size_t n) {
+  size_t i = 0;
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde_mm256_storeu_ps(&out[i], simde_mm256_add_ps(simde_mm256_loadu_ps(&in[i]), simde_mm256_loadu_ps(&loop[i])));
+  }
+  for (; i < n; i++) {
+    out[i] = in[i] + loop[i];
+  }
+}
+
+// out = in + loop, then loop = feedback * loop + level * in
+static void looper_overdub(const float* in, float* out, float* loop, size_t n, float feedback, float level) {
+  const simde__m256 vFeedback = simde_mm256_set1_ps(feedback);
+  const simde__m256 vLevel = simde_mm256_set1_ps(level);
+  size_t i = 0;
+  for (; i + SIMD_LANES <= n; i += SIMD_LANES) {
+    simde__m256 x = simde_mm256_loadu_ps(&in[i]);
+    simde__m256 l = simde_mm256_loadu_ps(&loop[i]);
+    simde_mm256_storeu_ps(&out[i], simde_mm256_add_ps(x, l));
+    simde_mm256_storeu_ps(&loop[i], simde_mm256_add_ps(simde_mm256_mul_ps(vFeedback, l), simde_mm256_mul_ps(vLevel, x)));
+  }
+  for (; i < n; i++) {
+    float x = in[i];
+    float l = loop[i];
+    out[i] = x + l;
+    loop[i] = feedback * l + level * x;
+  }
+}
+
+void looper_process(Looper* lp, const float* in, float* out, size_t n, size_t fixedLength, float feedback, float overdubLevel) {
+  int request = atomic_exchange_explicit(&lp->request, LOOPER_NO_REQUEST, memory_order_acquire);
+  if (request != LOOPER_NO_REQUEST) {
+    looper_apply_request(lp, (LooperMode)request);
+  }
+
+  size_t done = 0;
+  while (done < n) {
+    size_t run = n - done;
+    const float* x = in + done;
+    float* y = out + done;
+    if (lp->mode == LOOPER_MODE_RECORD) {
+      size_t limit = fixedLength > 0 && fixedLength < lp->capacity ? fixedLength : lp->capacity;
+      // the length can be shortened under a running recording; whatever was recorded past the
+      // new limit is dropped so the loop still comes out that long
+      if (lp->pos >= limit) {
+        lp->pos = limit;
+        looper_close_recording(lp);
+        lp->mode = LOOPER_MODE_PLAY;
+        continue;
+      }
+      if (run > limit - lp->pos) run = limit - lp->pos;
+      memcpy(lp->loop + lp->pos, x, run * sizeof(float));
+      if (y != x) {
+        memcpy(y, x, run * sizeof(float));
+      }
+      lp->pos += run;
+      if (lp->pos == limit) {
+        looper_close_recording(lp);
+        lp->mode = LOOPER_MODE_PLAY;
+      }
+    } else if (lp->mode == LOOPER_MODE_IDLE) {
+      if (y != x) {
+        memcpy(y, x, run * sizeof(float));
+      }
+    } else {
+      if (run > lp->length - lp->pos) run = lp->length - lp->pos;
+      if (lp->mode == LOOPER_MODE_OVERDUB) {
+        looper_overdub(x, y, lp->loop + lp->pos, run, feedback, overdubLevel);
+      } else {
+        looper_play(x, y, lp->loop + lp->pos, run);
+      }
+      lp->pos += run;
+      if (lp->pos == lp->length) {
+        lp->pos = 0;
+      }
+    }
+    done += run;
+  }
+  atomic_store_explicit(&lp->publishedMode, (int)lp->mode, memory_order_relaxed);
+}
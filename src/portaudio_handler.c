@@ -136,7 +136,7 @@ SoundModifier* create_simple_modifier(float gain, float bass, float mid, float t
 }
 
 SoundModifier* create_advanced_modifier(float threshold, float ratio, float attackTime, 
-                                        float releaseTime, float gain) {
+                                        float releaseTime, float gain, double sampleRate) {
   SoundModifier* modifier = malloc(sizeof(SoundModifier));
   if (modifier == NULL) {
     log_message(LOG_LEVEL_ERROR, "Failed to allocate memory for SoundModifier");
@@ -150,6 +150,9 @@ SoundModifier* create_advanced_modifier(float threshold, float ratio, float atta
   modifier->data.advanced.attackTime = attackTime;
   modifier->data.advanced.releaseTime = releaseTime;
   modifier->data.advanced.gain = gain;
+  // attack and release are in ms, so the coefficients have to be worked out at the stream's rate
+  compressor_init(&modifier->data.advanced.compressor, (float)sampleRate, 0);
+  compressor_set_params(&modifier->data.advanced.compressor, threshold, ratio, COMPRESSOR_KNEE_DB, attackTime, releaseTime, gain);
   
   log_message(LOG_LEVEL_DEBUG, "Created advanced modifier (threshold: %.2f, ratio: %.2f)", 
               threshold, ratio);
@@ -240,10 +243,6 @@ void destroy_sound_effect_chain(SoundEffectChain* chain) {
   log_message(LOG_LEVEL_DEBUG, "Destroyed sound effect chain");
 }
 
-static inline float db_to_linear(float db) {
-  return powf(10.0f, db / 20.0f);
-}
-
 static void apply_simple_modifier(const SimpleSoundModifier* mod, AudioBuffer* buffer) {
   if (mod == NULL || buffer == NULL || buffer->data == NULL) {
     return;
@@ -261,33 +260,33 @@ static void apply_simple_modifier(const SimpleSoundModifier* mod, AudioBuffer* b
   log_message(LOG_LEVEL_TRACE, "Applied simple modifier (gain: %.2f dB)", mod->gain);
 }
 
-static void apply_advanced_modifier(const AdvancedSoundModifier* mod, AudioBuffer* buffer) {
-  if (mod == NULL || buffer == NULL || buffer->data == NULL) {
+// Compressor linked across channels: the loudest channel of each frame drives one gain
+static void apply_advanced_modifier(AdvancedSoundModifier* mod, AudioBuffer* buffer) {
+  if (mod == NULL || buffer == NULL || buffer->data == NULL || buffer->channelCount <= 0) {
     return;
   }
 
-  float threshold_linear = db_to_linear(mod->threshold);
-  float makeup_gain_linear = db_to_linear(mod->gain);
-  
-  // Simple compressor/gate implementation
-  for (unsigned long i = 0; i < buffer->frameCount * buffer->channelCount; i++) {
-    float sample = buffer->data[i];
-    float sample_abs = fabsf(sample);
-    
-    if (sample_abs > threshold_linear) {
-      // Compression
-      float over_threshold = sample_abs - threshold_linear;
-      float compressed = threshold_linear + (over_threshold / mod->ratio);
-      float gain_reduction = compressed / sample_abs;
-      buffer->data[i] = sample * gain_reduction * makeup_gain_linear;
-    } else {
-      // Gate (simple version - could be improved with attack/release)
-      float gate_amount = sample_abs / threshold_linear;
-      buffer->data[i] = sample * gate_amount * makeup_gain_linear;
+  const unsigned long channels = (unsigned long)buffer->channelCount;
+  float key[COMPRESSOR_CHUNK];
+  float gain[COMPRESSOR_CHUNK];
+  for (unsigned long done = 0; done < buffer->frameCount; done += COMPRESSOR_CHUNK) {
+    unsigned long run = buffer->frameCount - done < COMPRESSOR_CHUNK ? buffer->frameCount - done : COMPRESSOR_CHUNK;
+    float* frames = buffer->data + done * channels;
+    for (unsigned long i = 0; i < run; i++) {
+      float peak = 0.0f;
+      for (unsigned long ch = 0; ch < channels; ch++) {
+        peak = fmaxf(peak, fabsf(frames[i * channels + ch]));
+      }
+      key[i] = peak;
+    }
+    compressor_compute_gain(&mod->compressor, key, gain, run);
+    for (unsigned long i = 0; i < run; i++) {
+      for (unsigned long ch = 0; ch < channels; ch++) {
+        frames[i * channels + ch] *= gain[i];
+      }
     }
   }
 
-  // Note: Proper implementation would include envelope followers for attack/release
   log_message(LOG_LEVEL_TRACE, "Applied advanced modifier (threshold: %.2f dB)", 
               mod->threshold);
 }
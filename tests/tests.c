@@ -1,7 +1,13 @@
 #include <logger.h>
 #include <portaudio.h>
 #include <effects_dsp.h>
+#include <effects_interface.h>
+#include <amp.h>
+#include <long_convolver.h>
+#include <looper.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 void test_log_message() {
   char * message = "Test log message";
@@ -165,9 +171,1644 @@ int get_simd_width() {
   return SIMD_WIDTH;
 }
 
+static float max_abs_diff(const float* a, const float* b, size_t n) {
+  float worst = 0.0f;
+  for (size_t i = 0; i < n; i++) {
+    float d = fabsf(a[i] - b[i]);
+    if (d > worst) worst = d;
+  }
+  return worst;
+}
+
+// power of x at freqHz, Hann-windowed
+static double tone_power(const float* x, size_t n, double freqHz, double sampleRate) {
+  double re = 0.0;
+  double im = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double w = 0.5 - 0.5 * cos(2.0 * M_PI * (double)i / (double)n);
+    re += w * x[i] * cos(2.0 * M_PI * freqHz * (double)i / sampleRate);
+    im += w * x[i] * sin(2.0 * M_PI * freqHz * (double)i / sampleRate);
+  }
+  return re * re + im * im;
+}
+
+int test_filter_banks_match_scalar() {
+  enum { CHANNELS = 11, FRAMES = 256 };
+  const float sampleRate = 48000.0f;
+  float in[CHANNELS * FRAMES];
+  float bankOut[CHANNELS * FRAMES];
+  float chIn[FRAMES];
+  float chOut[FRAMES];
+  float expected[CHANNELS * FRAMES];
+  int failures = 0;
+
+  for (size_t i = 0; i < CHANNELS * FRAMES; i++) {
+    in[i] = sinf(0.013f * (float)i) * 0.8f + 0.1f * cosf(0.37f * (float)i);
+  }
+
+  BiquadBank bqBank;
+  Biquad bq[CHANNELS];
+  biquad_bank_init(&bqBank, CHANNELS);
+  OnePoleBank opBank;
+  OnePole op[CHANNELS];
+  onepole_bank_init(&opBank, CHANNELS);
+  AllPassBank apBank;
+  AllPass1 ap[CHANNELS];
+  allpass_bank_init(&apBank, CHANNELS);
+  EnvelopeBank envBank;
+  EnvelopeDetector ed[CHANNELS];
+  envelope_bank_init(&envBank, CHANNELS);
+
+  for (size_t ch = 0; ch < CHANNELS; ch++) {
+    float freq = 200.0f + 350.0f * (float)ch;
+    biquad_bank_set_channel(&bqBank, ch, (BiquadType)(ch % 7), freq, 0.9f, 4.0f, sampleRate);
+    biquad_init(&bq[ch], (BiquadType)(ch % 7), freq, 0.9f, 4.0f, sampleRate);
+    onepole_bank_set_channel(&opBank, ch, freq, sampleRate, (int)(ch & 1));
+    onepole_init(&op[ch], freq, sampleRate, (int)(ch & 1));
+    allpass_bank_set_channel(&apBank, ch, 0.1f * (float)ch - 0.5f);
+    allpass1_init(&ap[ch], 0.1f * (float)ch - 0.5f);
+    envelope_bank_set_channel(&envBank, ch, 1.0f, 50.0f, sampleRate, (int)(ch & 1));
+    env_init(&ed[ch], 1.0f, 50.0f, sampleRate, (int)(ch & 1));
+  }
+
+  for (int kind = 0; kind < 4; kind++) {
+    for (size_t ch = 0; ch < CHANNELS; ch++) {
+      for (size_t n = 0; n < FRAMES; n++) chIn[n] = in[n * CHANNELS + ch];
+      switch (kind) {
+        case 0: biquad_process(&bq[ch], chIn, chOut, FRAMES); break;
+        case 1: onepole_process(&op[ch], chIn, chOut, FRAMES); break;
+        case 2: allpass1_process(&ap[ch], chIn, chOut, FRAMES); break;
+        default: env_process(&ed[ch], chIn, chOut, FRAMES); break;
+      }
+      for (size_t n = 0; n < FRAMES; n++) expected[n * CHANNELS + ch] = chOut[n];
+    }
+    switch (kind) {
+      case 0: biquad_bank_process(&bqBank, in, bankOut, FRAMES); break;
+      case 1: onepole_bank_process(&opBank, in, bankOut, FRAMES); break;
+      case 2: allpass_bank_process(&apBank, in, bankOut, FRAMES); break;
+      default: envelope_bank_process(&envBank, in, bankOut, FRAMES); break;
+    }
+    float err = max_abs_diff(expected, bankOut, CHANNELS * FRAMES);
+    if (err > 1e-5f) {
+      log_message(LOG_LEVEL_ERROR, "Filter bank %d deviates from scalar kernel by %g", kind, err);
+      failures++;
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Filter bank test: %d failures", failures);
+  return failures;
+}
+
+int test_block_iir_matches_scalar() {
+  enum { FRAMES = 1029 };
+  const float sampleRate = 48000.0f;
+  float in[FRAMES];
+  float expected[FRAMES];
+  float blockOut[FRAMES];
+  int failures = 0;
+
+  for (size_t i = 0; i < FRAMES; i++) {
+    in[i] = sinf(0.021f * (float)i) * 0.7f + 0.2f * sinf(1.7f * (float)i);
+  }
+
+  for (int t = BQ_LPF; t <= BQ_HIGHSHELF; t++) {
+    Biquad ref, blk;
+    IIRBlockMatrix m;
+    biquad_init(&ref, (BiquadType)t, 120.0f + 900.0f * (float)t, 2.0f, -6.0f, sampleRate);
+    blk = ref;
+    biquad_block_prepare(&m, &blk);
+    biquad_process(&ref, in, expected, FRAMES);
+    // odd split so both the vector path and the scalar tail carry state across calls
+    biquad_process_block(&blk, &m, in, blockOut, 515);
+    biquad_process_block(&blk, &m, in + 515, blockOut + 515, FRAMES - 515);
+    float err = max_abs_diff(expected, blockOut, FRAMES);
+    if (err > 1e-4f) {
+      log_message(LOG_LEVEL_ERROR, "Block biquad type %d deviates by %g", t, err);
+      failures++;
+    }
+  }
+
+  OnePole opRef, opBlk;
+  IIRBlockMatrix opM;
+  onepole_init(&opRef, 800.0f, sampleRate, 1);
+  opBlk = opRef;
+  onepole_block_prepare(&opM, &opBlk);
+  onepole_process(&opRef, in, expected, FRAMES);
+  memcpy(blockOut, in, sizeof(in));
+  onepole_process_block(&opBlk, &opM, blockOut, blockOut, FRAMES);
+  if (max_abs_diff(expected, blockOut, FRAMES) > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "Block one-pole deviates from scalar kernel");
+    failures++;
+  }
+
+  AllPass1 apRef, apBlk;
+  IIRBlockMatrix apM;
+  allpass1_init(&apRef, 0.6f);
+  apBlk = apRef;
+  allpass1_block_prepare(&apM, &apBlk);
+  allpass1_process(&apRef, in, expected, FRAMES);
+  allpass1_process_block(&apBlk, &apM, in, blockOut, FRAMES);
+  if (max_abs_diff(expected, blockOut, FRAMES) > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "Block all-pass deviates from scalar kernel");
+    failures++;
+  }
+
+  log_message(LOG_LEVEL_INFO, "Block IIR test: %d failures", failures);
+  return failures;
+}
+
+int test_oversampler_round_trip() {
+  enum { FRAMES = 2048, SETTLE = 256, IMPULSE = 256 };
+  static float in[FRAMES];
+  static float up[FRAMES * 8];
+  static float back[FRAMES];
+  const size_t factors[3] = { 2, 4, 8 };
+  Oversampler os;
+  int failures = 0;
+
+  for (size_t f = 0; f < 3; f++) {
+    const size_t factor = factors[f];
+    if (oversampler_init(&os, factor, 32) != 0) {
+      failures++;
+      continue;
+    }
+    // the stages are linear phase, so the impulse's centre of mass is the exact round-trip delay;
+    // the inner stages of 4x and 8x make it fractional, which the reported latency rounds
+    memset(in, 0, IMPULSE * sizeof(float));
+    in[0] = 1.0f;
+    oversampler_upsample(&os, in, up, IMPULSE);
+    oversampler_downsample(&os, up, back, IMPULSE);
+    double mass = 0.0;
+    double moment = 0.0;
+    for (size_t i = 0; i < IMPULSE; i++) {
+      mass += back[i];
+      moment += (double)i * back[i];
+    }
+    const double delay = moment / mass;
+    const size_t latency = oversampler_latency(&os);
+    if (fabs(mass - 1.0) > 1e-3 || fabs(delay - (double)latency) > 0.501) {
+      log_message(LOG_LEVEL_ERROR, "%zux round trip: gain %g, delay %g, reported latency %zu", factor, mass, delay, latency);
+      failures++;
+    }
+
+    // slow chirp well inside the passband, split unevenly across calls
+    oversampler_reset(&os);
+    for (size_t i = 0; i < FRAMES; i++) {
+      in[i] = sinf(2.0f * M_PI * (200.0f + (float)i) * (float)i / 48000.0f);
+    }
+    oversampler_upsample(&os, in, up, 1000);
+    oversampler_upsample(&os, in + 1000, up + 1000 * factor, FRAMES - 1000);
+    oversampler_downsample(&os, up, back, FRAMES);
+    float err = 0.0f;
+    for (size_t i = SETTLE; i < FRAMES; i++) {
+      const double t = (double)i - delay;
+      err = fmaxf(err, fabsf(back[i] - (float)sin(2.0 * M_PI * (200.0 + t) * t / 48000.0)));
+    }
+    if (err > 1e-3f) {
+      log_message(LOG_LEVEL_ERROR, "%zux round trip deviates by %g at delay %g", factor, err, delay);
+      failures++;
+    }
+
+    // decimation: tones above the base rate's Nyquist must not fold back into the output
+    const double rate = 48000.0 * (double)factor;
+    float worst = -INFINITY;
+    for (double hz = 30000.0; hz < 0.5 * rate - 2000.0; hz += 8000.0) {
+      for (size_t i = 0; i < FRAMES * factor; i++) {
+        up[i] = (float)sin(2.0 * M_PI * hz * (double)i / rate);
+      }
+      oversampler_reset(&os);
+      oversampler_downsample(&os, up, back, FRAMES);
+      const double alias = fabs(hz - 48000.0 * round(hz / 48000.0));
+      const double n = (double)(FRAMES - SETTLE);
+      // a full-scale tone through the Hann window has power (n / 4)^2
+      const float db = (float)(10.0 * log10(tone_power(back + SETTLE, FRAMES - SETTLE, alias, 48000.0) / (n * n / 16.0)));
+      worst = fmaxf(worst, db);
+    }
+    if (worst > -70.0f) {
+      log_message(LOG_LEVEL_ERROR, "%zux decimation lets through a tone above Nyquist at %g dB", factor, worst);
+      failures++;
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Oversampler test: %d failures", failures);
+  return failures;
+}
+
+// the figures the design is meant to hit: 8 coefficients at 0.05 transition bandwidth reject
+// images by at least 70 dB up to 19 kHz at 48 kHz, with a group delay of a few samples
+int test_iir_halfband() {
+  enum { N = 8192, SETTLE = 1024, IMPULSE = 512 };
+  static float in[N];
+  static float up[2 * N];
+  static float back[N];
+  const float freqs[] = { 100.0f, 1000.0f, 5000.0f, 10000.0f, 15000.0f, 19000.0f };
+  IIRHalfband upsampler;
+  IIRHalfband downsampler;
+  int failures = 0;
+
+  // round trip of an impulse: unity gain and a short delay at DC
+  iir_halfband_init(&upsampler, 8, 0.05f);
+  iir_halfband_init(&downsampler, 8, 0.05f);
+  memset(in, 0, IMPULSE * sizeof(float));
+  in[0] = 1.0f;
+  iir_halfband_upsample2x(&upsampler, in, up, IMPULSE);
+  iir_halfband_downsample2x(&downsampler, up, back, IMPULSE);
+  double sum = 0.0;
+  double moment = 0.0;
+  for (size_t i = 0; i < IMPULSE; i++) {
+    sum += back[i];
+    moment += (double)i * back[i];
+  }
+  const double delay = moment / sum;
+  if (fabs(sum - 1.0) > 1e-3 || delay < 1.0 || delay > 6.0) {
+    log_message(LOG_LEVEL_ERROR, "IIR half-band round trip: DC gain %g, group delay %g samples", sum, delay);
+    failures++;
+  }
+
+  float worstImage = -INFINITY;
+  for (size_t k = 0; k < sizeof(freqs) / sizeof(freqs[0]); k++) {
+    const float f = freqs[k];
+    iir_halfband_init(&upsampler, 8, 0.05f);
+    iir_halfband_init(&downsampler, 8, 0.05f);
+    for (size_t i = 0; i < N; i++) {
+      in[i] = sinf(2.0f * (float)M_PI * f * (float)i / 48000.0f);
+    }
+    // uneven blocks, so the state carried between calls is exercised too
+    iir_halfband_upsample2x(&upsampler, in, up, 1000);
+    iir_halfband_upsample2x(&upsampler, in + 1000, up + 2000, N - 1000);
+    iir_halfband_downsample2x(&downsampler, up, back, N);
+
+    // the image of f lands at 48 kHz - f at the doubled rate
+    const double tone = tone_power(up + 2 * SETTLE, 2 * (N - SETTLE), f, 96000.0);
+    const double image = tone_power(up + 2 * SETTLE, 2 * (N - SETTLE), 48000.0f - f, 96000.0);
+    const float rejectionDb = (float)(10.0 * log10(image / tone));
+    worstImage = fmaxf(worstImage, rejectionDb);
+    const float roundTripDb = (float)(10.0 * log10(tone_power(back + SETTLE, N - SETTLE, f, 48000.0) / tone_power(in + SETTLE, N - SETTLE, f, 48000.0)));
+    if (rejectionDb > -70.0f || fabsf(roundTripDb) > 0.01f) {
+      log_message(LOG_LEVEL_ERROR, "IIR half-band at %g Hz: image %g dB, round trip %g dB", f, rejectionDb, roundTripDb);
+      failures++;
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "IIR half-band test: %d failures (group delay %.2f samples, worst image %.1f dB)", failures, delay, worstImage);
+  return failures;
+}
+
+int test_waveshaper_nonfinite_inputs() {
+  enum { SIZE = 64, N = 13 };
+  float table[SIZE];
+  float padded[WAVESHAPER_PADDED_SIZE(SIZE)];
+  float in[N];
+  float out[N];
+  int failures = 0;
+
+  build_waveshaper_table(table, SIZE, CLIP_SOFT_TANH, 2.0f);
+  waveshaper_pad_table(padded, table, SIZE);
+  // a full SIMD block and a scalar tail, both with every kind of non-finite input
+  const float specials[3] = { NAN, INFINITY, -INFINITY };
+  for (size_t i = 0; i < N; i++) {
+    in[i] = specials[i % 3];
+  }
+  for (int variant = 0; variant < 4; variant++) {
+    switch (variant) {
+      case 0: waveshaper_lookup(in, out, table, SIZE, N); break;
+      case 1: waveshaper_lookup_linear(in, out, table, SIZE, N); break;
+      case 2: waveshaper_lookup_cubic(in, out, table, SIZE, N); break;
+      default: waveshaper_lookup_cubic_padded(in, out, padded, SIZE, N); break;
+    }
+    // NaN clamps low like fmaxf, the infinities to their ends
+    for (size_t i = 0; i < N; i++) {
+      float expected = isinf(in[i]) && in[i] > 0.0f ? table[SIZE - 1] : table[0];
+      if (!(fabsf(out[i] - expected) <= 1e-6f)) {
+        log_message(LOG_LEVEL_ERROR, "waveshaper variant %d: input %g gave %g, expected %g", variant, in[i], out[i], expected);
+        failures++;
+        break;
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Waveshaper non-finite input test: %d failures", failures);
+  return failures;
+}
+
+// the static curves the ADAA kernels integrate, shape(u) with u = drive * x
+static double adaa_reference_curve(ClipperType type, double u) {
+  switch (type) {
+    case CLIP_HARD: return fmax(-1.0, fmin(1.0, u));
+    case CLIP_SOFT_TANH: return tanh(u);
+    case CLIP_ARCTAN: return (2.0 / M_PI) * atan(u);
+    case CLIP_SIGMOID: return tanh(0.5 * u);
+    default: return fabs(u) > 1.0 ? (u < 0.0 ? -1.0 : 1.0) : 1.5 * (u - u * u * u / 3.0);
+  }
+}
+
+int test_adaa_clippers() {
+  enum { N = 4800, BLOCKS = 6 };
+  static float in[N];
+  static float out[N];
+  static float split[N];
+  const ClipperType types[] = { CLIP_HARD, CLIP_SOFT_TANH, CLIP_ARCTAN, CLIP_SIGMOID, CLIP_CUBIC_SOFT };
+  const size_t blockSizes[BLOCKS] = { 1, 3, 7, 64, 100, 257 };
+  const float drive = 2.0f;
+  const float f = 20.0f;
+  NoiseGen gen;
+  int failures = 0;
+  float worstCurve = 0.0f;
+
+  for (int order = 1; order <= 2; order++) {
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+      const ClipperType type = types[t];
+      ADAAClipper clip;
+
+      // a slow sine sits on the static curve, delayed by half a sample per order, once the first
+      // few samples (run as if the input had been silent before) are past
+      adaa_clipper_init(&clip, type, drive, order);
+      for (size_t i = 0; i < N; i++) {
+        in[i] = 1.5f * sinf(2.0f * (float)M_PI * f * (float)i / 48000.0f);
+      }
+      adaa_clipper_process(&clip, in, out, N);
+      float err = 0.0f;
+      for (size_t i = 4; i < N; i++) {
+        double x = 1.5 * sin(2.0 * M_PI * f * ((double)i - 0.5 * order) / 48000.0);
+        err = fmaxf(err, fabsf(out[i] - (float)adaa_reference_curve(type, drive * x)));
+      }
+      worstCurve = fmaxf(worstCurve, err);
+      if (err > 1e-3f) {
+        log_message(LOG_LEVEL_ERROR, "ADAA order %d type %d: %g off the static curve", order, (int)type, err);
+        failures++;
+      }
+
+      // a held input never divides by the vanishing step; it settles exactly on the curve
+      adaa_clipper_reset(&clip);
+      for (size_t i = 0; i < 16; i++) {
+        in[i] = 0.4f;
+      }
+      adaa_clipper_process(&clip, in, out, 16);
+      const float held = (float)adaa_reference_curve(type, drive * 0.4);
+      if (!(fabsf(out[15] - held) <= 1e-6f)) {
+        log_message(LOG_LEVEL_ERROR, "ADAA order %d type %d: held input gave %g, expected %g", order, (int)type, out[15], held);
+        failures++;
+      }
+
+      // alternating input makes u equal u2 on every step; order 2's midpoint expansion there has
+      // to agree with the regular path a hair away from it
+      if (order == 2) {
+        float expanded[16];
+        adaa_clipper_reset(&clip);
+        for (size_t i = 0; i < 16; i++) {
+          in[i] = (i & 1) ? -0.3f : 0.5f;
+        }
+        adaa_clipper_process(&clip, in, expanded, 16);
+        adaa_clipper_reset(&clip);
+        for (size_t i = 0; i < 16; i++) {
+          in[i] = (i & 1) ? -0.3f : 0.5f + 1e-4f * (float)(i & 2);
+        }
+        adaa_clipper_process(&clip, in, out, 16);
+        float gap = 0.0f;
+        for (size_t i = 4; i < 16; i++) {
+          gap = fmaxf(gap, isfinite(expanded[i]) ? fabsf(expanded[i] - out[i]) : INFINITY);
+        }
+        if (!(gap <= 2e-3f)) {
+          log_message(LOG_LEVEL_ERROR, "ADAA type %d: midpoint expansion off the regular path by %g", (int)type, gap);
+          failures++;
+        }
+      }
+
+      // the state carries everything, so where the blocks split doesn't matter
+      noise_seed(&gen, 23);
+      white_noise(&gen, in, N);
+      for (size_t i = 0; i < N; i++) {
+        in[i] *= 2.0f;
+      }
+      adaa_clipper_reset(&clip);
+      adaa_clipper_process(&clip, in, out, N);
+      for (size_t b = 0; b < BLOCKS; b++) {
+        adaa_clipper_reset(&clip);
+        for (size_t i = 0; i < N; i += blockSizes[b]) {
+          adaa_clipper_process(&clip, in + i, split + i, N - i < blockSizes[b] ? N - i : blockSizes[b]);
+        }
+        if (memcmp(out, split, sizeof(out)) != 0) {
+          log_message(LOG_LEVEL_ERROR, "ADAA order %d type %d: blocks of %zu differ from one pass", order, (int)type, blockSizes[b]);
+          failures++;
+        }
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "ADAA clipper test: %d failures (worst static curve error %.2e)", failures, worstCurve);
+  return failures;
+}
+
+typedef simde__m256 (*FastMathFn)(simde__m256, FastMathTier);
+
+static simde__m256 fast_exp_fn(simde__m256 x, FastMathTier t) { return fast_exp_ps(x, t); }
+static simde__m256 fast_log_fn(simde__m256 x, FastMathTier t) { return fast_log_ps(x, t); }
+static simde__m256 fast_sin_fn(simde__m256 x, FastMathTier t) { return fast_sin_ps(x, t); }
+static simde__m256 fast_atan_fn(simde__m256 x, FastMathTier t) { return fast_atan_ps(x, t); }
+static simde__m256 fast_tanh_fn(simde__m256 x, FastMathTier t) { return fast_tanh_ps(x, t); }
+
+// sweeps each approximation against libm and checks the bounds documented in fast_math.h
+int test_fast_math_error_bounds() {
+  const struct {
+    const char* name;
+    FastMathFn fn;
+    double (*ref)(double);
+    double lo, hi;
+    int logSweep;
+    int relative;
+    double bound[3];
+  } cases[] = {
+    { "exp", fast_exp_fn, exp, -87.0, 88.0, 0, 1, { 1.3e-4, 6e-6, 3e-7 } },
+    { "log", fast_log_fn, log, 1e-6, 1e6, 1, 0, { 1e-5, 1.5e-6, 1.5e-6 } },
+    { "sin", fast_sin_fn, sin, -1e4, 1e4, 0, 0, { 1.2e-4, 1.5e-6, 3e-7 } },
+    { "atan", fast_atan_fn, atan, -1e6, 1e6, 0, 0, { 2.8e-4, 7e-6, 4e-7 } },
+    { "tanh", fast_tanh_fn, tanh, -20.0, 20.0, 0, 0, { 6e-5, 2e-6, 2e-7 } },
+  };
+  const size_t points = 1 << 20;
+  int failures = 0;
+
+  for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+    for (int tier = FAST_MATH_FAST; tier <= FAST_MATH_PRECISE; tier++) {
+      double worst = 0.0;
+      for (size_t i = 0; i < points; i += SIMD_LANES) {
+        float x[SIMD_LANES];
+        float y[SIMD_LANES];
+        for (size_t j = 0; j < SIMD_LANES; j++) {
+          double u = (double)(i + j) / (double)points;
+          x[j] = cases[c].logSweep
+            ? (float)exp(log(cases[c].lo) + u * (log(cases[c].hi) - log(cases[c].lo)))
+            : (float)(cases[c].lo + u * (cases[c].hi - cases[c].lo));
+          // every other vector sweeps the same range scaled towards zero
+          if ((i / SIMD_LANES) & 1 && !cases[c].logSweep) x[j] *= 1e-3f;
+        }
+        simde_mm256_storeu_ps(y, cases[c].fn(simde_mm256_loadu_ps(x), (FastMathTier)tier));
+        for (size_t j = 0; j < SIMD_LANES; j++) {
+          double expected = cases[c].ref((double)x[j]);
+          double err = fabs((double)y[j] - expected);
+          if (cases[c].relative) err /= fabs(expected);
+          if (err > worst) worst = err;
+        }
+      }
+      log_message(LOG_LEVEL_DEBUG, "fast %s tier %d: max error %.3g (bound %.3g)", cases[c].name, tier, worst, cases[c].bound[tier]);
+      if (worst > cases[c].bound[tier]) {
+        log_message(LOG_LEVEL_ERROR, "fast %s tier %d exceeds its bound: %.3g > %.3g", cases[c].name, tier, worst, cases[c].bound[tier]);
+        failures++;
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Fast math test: %d failures", failures);
+  return failures;
+}
+
+// the power-of-two delay line must read back exactly what the modulo one does
+int test_delayline_pow2_matches_legacy() {
+  enum { SIZE = 1024, BLOCK = 67, BLOCKS = 40 };
+  static float legacyMem[SIZE];
+  static float pow2Mem[SIZE + DELAYLINE_GUARD];
+  static float in[BLOCK];
+  static float ref[BLOCK];
+  static float out[BLOCK];
+  const float delays[] = { 0.0f, 1.0f, 2.5f, 63.25f, 500.75f, 1020.0f };
+  DelayLine legacy;
+  DelayLine pow2;
+  int failures = 0;
+
+  if (delayline_pow2_buffer_size(1000) != SIZE + DELAYLINE_GUARD) {
+    return 1;
+  }
+  delayline_init(&legacy, legacyMem, SIZE, 48000.0f);
+  delayline_init_pow2(&pow2, pow2Mem, 1000, 48000.0f);
+
+  for (size_t b = 0; b < BLOCKS; b++) {
+    for (size_t i = 0; i < BLOCK; i++) {
+      in[i] = sinf(0.05f * (float)(b * BLOCK + i)) + 0.1f * (float)(i & 3);
+    }
+    delayline_write(&legacy, in, BLOCK);
+    delayline_write(&pow2, in, BLOCK);
+    for (size_t d = 0; d < sizeof(delays) / sizeof(delays[0]); d++) {
+      delayline_read_linear(&legacy, ref, BLOCK, delays[d]);
+      delayline_read_linear(&pow2, out, BLOCK, delays[d]);
+      if (max_abs_diff(ref, out, BLOCK) > 1e-5f) {
+        log_message(LOG_LEVEL_ERROR, "linear read at delay %g differs in block %zu", delays[d], b);
+        failures++;
+      }
+      delayline_read_cubic(&legacy, ref, BLOCK, delays[d]);
+      delayline_read_cubic(&pow2, out, BLOCK, delays[d]);
+      if (max_abs_diff(ref, out, BLOCK) > 1e-5f) {
+        log_message(LOG_LEVEL_ERROR, "cubic read at delay %g differs in block %zu", delays[d], b);
+        failures++;
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Delay line test: %d failures", failures);
+  return failures;
+}
+
+// constant delays must match the block reads, and a swept delay must track a slow sine for every
+// interpolation type
+int test_delayline_read_modulated() {
+  enum { BLOCK = 61, BLOCKS = 60 };
+  static float mem[1024 + DELAYLINE_GUARD];
+  static float in[BLOCK];
+  static float delays[BLOCK];
+  static float ref[BLOCK];
+  static float out[BLOCK];
+  const float w = 0.01f;
+  DelayLine dl;
+  float allpassState = 0.0f;
+  int failures = 0;
+
+  delayline_init_pow2(&dl, mem, 1024, 48000.0f);
+  for (size_t b = 0; b < BLOCKS; b++) {
+    for (size_t i = 0; i < BLOCK; i++) {
+      in[i] = sinf(w * (float)(b * BLOCK + i));
+    }
+    delayline_write(&dl, in, BLOCK);
+
+    for (size_t i = 0; i < BLOCK; i++) {
+      delays[i] = 37.3f;
+    }
+    delayline_read_cubic(&dl, ref, BLOCK, 37.3f + BLOCK);
+    delayline_read_modulated(&dl, out, delays, BLOCK, DELAY_INTERP_CUBIC, NULL);
+    if (max_abs_diff(ref, out, BLOCK) > 1e-5f) {
+      log_message(LOG_LEVEL_ERROR, "modulated cubic read differs from block read in block %zu", b);
+      failures++;
+    }
+    delayline_read_linear(&dl, ref, BLOCK, 37.3f + BLOCK);
+    delayline_read_modulated(&dl, out, delays, BLOCK, DELAY_INTERP_LINEAR, NULL);
+    if (max_abs_diff(ref, out, BLOCK) > 1e-5f) {
+      log_message(LOG_LEVEL_ERROR, "modulated linear read differs from block read in block %zu", b);
+      failures++;
+    }
+
+    // Thiran keeps state, so it gets a steady delay; the others get a sweep
+    for (size_t i = 0; i < BLOCK; i++) {
+      delays[i] = 20.25f;
+    }
+    delayline_read_modulated(&dl, out, delays, BLOCK, DELAY_INTERP_THIRAN, &allpassState);
+    for (size_t i = 0; i < BLOCK; i++) {
+      ref[i] = sinf(w * ((float)(b * BLOCK + i) - delays[i]));
+    }
+    if (b > 20 && max_abs_diff(ref, out, BLOCK) > 1e-3f) {
+      log_message(LOG_LEVEL_ERROR, "Thiran read misses the target delay in block %zu", b);
+      failures++;
+    }
+
+    for (size_t i = 0; i < BLOCK; i++) {
+      delays[i] = 300.0f + 250.0f * sinf(0.001f * (float)(b * BLOCK + i));
+      ref[i] = sinf(w * ((float)(b * BLOCK + i) - delays[i]));
+    }
+    if (b > 10) {
+      const DelayInterpType types[] = { DELAY_INTERP_LINEAR, DELAY_INTERP_CUBIC, DELAY_INTERP_LAGRANGE };
+      for (size_t k = 0; k < 3; k++) {
+        delayline_read_modulated(&dl, out, delays, BLOCK, types[k], NULL);
+        if (max_abs_diff(ref, out, BLOCK) > 1e-3f) {
+          log_message(LOG_LEVEL_ERROR, "modulated read type %d misses the target delay in block %zu", (int)types[k], b);
+          failures++;
+        }
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Modulated delay test: %d failures", failures);
+  return failures;
+}
+
+// every LFO kernel has to follow its waveform formula at audio rate, and control rate has to stay
+// close to it for a slow sine
+int test_lfo_kernels() {
+  enum { BLOCK = 100, BLOCKS = 50 };
+  static float out[BLOCK];
+  const float sampleRate = 48000.0f;
+  const float freq = 3.7f;
+  const LFOType types[] = { LFO_SINE, LFO_TRI, LFO_SAW, LFO_SQUARE };
+  int failures = 0;
+
+  for (size_t k = 0; k < sizeof(types) / sizeof(types[0]); k++) {
+    for (int control = 0; control < 2; control++) {
+      LFO lfo;
+      lfo_init(&lfo, types[k], freq, 0.5f, 0.25f, sampleRate);
+      if (control) {
+        if (types[k] != LFO_SINE) continue;
+        lfo_set_control_rate(&lfo, 32);
+      }
+      float worst = 0.0f;
+      for (size_t b = 0; b < BLOCKS; b++) {
+        lfo_process(&lfo, out, BLOCK);
+        for (size_t i = 0; i < BLOCK; i++) {
+          double phase = fmod((double)(b * BLOCK + i) * freq / sampleRate, 1.0);
+          double ref;
+          switch (types[k]) {
+            case LFO_SINE: ref = sin(2.0 * M_PI * phase); break;
+            case LFO_TRI: ref = 1.0 - 4.0 * fabs(phase - 0.5); break;
+            case LFO_SAW: ref = 2.0 * phase - 1.0; break;
+            default:
+              // skip samples right at the edges, where rounding may land either side
+              if (fabs(phase - 0.5) < 1e-4 || phase < 1e-4 || phase > 1.0 - 1e-4) continue;
+              ref = phase < 0.5 ? 1.0 : -1.0;
+              break;
+          }
+          // the saw jumps at the wrap, compare there modulo one period
+          float err = fabsf(out[i] - (float)(ref * 0.5 + 0.25));
+          if (types[k] == LFO_SAW && err > 0.5f) err = fabsf(err - 1.0f);
+          if (err > worst) worst = err;
+        }
+      }
+      if (worst > 1e-3f) {
+        log_message(LOG_LEVEL_ERROR, "LFO type %d (control rate %d) deviates by %g", (int)types[k], control, worst);
+        failures++;
+      }
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "LFO test: %d failures", failures);
+  return failures;
+}
+
+// checks the moments of both noise modes and that equal seeds reproduce the same stream
+int test_noise_generators() {
+  enum { N = 1 << 16 };
+  static float a[N];
+  static float b[N];
+  NoiseGen gen1;
+  NoiseGen gen2;
+  int failures = 0;
+
+  noise_seed(&gen1, 1234);
+  noise_seed(&gen2, 1234);
+  white_noise(&gen1, a, N);
+  white_noise(&gen2, b, N);
+  if (memcmp(a, b, sizeof(a)) != 0) {
+    log_message(LOG_LEVEL_ERROR, "equal seeds produced different white noise");
+    failures++;
+  }
+  double mean = 0.0, var = 0.0;
+  float lo = 1.0f, hi = -1.0f;
+  for (size_t i = 0; i < N; i++) {
+    mean += a[i];
+    var += (double)a[i] * a[i];
+    lo = fminf(lo, a[i]);
+    hi = fmaxf(hi, a[i]);
+  }
+  mean /= N;
+  var = var / N - mean * mean;
+  if (lo < -1.0f || hi >= 1.0f || fabs(mean) > 0.01 || fabs(var - 1.0 / 3.0) > 0.01) {
+    log_message(LOG_LEVEL_ERROR, "white noise stats off: range [%g, %g], mean %g, var %g", lo, hi, mean, var);
+    failures++;
+  }
+
+  noise_seed(&gen2, 1235);
+  white_noise(&gen2, b, N);
+  if (memcmp(a, b, sizeof(a)) == 0) {
+    log_message(LOG_LEVEL_ERROR, "different seeds produced the same white noise");
+    failures++;
+  }
+
+  gaussian_noise(&gen1, a, N - 3);
+  mean = 0.0;
+  var = 0.0;
+  for (size_t i = 0; i < N - 3; i++) {
+    if (!isfinite(a[i])) {
+      log_message(LOG_LEVEL_ERROR, "gaussian noise produced a non-finite sample");
+      failures++;
+      break;
+    }
+    mean += a[i];
+    var += (double)a[i] * a[i];
+  }
+  mean /= N - 3;
+  var = var / (N - 3) - mean * mean;
+  if (fabs(mean) > 0.02 || fabs(var - 1.0) > 0.03) {
+    log_message(LOG_LEVEL_ERROR, "gaussian noise stats off: mean %g, var %g", mean, var);
+    failures++;
+  }
+
+  log_message(LOG_LEVEL_INFO, "Noise test: %d failures", failures);
+  return failures;
+}
+
+// forward transform against a double precision DFT, and round trips through every variant
+int test_fft_matches_dft() {
+  enum { MAX_N = 4096 };
+  static float x[MAX_N];
+  static float spec[MAX_N];
+  static float back[MAX_N];
+  NoiseGen gen;
+  int failures = 0;
+
+  noise_seed(&gen, 7);
+  for (size_t n = FFT_MIN_SIZE; n <= MAX_N; n *= 4) {
+    const FFTPlan* plan = fft_plan_get(n);
+    if (plan == NULL || fft_plan_get(n) != plan) {
+      log_message(LOG_LEVEL_ERROR, "FFT plan for %zu is missing or not cached", n);
+      failures++;
+      continue;
+    }
+    white_noise(&gen, x, n);
+    fft_forward(plan, x, spec);
+
+    double worst = 0.0;
+    for (size_t k = 0; k <= n / 2; k++) {
+      double re = 0.0, im = 0.0;
+      for (size_t t = 0; t < n; t++) {
+        double w = -2.0 * M_PI * (double)((k * t) % n) / (double)n;
+        re += x[t] * cos(w);
+        im += x[t] * sin(w);
+      }
+      double gotRe = k == 0 ? spec[0] : k == n / 2 ? spec[1] : spec[2 * k];
+      double gotIm = (k == 0 || k == n / 2) ? 0.0 : spec[2 * k + 1];
+      worst = fmax(worst, hypot(gotRe - re, gotIm - im) / sqrt((double)n));
+    }
+    if (worst > 1e-5) {
+      log_message(LOG_LEVEL_ERROR, "FFT of size %zu deviates from the DFT by %g", n, worst);
+      failures++;
+    }
+
+    memcpy(back, x, n * sizeof(float));
+    fft_forward_inplace(plan, back);
+    if (max_abs_diff(back, spec, n) != 0.0f) {
+      log_message(LOG_LEVEL_ERROR, "in-place FFT of size %zu differs from out-of-place", n);
+      failures++;
+    }
+    fft_inverse(plan, spec, back);
+    fft_inverse_inplace(plan, spec);
+    for (size_t i = 0; i < n; i++) {
+      back[i] /= (float)n;
+      spec[i] /= (float)n;
+    }
+    if (max_abs_diff(back, x, n) > 1e-6f || max_abs_diff(spec, x, n) > 1e-6f) {
+      log_message(LOG_LEVEL_ERROR, "FFT round trip of size %zu does not return the input", n);
+      failures++;
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "FFT test: %d failures", failures);
+  return failures;
+}
+
+// partitioned convolution against a direct-form reference, fed in block sizes that never line up
+// with the partition size
+int test_convolver_matches_direct() {
+  enum { TAPS = 700, N = 4000, BLOCK = 32 };
+  static float taps[TAPS];
+  static float in[N];
+  static float ref[N];
+  static float out[N];
+  const size_t chunks[] = { 1, 31, 32, 100, 7, 257 };
+  NoiseGen gen;
+  ConvolverIR ir;
+  Convolver conv;
+  int failures = 0;
+
+  noise_seed(&gen, 99);
+  white_noise(&gen, taps, TAPS);
+  for (size_t i = 0; i < TAPS; i++) {
+    taps[i] *= expf(-(float)i / 200.0f);
+  }
+  white_noise(&gen, in, N);
+  for (size_t n = 0; n < N; n++) {
+    double acc = 0.0;
+    for (size_t k = 0; k < TAPS && k <= n; k++) {
+      acc += (double)taps[k] * in[n - k];
+    }
+    ref[n] = (float)acc;
+  }
+
+  if (convolver_ir_init(&ir, taps, TAPS, BLOCK) != 0 || convolver_init(&conv, BLOCK, ir.numPartitions) != 0) {
+    return 1;
+  }
+  convolver_set_ir(&conv, &ir);
+  memcpy(out, in, sizeof(in));
+  for (size_t done = 0, c = 0; done < N; c++) {
+    size_t n = chunks[c % 6] < N - done ? chunks[c % 6] : N - done;
+    convolver_process(&conv, out + done, out + done, n);
+    done += n;
+  }
+  float err = max_abs_diff(out, ref, N);
+  if (err > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "partitioned convolution deviates from direct form by %g", err);
+    failures++;
+  }
+  convolver_free(&conv);
+  convolver_ir_free(&ir);
+
+  log_message(LOG_LEVEL_INFO, "Convolver test: %d failures", failures);
+  return failures;
+}
+
+int test_fdn_reverb_decay() {
+  enum { N = 48000 * 2, SEG = N / 4 };
+  static float ir[N];
+  const float rooms[] = { 0.2f, 0.8f };
+  double tail[2];
+  FDNReverb fdn;
+  int failures = 0;
+
+  if (fdn_init(&fdn, 48000.0f) != 0) {
+    return 1;
+  }
+  const float* buffer = fdn.buffer;
+  for (size_t r = 0; r < 2; r++) {
+    fdn_set_params(&fdn, rooms[r], 0.3f);
+    fdn_reset(&fdn);
+    if (fdn.buffer != buffer) {
+      log_message(LOG_LEVEL_ERROR, "FDN reallocated on a parameter change");
+      failures++;
+    }
+    memset(ir, 0, sizeof(ir));
+    ir[0] = 1.0f;
+    fdn_process(&fdn, ir, ir, N);
+
+    double prev = INFINITY;
+    for (size_t s = 0; s < 4; s++) {
+      double energy = 0.0;
+      for (size_t i = s * SEG; i < (s + 1) * SEG; i++) {
+        energy += (double)ir[i] * ir[i];
+      }
+      if (!isfinite(energy) || energy >= prev) {
+        log_message(LOG_LEVEL_ERROR, "FDN tail does not decay (room %g, segment %zu: %g)", rooms[r], s, energy);
+        failures++;
+      }
+      prev = energy;
+    }
+    tail[r] = prev;
+  }
+  // a bigger room rings longer
+  if (!(tail[1] > tail[0] * 100.0)) {
+    log_message(LOG_LEVEL_ERROR, "FDN decay does not grow with room size (%g vs %g)", tail[0], tail[1]);
+    failures++;
+  }
+  fdn_free(&fdn);
+
+  log_message(LOG_LEVEL_INFO, "FDN reverb test: %d failures", failures);
+  return failures;
+}
+
+int test_long_convolver_matches_direct() {
+  enum { TAPS = 50000, N = 60000 };
+  // sparse, so the direct reference stays cheap, with taps on either side of every stage boundary
+  const size_t positions[] = { 0, 5, 63, 64, 1000, 4095, 4096, 4100, 5119, 5120, 20000, 32767, 32768, 40000, 40961, 49999 };
+  const size_t numPositions = sizeof(positions) / sizeof(positions[0]);
+  const size_t chunks[] = { 1, 100, 37, 256, 1500, 64, 999 };
+  static float taps[TAPS];
+  static float in[N];
+  static float ref[N];
+  static float out[N];
+  float weights[sizeof(positions) / sizeof(positions[0])];
+  NoiseGen gen;
+  LongConvolver lc;
+  int failures = 0;
+
+  noise_seed(&gen, 7);
+  white_noise(&gen, weights, numPositions);
+  white_noise(&gen, in, N);
+  memset(taps, 0, sizeof(taps));
+  for (size_t k = 0; k < numPositions; k++) {
+    taps[positions[k]] = weights[k];
+  }
+  for (size_t n = 0; n < N; n++) {
+    double acc = 0.0;
+    for (size_t k = 0; k < numPositions && positions[k] <= n; k++) {
+      acc += (double)weights[k] * in[n - positions[k]];
+    }
+    ref[n] = (float)acc;
+  }
+
+  if (long_convolver_init(&lc, taps, TAPS) != 0) {
+    return 1;
+  }
+  if (lc.numStages != 2) {
+    log_message(LOG_LEVEL_ERROR, "expected 2 worker stages for %d taps, got %zu", TAPS, lc.numStages);
+    failures++;
+  }
+  memcpy(out, in, sizeof(in));
+  // every chunk is shorter than the smallest worker stage's slack, so syncing between calls stands
+  // in for workers that keep up
+  for (size_t done = 0, c = 0; done < N; c++) {
+    size_t n = chunks[c % 7] < N - done ? chunks[c % 7] : N - done;
+    long_convolver_process(&lc, out + done, out + done, n);
+    long_convolver_sync(&lc);
+    done += n;
+  }
+  float err = max_abs_diff(out, ref, N);
+  if (err > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "non-uniform convolution deviates from direct form by %g", err);
+    failures++;
+  }
+  if (long_convolver_misses(&lc) != 0) {
+    log_message(LOG_LEVEL_ERROR, "%zu samples missed their deadline", long_convolver_misses(&lc));
+    failures++;
+  }
+  long_convolver_free(&lc);
+
+  log_message(LOG_LEVEL_INFO, "Long convolver test: %d failures", failures);
+  return failures;
+}
+
+int test_pitch_shifter_tiers() {
+  enum { N = 24000, TAIL = 8192, BLOCK = 64 };
+  static float x[N];
+  static float y[N];
+  const float ratio = 1.4983f;  // a fifth up
+  GrainShifter gs;
+  PhaseVocoder pv;
+  int failures = 0;
+
+  if (grain_shifter_init(&gs, 48000.0f) != 0 || phase_vocoder_init(&pv, 2048, 48000.0f) != 0) {
+    return 1;
+  }
+  grain_shifter_set_ratio(&gs, ratio);
+  phase_vocoder_set_params(&pv, ratio, 0.0f);
+  for (size_t tier = 0; tier < 2; tier++) {
+    for (size_t i = 0; i < N; i++) {
+      x[i] = 0.5f * sinf(2.0f * (float)M_PI * 220.0f * (float)i / 48000.0f);
+    }
+    for (size_t i = 0; i < N; i += BLOCK) {
+      if (tier) {
+        phase_vocoder_process(&pv, x + i, y + i, BLOCK);
+      } else {
+        grain_shifter_process(&gs, x + i, y + i, BLOCK);
+      }
+    }
+    double shifted = tone_power(y + N - TAIL, TAIL, 220.0 * ratio, 48000.0);
+    double original = tone_power(y + N - TAIL, TAIL, 220.0, 48000.0);
+    double input = tone_power(x + N - TAIL, TAIL, 220.0, 48000.0);
+    // short grains leave some of the original pitch in the sidebands
+    if (!(shifted > (tier ? 100.0 : 10.0) * original) || !(shifted > 0.5 * input)) {
+      log_message(LOG_LEVEL_ERROR, "pitch shifter tier %zu: shifted tone %g, original %g, input %g", tier, shifted, original, input);
+      failures++;
+    }
+  }
+
+  // at unity the granular tier is a plain delay; its centre of mass sets the latency
+  grain_shifter_reset(&gs);
+  grain_shifter_set_ratio(&gs, 1.0f);
+  memset(x, 0, sizeof(x));
+  x[1000] = 1.0f;
+  grain_shifter_process(&gs, x, y, 2000);
+  double mass = 0.0;
+  double moment = 0.0;
+  for (size_t i = 1000; i < 2000; i++) {
+    mass += fabsf(y[i]);
+    moment += fabsf(y[i]) * (double)(i - 1000);
+  }
+  if (!(mass > 0.5) || moment / mass > 0.005 * 48000.0) {
+    log_message(LOG_LEVEL_ERROR, "granular latency %g samples (mass %g) exceeds 5 ms", moment / mass, mass);
+    failures++;
+  }
+  grain_shifter_free(&gs);
+  phase_vocoder_free(&pv);
+
+  log_message(LOG_LEVEL_INFO, "Pitch shifter test: %d failures", failures);
+  return failures;
+}
+
+int test_looper_transport_and_persistence() {
+  enum { LOOP = 1000, BLOCK = 96 };
+  static float in[4 * LOOP];
+  static float out[4 * LOOP];
+  char path[] = "/tmp/looper_test_XXXXXX";
+  NoiseGen gen;
+  Looper lp;
+  int failures = 0;
+
+  int fd = mkstemp(path);
+  if (fd < 0) {
+    return 1;
+  }
+  close(fd);
+  noise_seed(&gen, 17);
+  white_noise(&gen, in, 4 * LOOP);
+
+  if (looper_init(&lp, 48000, 48000.0f, path) != 0) {
+    unlink(path);
+    return 1;
+  }
+  // a fixed-length recording closes itself and plays back on the next pass
+  looper_request(&lp, LOOPER_MODE_RECORD);
+  for (size_t i = 0; i < 2 * LOOP; i += BLOCK) {
+    size_t n = 2 * LOOP - i < BLOCK ? 2 * LOOP - i : BLOCK;
+    looper_process(&lp, in + i, out + i, n, LOOP, 1.0f, 1.0f);
+  }
+  float err = 0.0f;
+  for (size_t i = 0; i < LOOP; i++) {
+    err = fmaxf(err, fabsf(out[i] - in[i]));
+    err = fmaxf(err, fabsf(out[LOOP + i] - (in[LOOP + i] + in[i])));
+  }
+  if (lp.length != LOOP || looper_get_mode(&lp) != LOOPER_MODE_PLAY || err > 1e-6f) {
+    log_message(LOG_LEVEL_ERROR, "looper record/play: length %zu, mode %d, error %g", lp.length, (int)looper_get_mode(&lp), err);
+    failures++;
+  }
+
+  // one pass of overdub: loop = 0.5 * loop + 0.25 * input
+  looper_request(&lp, LOOPER_MODE_OVERDUB);
+  looper_process(&lp, in + 2 * LOOP, out, LOOP, LOOP, 0.5f, 0.25f);
+  looper_request(&lp, LOOPER_MODE_IDLE);
+  looper_process(&lp, in, out, BLOCK, LOOP, 1.0f, 1.0f);
+  looper_free(&lp);
+
+  // shortening the length under a running recording cuts the loop at the new length
+  Looper shortened;
+  if (looper_init(&shortened, 48000, 48000.0f, NULL) != 0) {
+    unlink(path);
+    return failures + 1;
+  }
+  looper_request(&shortened, LOOPER_MODE_RECORD);
+  looper_process(&shortened, in, out, LOOP, 2 * LOOP, 1.0f, 1.0f);
+  looper_process(&shortened, in + LOOP, out, BLOCK, LOOP / 2, 1.0f, 1.0f);
+  if (shortened.length != LOOP / 2 || looper_get_mode(&shortened) != LOOPER_MODE_PLAY) {
+    log_message(LOG_LEVEL_ERROR, "looper shortened recording: length %zu, mode %d", shortened.length, (int)looper_get_mode(&shortened));
+    failures++;
+  }
+  looper_free(&shortened);
+
+  // reopening the file brings the loop back
+  if (looper_init(&lp, 48000, 48000.0f, path) != 0) {
+    unlink(path);
+    return failures + 1;
+  }
+  err = 0.0f;
+  for (size_t i = 0; i < LOOP; i++) {
+    err = fmaxf(err, fabsf(lp.loop[i] - (0.5f * in[i] + 0.25f * in[2 * LOOP + i])));
+  }
+  if (lp.length != LOOP || err > 1e-6f) {
+    log_message(LOG_LEVEL_ERROR, "looper file not restored: length %zu, error %g", lp.length, err);
+    failures++;
+  }
+  looper_free(&lp);
+  unlink(path);
+
+  log_message(LOG_LEVEL_INFO, "Looper test: %d failures", failures);
+  return failures;
+}
+
+int test_limiter_lookahead() {
+  enum { N = 9600, BURST = 4800, BLOCK = 100 };
+  static float x[N];
+  static float y[N];
+  const float ceiling = db_to_linear(-6.0f);
+  Limiter lim;
+  int failures = 0;
+
+  if (limiter_init(&lim, 48000.0f) != 0) {
+    return 1;
+  }
+  // quiet tone, then a burst well over the threshold for a quarter of the signal
+  for (size_t i = 0; i < N; i++) {
+    float amp = (i >= BURST && i < BURST + N / 4) ? 2.0f : 0.1f;
+    x[i] = amp * sinf(2.0f * (float)M_PI * 440.0f * (float)i / 48000.0f);
+  }
+  limiter_set_params(&lim, -6.0f, 1000.0f, 5.0f, 20.0f, 0);
+  const size_t latency = limiter_latency(&lim);
+  for (size_t i = 0; i < N; i += BLOCK) {
+    limiter_process(&lim, x + i, y + i, BLOCK);
+  }
+  float peak = 0.0f;
+  float quietErr = 0.0f;
+  for (size_t i = 0; i < N; i++) {
+    peak = fmaxf(peak, fabsf(y[i]));
+    if (i >= latency && i < BURST) {
+      quietErr = fmaxf(quietErr, fabsf(y[i] - x[i - latency]));
+    }
+  }
+  // the gain is already down when the burst comes out of the lookahead, and came down smoothly:
+  // at the burst's first peak the limiter needs no clipping
+  float ratioAtPeak = 1.0f;
+  for (size_t i = BURST; i < BURST + 48000 / 440; i++) {
+    if (fabsf(x[i]) > 1.9f) {
+      ratioAtPeak = fabsf(y[i + latency]) / fabsf(x[i]);
+      break;
+    }
+  }
+  if (latency != 240 || peak > ceiling + 1e-6f || quietErr > 1e-6f || ratioAtPeak * 2.0f > ceiling * 1.01f || ratioAtPeak * 2.0f < ceiling * 0.9f) {
+    log_message(LOG_LEVEL_ERROR, "limiter: latency %zu, peak %g, quiet error %g, burst peak %g", latency, peak, quietErr, ratioAtPeak * 2.0f);
+    failures++;
+  }
+
+  // a tone at fs / 4 sampled 45 degrees off its peaks: samples at 0.707, true peak 1
+  for (size_t i = 0; i < N; i++) {
+    x[i] = sinf(0.5f * (float)M_PI * (float)i + 0.25f * (float)M_PI);
+  }
+  for (int truePeak = 0; truePeak < 2; truePeak++) {
+    limiter_set_params(&lim, -3.0f, 1000.0f, 2.0f, 50.0f, truePeak);
+    limiter_process(&lim, x, y, N);
+    float tail = 0.0f;
+    for (size_t i = N / 2; i < N; i++) {
+      tail = fmaxf(tail, fabsf(y[i]));
+    }
+    float expected = truePeak ? 0.7071f * db_to_linear(-3.0f) : 0.7071f;
+    if (fabsf(tail - expected) > 0.02f) {
+      log_message(LOG_LEVEL_ERROR, "limiter true peak %d: output peak %g, expected %g", truePeak, tail, expected);
+      failures++;
+    }
+  }
+  limiter_free(&lim);
+
+  log_message(LOG_LEVEL_INFO, "Limiter test: %d failures", failures);
+  return failures;
+}
+
+int test_compressor_static_curve() {
+  enum { N = 24000, BLOCK = 96 };
+  static float x[N];
+  static float y[N];
+  float level[64];
+  float reduction[64];
+  int failures = 0;
+
+  // knee: nothing below, the hard-knee line above, a continuous bend between
+  for (int i = 0; i < 64; i++) {
+    level[i] = -40.0f + 0.5f * (float)i;
+  }
+  compute_gain_reduction_db_soft(level, -20.0f, 4.0f, 6.0f, reduction, 64);
+  float curveErr = 0.0f;
+  for (int i = 0; i < 64; i++) {
+    float d = level[i] + 20.0f;
+    float expected = d <= -3.0f ? 0.0f : d >= 3.0f ? -0.75f * d : -0.75f * (d + 3.0f) * (d + 3.0f) / 12.0f;
+    curveErr = fmaxf(curveErr, fabsf(reduction[i] - expected));
+  }
+  float dbErr = 0.0f;
+  for (int i = 0; i < 64; i++) {
+    level[i] = 1e-5f * powf(1.3f, (float)i);
+  }
+  linear_to_db_block(level, reduction, 64);
+  for (int i = 0; i < 64; i++) {
+    dbErr = fmaxf(dbErr, fabsf(reduction[i] - 20.0f * log10f(level[i])));
+  }
+  db_to_linear_block(reduction, reduction, 64);
+  for (int i = 0; i < 64; i++) {
+    dbErr = fmaxf(dbErr, fabsf(reduction[i] / level[i] - 1.0f));
+  }
+  if (curveErr > 1e-5f || dbErr > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "compressor curve error %g, dB conversion error %g", curveErr, dbErr);
+    failures++;
+  }
+
+  // a steady tone 14 dB over a -20 dB threshold at 4:1 comes out 3.5 dB over, per-sample gain
+  // and decimated alike
+  for (size_t i = 0; i < N; i++) {
+    x[i] = 0.5f * sinf(2.0f * (float)M_PI * 1000.0f * (float)i / 48000.0f);
+  }
+  for (size_t interval = 1; interval <= 16; interval *= 16) {
+    Compressor comp;
+    compressor_init(&comp, 48000.0f, 0);
+    compressor_set_control_rate(&comp, interval);
+    compressor_set_params(&comp, -20.0f, 4.0f, 0.0f, 5.0f, 50.0f, 0.0f);
+    for (size_t i = 0; i < N; i += BLOCK) {
+      compressor_process(&comp, x + i, y + i, BLOCK);
+    }
+    float peak = 0.0f;
+    for (size_t i = N / 2; i < N; i++) {
+      peak = fmaxf(peak, fabsf(y[i]));
+    }
+    float outDb = linear_to_db(peak);
+    if (fabsf(outDb - (-16.5f)) > 0.3f) {
+      log_message(LOG_LEVEL_ERROR, "compressor interval %zu: output %g dB, expected -16.5", interval, outDb);
+      failures++;
+    }
+  }
+
+  log_message(LOG_LEVEL_INFO, "Compressor test: %d failures", failures);
+  return failures;
+}
+
+int test_noise_gate_hysteresis() {
+  enum { N = 48000, TONE = 9600, BLOCK = 100 };
+  static float x[N];
+  static float key[N];
+  static float y[N];
+  NoiseGate gate;
+  int failures = 0;
+
+  // tone, then the key sits inside the hysteresis band, then drops well under it; the gated
+  // signal is a constant-magnitude square so gain can be read straight off it
+  for (size_t i = 0; i < N; i++) {
+    float level = i < TONE ? 0.5f : i < 2 * TONE ? db_to_linear(-43.0f) : db_to_linear(-70.0f);
+    key[i] = level * sinf(2.0f * (float)M_PI * 1000.0f * (float)i / 48000.0f);
+    x[i] = (i & 1) ? 0.01f : -0.01f;
+  }
+  noise_gate_init(&gate, 48000.0f);
+  noise_gate_set_params(&gate, -40.0f, 6.0f, 1.0f, 50.0f, 20.0f, -80.0f);
+  for (size_t i = 0; i < N; i += BLOCK) {
+    noise_gate_process(&gate, x + i, key + i, y + i, BLOCK);
+  }
+  // open: untouched, bit for bit
+  float openErr = 0.0f;
+  for (size_t i = 0; i < 2 * TONE; i++) {
+    openErr = fmaxf(openErr, fabsf(y[i] - x[i]));
+  }
+  // closed: down by the range once hold and release are over
+  float closed = 0.0f;
+  for (size_t i = 4 * TONE; i < N; i++) {
+    closed = fmaxf(closed, fabsf(y[i]) / 0.01f);
+  }
+  if (openErr != 0.0f || closed > db_to_linear(-79.0f)) {
+    log_message(LOG_LEVEL_ERROR, "noise gate: open error %g, closed gain %g", openErr, closed);
+    failures++;
+  }
+
+  // from closed, the same in-band key must not open it
+  noise_gate_reset(&gate);
+  noise_gate_process(&gate, x + 2 * TONE, key + 2 * TONE, y, N - 2 * TONE);
+  noise_gate_process(&gate, x + TONE, key + TONE, y, TONE);
+  float leak = 0.0f;
+  for (size_t i = 0; i < TONE; i++) {
+    leak = fmaxf(leak, fabsf(y[i]) / 0.01f);
+  }
+  if (leak > db_to_linear(-79.0f)) {
+    log_message(LOG_LEVEL_ERROR, "noise gate opened inside the hysteresis band: gain %g", leak);
+    failures++;
+  }
+
+  log_message(LOG_LEVEL_INFO, "Noise gate test: %d failures", failures);
+  return failures;
+}
+
+// Koren triode plate voltage on a 300 V / Rp load line, in double, for checking the tables
+static double koren_triode_plate(const TubeParams* p, double vg) {
+  double lo = 0.0;
+  double hi = 300.0;
+  for (int i = 0; i < 60; i++) {
+    double vp = 0.5 * (lo + hi);
+    double e1 = vp / p->k * log1p(exp(p->k * (1.0 / p->mu + vg / sqrt(300.0 + vp * vp))));
+    double ip = 2.0 * pow(e1, p->a) / p->Kg1;
+    if (vp + p->Rp * ip > 300.0) hi = vp; else lo = vp;
+  }
+  return 0.5 * (lo + hi);
+}
+
+int test_tube_tables() {
+  enum { SIZE = 1001 };
+  static float table[SIZE];
+  const TubeParams ax7 = { 100.0f, 600.0f, 1.4f, 1060.0f, 100000.0f, -1.5f };
+  int failures = 0;
+
+  build_triode_table(table, SIZE, &ax7, -5.0f, 5.0f);
+  const double quiescent = koren_triode_plate(&ax7, -1.5);
+  const double gain = (koren_triode_plate(&ax7, -1.51) - koren_triode_plate(&ax7, -1.49)) / 0.02;
+  float err = 0.0f;
+  int monotonic = 1;
+  for (size_t i = 0; i < SIZE; i++) {
+    double v = -5.0 + 10.0 * (double)i / (SIZE - 1);
+    double expected = (quiescent - koren_triode_plate(&ax7, -1.5 + v)) / gain;
+    err = fmaxf(err, fabsf(table[i] - (float)expected));
+    if (i > 0 && table[i] < table[i - 1]) monotonic = 0;
+  }
+  // slope ~1 through the bias point
+  float slope = (table[SIZE / 2 + 1] - table[SIZE / 2 - 1]) / 0.02f;
+  if (err > 1e-3f || !monotonic || fabsf(slope - 1.0f) > 0.02f) {
+    log_message(LOG_LEVEL_ERROR, "triode table: error %g, monotonic %d, slope at bias %g", err, monotonic, slope);
+    failures++;
+  }
+
+  // same key, same copy; any difference, a different one
+  const float* a = tube_table_acquire(TUBE_TRIODE, &ax7, -5.0f, 5.0f, SIZE);
+  const float* b = tube_table_acquire(TUBE_TRIODE, &ax7, -5.0f, 5.0f, SIZE);
+  const float* c = tube_table_acquire(TUBE_PENTODE, &ax7, -5.0f, 5.0f, SIZE);
+  if (a == NULL || a != b || c == NULL || c == a || memcmp(a, table, sizeof(table)) != 0) {
+    log_message(LOG_LEVEL_ERROR, "tube table cache returned %p, %p, %p", (const void*)a, (const void*)b, (const void*)c);
+    failures++;
+  }
+  tube_table_release(a);
+  tube_table_release(b);
+  tube_table_release(c);
+
+  float ir[100];
+  for (size_t i = 0; i < 100; i++) {
+    ir[i] = expf(-0.05f * (float)i) * ((i & 1) ? 1.0f : -0.5f);
+  }
+  normalize_ir(ir, 100, 0.25f);
+  float energy = 0.0f;
+  for (size_t i = 0; i < 100; i++) {
+    energy += ir[i] * ir[i];
+  }
+  if (fabsf(sqrtf(energy / 100.0f) - 0.25f) > 1e-5f) {
+    log_message(LOG_LEVEL_ERROR, "normalize_ir: rms %g", sqrtf(energy / 100.0f));
+    failures++;
+  }
+
+  log_message(LOG_LEVEL_INFO, "Tube table test: %d failures", failures);
+  return failures;
+}
+
+// fundamental's share of the power in x, by correlation at f over a whole number of periods
+static float harmonic_ratio(const float* x, size_t n, float f) {
+  double c = 0.0, s = 0.0, mean = 0.0, total = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    mean += x[i];
+  }
+  mean /= (double)n;
+  for (size_t i = 0; i < n; i++) {
+    double w = 2.0 * M_PI * f * (double)i / 48000.0;
+    double v = x[i] - mean;
+    c += v * cos(w);
+    s += v * sin(w);
+    total += v * v;
+  }
+  double fundamental = 2.0 * (c * c + s * s) / (double)n;
+  return total > 0.0 ? (float)(1.0 - fundamental / total) : 0.0f;
+}
+
+int test_preamp_channels() {
+  enum { N = 9600, BLOCK = 128, SETTLE = 4800 };
+  static float x[N];
+  int failures = 0;
+
+  // clean at low gain barely bends a sine; the high gain chain squares it off
+  const AmpChannelType channels[2] = { AMP_CHANNEL_CLEAN, AMP_CHANNEL_HIGH_GAIN };
+  const float gains[2] = { 0.3f, 0.8f };
+  float distortion[2];
+  for (size_t c = 0; c < 2; c++) {
+    for (size_t i = 0; i < N; i++) {
+      x[i] = 0.3f * sinf(2.0f * (float)M_PI * 500.0f * (float)i / 48000.0f);
+    }
+    for (size_t i = 0; i < N; i += BLOCK) {
+      apply_preamp_simulation(gains[c], 0.5f, 0.5f, 0.5f, 0.5f, channels[c], x + i, BLOCK);
+    }
+    int finite = 1;
+    double mean = 0.0;
+    for (size_t i = SETTLE; i < N; i++) {
+      finite &= isfinite(x[i]);
+      mean += x[i];
+    }
+    mean /= (double)(N - SETTLE);
+    distortion[c] = harmonic_ratio(x + SETTLE, N - SETTLE, 500.0f);
+    if (!finite || fabs(mean) > 1e-2) {
+      log_message(LOG_LEVEL_ERROR, "preamp channel %d: finite %d, dc %g", (int)channels[c], finite, mean);
+      failures++;
+    }
+  }
+  if (distortion[0] > 0.05f || distortion[1] < 0.1f) {
+    log_message(LOG_LEVEL_ERROR, "preamp harmonic share: clean %g, high gain %g", distortion[0], distortion[1]);
+    failures++;
+  }
+
+  Oversampler os;
+  oversampler_init(&os, 4, 32);
+  if (preamp_get_latency() != (int)oversampler_latency(&os)) {
+    log_message(LOG_LEVEL_ERROR, "preamp latency %d, oversampler %zu", preamp_get_latency(), oversampler_latency(&os));
+    failures++;
+  }
+
+  log_message(LOG_LEVEL_INFO, "Preamp test: %d failures (harmonic share clean %.3f, high gain %.3f)", failures, distortion[0], distortion[1]);
+  return failures;
+}
+
+static float power_amp_peak(PowerAmp* amp, float level, float sag, float bias, size_t n) {
+  enum { BLOCK = 100 };
+  float x[BLOCK];
+  float peak = 0.0f;
+  poweramp_set_controls(amp, 1.0f, sag, 0.0f, 0.0f, bias);
+  poweramp_reset(amp);
+  for (size_t i = 0; i < n; i += BLOCK) {
+    for (size_t k = 0; k < BLOCK; k++) {
+      x[k] = level * sinf(2.0f * (float)M_PI * 200.0f * (float)(i + k) / 48000.0f);
+    }
+    poweramp_process(amp, x, x, BLOCK);
+    // the last tenth, once the supply has settled
+    if (i >= n - n / 10) {
+      for (size_t k = 0; k < BLOCK; k++) {
+        peak = fmaxf(peak, fabsf(x[k]));
+      }
+    }
+  }
+  return peak;
+}
+
+int test_power_amp_sag() {
+  const PowerAmpVoicing el34 = { TUBE_PENTODE, { 11.0f, 60.0f, 1.35f, 650.0f, 2000.0f, -20.5f }, 20.5f, 24.0f, 5.0f, 12.0f, 10.0f, 100.0f };
+  PowerAmp amp;
+  int failures = 0;
+
+  if (poweramp_init(&amp, 48000.0f, 2) != 0 || poweramp_set_voicings(&amp, &el34, 1) != 0) {
+    log_message(LOG_LEVEL_ERROR, "power amp init failed");
+    return 1;
+  }
+  // flat out, a saggy supply clips lower than a stiff one
+  const float stiff = power_amp_peak(&amp, 1.0f, 0.0f, 0.5f, 24000);
+  const float sagging = power_amp_peak(&amp, 1.0f, 1.0f, 0.5f, 24000);
+  if (!(stiff > 0.8f && stiff < 1.2f) || !(sagging < 0.8f * stiff && sagging > 0.4f * stiff)) {
+    log_message(LOG_LEVEL_ERROR, "power amp peak: stiff %g, sagging %g", stiff, sagging);
+    failures++;
+  }
+  // quiet signals sit in the crossover region, which a cold bias widens
+  const float nominal = power_amp_peak(&amp, 0.01f, 0.0f, 0.5f, 9600);
+  const float cold = power_amp_peak(&amp, 0.01f, 0.0f, 0.0f, 9600);
+  if (!(cold < 0.9f * nominal)) {
+    log_message(LOG_LEVEL_ERROR, "power amp small signal: nominal %g, cold %g", nominal, cold);
+    failures++;
+  }
+  // push-pull: silence stays silent whatever the bias
+  float x[256] = { 0.0f };
+  poweramp_set_controls(&amp, 1.0f, 1.0f, 1.0f, 1.0f, 0.0f);
+  poweramp_reset(&amp);
+  poweramp_process(&amp, x, x, 256);
+  float residue = 0.0f;
+  for (size_t i = 0; i < 256; i++) {
+    residue = fmaxf(residue, fabsf(x[i]));
+  }
+  if (residue > 1e-6f) {
+    log_message(LOG_LEVEL_ERROR, "power amp output %g for silence", residue);
+    failures++;
+  }
+  poweramp_free(&amp);
+
+  log_message(LOG_LEVEL_INFO, "Power amp test: %d failures (peak stiff %.3f, sagging %.3f)", failures, stiff, sagging);
+  return failures;
+}
+
+static float tone_stack_gain(ToneStack* ts, float hz, float sampleRate) {
+  enum { N = 9600 };
+  static float x[N];
+  for (size_t i = 0; i < N; i++) {
+    x[i] = sinf(2.0f * (float)M_PI * hz * (float)i / sampleRate);
+  }
+  tone_stack_reset(ts);
+  tone_stack_process(ts, x, x, N);
+  float peak = 0.0f;
+  for (size_t i = N / 2; i < N; i++) {
+    peak = fmaxf(peak, fabsf(x[i]));
+  }
+  return linear_to_db(peak);
+}
+
+int test_tone_stack() {
+  enum { N = 4096 };
+  static float x[N];
+  static float block[N];
+  static float scalar[N];
+  ToneStack ts;
+  int failures = 0;
+
+  // block path against one sample at a time, which never fills a block
+  NoiseGen noise;
+  noise_seed(&noise, 7);
+  white_noise(&noise, x, N);
+  if (tone_stack_init(&ts, TONE_STACK_MARSHALL, 48000.0f) != 0) {
+    log_message(LOG_LEVEL_ERROR, "tone stack init failed");
+    return 1;
+  }
+  tone_stack_set_knobs(&ts, 0.73f, 0.21f, 0.38f);
+  tone_stack_process(&ts, x, block, N);
+  tone_stack_reset(&ts);
+  for (size_t i = 0; i < N; i++) {
+    tone_stack_process(&ts, &x[i], &scalar[i], 1);
+  }
+  float err = 0.0f;
+  for (size_t i = 0; i < N; i++) {
+    err = fmaxf(err, fabsf(block[i] - scalar[i]));
+  }
+  if (err > 1e-5f) {
+    log_message(LOG_LEVEL_ERROR, "tone stack block path off by %g", err);
+    failures++;
+  }
+
+  // the knobs do what they say, and noon peaks near 0 dB
+  tone_stack_set_knobs(&ts, 0.5f, 0.5f, 0.5f);
+  float noonPeak = -100.0f;
+  for (float hz = 50.0f; hz < 10000.0f; hz *= 1.5f) {
+    noonPeak = fmaxf(noonPeak, tone_stack_gain(&ts, hz, 48000.0f));
+  }
+  tone_stack_set_knobs(&ts, 0.5f, 0.5f, 1.0f);
+  float bassUp = tone_stack_gain(&ts, 80.0f, 48000.0f);
+  tone_stack_set_knobs(&ts, 0.5f, 0.5f, 0.0f);
+  float bassDown = tone_stack_gain(&ts, 80.0f, 48000.0f);
+  tone_stack_set_knobs(&ts, 1.0f, 0.5f, 0.5f);
+  float trebleUp = tone_stack_gain(&ts, 6000.0f, 48000.0f);
+  tone_stack_set_knobs(&ts, 0.0f, 0.5f, 0.5f);
+  float trebleDown = tone_stack_gain(&ts, 6000.0f, 48000.0f);
+  if (fabsf(noonPeak) > 1.0f || bassUp - bassDown < 10.0f || trebleUp - trebleDown < 10.0f) {
+    log_message(LOG_LEVEL_ERROR, "tone stack: noon peak %g dB, bass %g..%g dB, treble %g..%g dB", noonPeak, bassDown, bassUp, trebleDown, trebleUp);
+    failures++;
+  }
+  tone_stack_free(&ts);
+
+  // every type stays stable at an oversampled rate, knobs at the corners included
+  const float corners[3] = { 0.0f, 0.55f, 1.0f };
+  for (int type = TONE_STACK_FENDER; type <= TONE_STACK_VOX; type++) {
+    tone_stack_init(&ts, (ToneStackType)type, 192000.0f);
+    for (size_t k = 0; k < 27; k++) {
+      tone_stack_set_knobs(&ts, corners[k / 9], corners[(k / 3) % 3], corners[k % 3]);
+      tone_stack_reset(&ts);
+      memset(x, 0, sizeof(x));
+      x[0] = 1.0f;
+      tone_stack_process(&ts, x, x, N);
+      if (!isfinite(x[N - 1]) || fabsf(x[N - 1]) > 1e-3f) {
+        log_message(LOG_LEVEL_ERROR, "tone stack %d unstable at knobs %zu: tail %g", type, k, x[N - 1]);
+        failures++;
+      }
+    }
+    tone_stack_free(&ts);
+  }
+
+  log_message(LOG_LEVEL_INFO, "Tone stack test: %d failures", failures);
+  return failures;
+}
+
+int test_chorus_voices() {
+  enum { N = 9600, BLOCK = 100 };
+  static float x[N];
+  static float left[N];
+  static float right[N];
+  Chorus chorus;
+  int failures = 0;
+
+  if (chorus_init(&chorus, 48000.0f) != 0) {
+    log_message(LOG_LEVEL_ERROR, "chorus init failed");
+    return 1;
+  }
+  // without modulation every voice is a fixed fractional delay of a slow sine
+  const float w = 2.0f * (float)M_PI * 200.0f / 48000.0f;
+  for (size_t i = 0; i < N; i++) {
+    x[i] = sinf(w * (float)i);
+  }
+  chorus_set_voices(&chorus, 8);
+  chorus_set_params(&chorus, 1.0f, 0.0f, 1.0f, 0.0f);
+  for (size_t i = 0; i < N; i += BLOCK) {
+    chorus_process(&chorus, x + i, left + i, NULL, BLOCK);
+  }
+  float err = 0.0f;
+  for (size_t i = N / 2; i < N; i++) {
+    float expected = 0.0f;
+    for (size_t v = 0; v < 8; v++) {
+      expected += chorus.gainMono[v] * sinf(w * ((float)i - chorus.centre[v]));
+    }
+    err = fmaxf(err, fabsf(left[i] - expected));
+  }
+  if (err > 1e-3f) {
+    log_message(LOG_LEVEL_ERROR, "chorus static delays off by %g", err);
+    failures++;
+  }
+
+  // spread 0 puts every voice in the middle; full spread pulls the sides apart
+  chorus_reset(&chorus);
+  chorus_set_voices(&chorus, 5);
+  chorus_set_params(&chorus, 1.5f, 1.0f, 0.5f, 0.0f);
+  chorus_process(&chorus, x, left, right, N);
+  float centred = 0.0f;
+  for (size_t i = 0; i < N; i++) {
+    centred = fmaxf(centred, fabsf(left[i] - right[i]));
+  }
+  chorus_set_params(&chorus, 1.5f, 1.0f, 0.5f, 1.0f);
+  chorus_process(&chorus, x, left, right, N);
+  float wide = 0.0f;
+  for (size_t i = 0; i < N; i++) {
+    wide = fmaxf(wide, fabsf(left[i] - right[i]));
+  }
+  if (centred > 1e-6f || wide < 0.05f) {
+    log_message(LOG_LEVEL_ERROR, "chorus stereo difference: centred %g, wide %g", centred, wide);
+    failures++;
+  }
+
+  // the LFO phasors stay on the unit circle over a long run
+  for (size_t k = 0; k < 100; k++) {
+    chorus_process(&chorus, x, left, right, N);
+  }
+  float drift = 0.0f;
+  for (size_t v = 0; v < CHORUS_MAX_VOICES; v++) {
+    drift = fmaxf(drift, fabsf(chorus.lfoCos[v] * chorus.lfoCos[v] + chorus.lfoSin[v] * chorus.lfoSin[v] - 1.0f));
+  }
+  if (drift > 1e-4f) {
+    log_message(LOG_LEVEL_ERROR, "chorus LFO magnitude drifted by %g", drift);
+    failures++;
+  }
+  chorus_free(&chorus);
+
+  log_message(LOG_LEVEL_INFO, "Chorus test: %d failures", failures);
+  return failures;
+}
+
 int main() {
   // test_log_message();
   // port_audio_stream_test();
   // printf("SIMD width: %d\n", get_simd_width());
-  return 0;
+  int failures = 0;
+  failures += test_filter_banks_match_scalar();
+  failures += test_block_iir_matches_scalar();
+  failures += test_oversampler_round_trip();
+  failures += test_iir_halfband();
+  failures += test_waveshaper_nonfinite_inputs();
+  failures += test_adaa_clippers();
+  failures += test_fast_math_error_bounds();
+  failures += test_delayline_pow2_matches_legacy();
+  failures += test_delayline_read_modulated();
+  failures += test_lfo_kernels();
+  failures += test_noise_generators();
+  failures += test_fft_matches_dft();
+  failures += test_convolver_matches_direct();
+  failures += test_fdn_reverb_decay();
+  failures += test_long_convolver_matches_direct();
+  failures += test_pitch_shifter_tiers();
+  failures += test_looper_transport_and_persistence();
+  failures += test_limiter_lookahead();
+  failures += test_compressor_static_curve();
+  failures += test_noise_gate_hysteresis();
+  failures += test_tube_tables();
+  failures += test_tone_stack();
+  failures += test_preamp_channels();
+  failures += test_power_amp_sag();
+  failures += test_chorus_voices();
+  return failures ? 1 : 0;
 }
\ No newline at end of file